@@ -45,9 +45,22 @@ CalypAppModuleIf::CalypAppModuleIf( QObject* parent, QAction* action, CalypModul
   for( int i = 0; i < CLP_MODULE_MAX_NUM_FRAMES; i++ )
   {
     m_pcSubWindow[i] = NULL;
+    m_apcPackedFrame[i] = NULL;
   }
 }
 
+/**
+ * Current frame of the i-th window as the module reads it: modules that
+ * walk the planes linearly from [ch][0] get a packed copy
+ */
+CalypFrame* CalypAppModuleIf::getModuleFrame( unsigned int i )
+{
+  CalypFrame* pcFrame = m_pcSubWindow[i]->getCurrFrame();
+  if( pcFrame && !( m_pcModule->m_uiModuleRequirements & CLP_MODULE_USES_STRIDE ) )
+    pcFrame = pcFrame->getPacked( m_apcPackedFrame[i] );
+  return pcFrame;
+}
+
 void CalypAppModuleIf::update()
 {
   if( m_pcDisplaySubWindow )
@@ -120,7 +133,7 @@ void CalypAppModuleIf::run()
   std::vector<CalypFrame*> apcFrameList;
   for( unsigned int i = 0; i < m_pcModule->m_uiNumberOfFrames; i++ )
   {
-    apcFrameList.push_back( m_pcSubWindow[i]->getCurrFrame() );
+    apcFrameList.push_back( getModuleFrame( i ) );
   }
 
   if( m_pcModule->m_iModuleType == CLP_FRAME_PROCESSING_MODULE )
@@ -131,7 +144,7 @@ void CalypAppModuleIf::run()
     }
     else
     {
-      m_pcProcessedFrame = m_pcModule->process( m_pcSubWindow[0]->getCurrFrame() );
+      m_pcProcessedFrame = m_pcModule->process( getModuleFrame( 0 ) );
     }
   }
   else if( m_pcModule->m_iModuleType == CLP_FRAME_MEASUREMENT_MODULE )
@@ -142,7 +155,7 @@ void CalypAppModuleIf::run()
     }
     else
     {
-      m_dMeasurementResult = m_pcModule->measure( m_pcSubWindow[0]->getCurrFrame() );
+      m_dMeasurementResult = m_pcModule->measure( getModuleFrame( 0 ) );
     }
   }
   else
@@ -227,4 +240,9 @@ void CalypAppModuleIf::destroy()
     m_pcModule->Delete();
     m_pcModule = NULL;
   }
+  for( int i = 0; i < CLP_MODULE_MAX_NUM_FRAMES; i++ )
+  {
+    delete m_apcPackedFrame[i];
+    m_apcPackedFrame[i] = NULL;
+  }
 }
@@ -63,6 +63,8 @@ private:
   CalypModuleIf* m_pcModule;
 
   VideoSubWindow* m_pcSubWindow[CLP_MODULE_MAX_NUM_FRAMES];
+  //! Packed copies of the input frames for modules without CLP_MODULE_USES_STRIDE
+  CalypFrame* m_apcPackedFrame[CLP_MODULE_MAX_NUM_FRAMES];
 
   VideoSubWindow* m_pcDisplaySubWindow;
 
@@ -100,6 +102,7 @@ public:
 
   CalypModuleIf* getModule() { return m_pcModule; }
   unsigned int getModuleRequirements() { return m_pcModule->m_uiModuleRequirements; }
+  CalypFrame* getModuleFrame( unsigned int i );
   void update();
   bool apply( bool isPlaying = false, bool disableThreads = false );
   bool isRunning();
@@ -427,13 +427,13 @@ void ModulesHandle::activateModule()
     std::vector<CalypFrame*> apcFrameList;
     for( int i = 0; i < videoSubWindowList.size(); i++ )
     {
-      apcFrameList.push_back( pcCurrAppModuleIf->m_pcSubWindow[i]->getCurrFrame() );
+      apcFrameList.push_back( pcCurrAppModuleIf->getModuleFrame( i ) );
     }
     moduleCreated = pcCurrAppModuleIf->m_pcModule->create( apcFrameList );
   }
   else if( pcCurrAppModuleIf->m_pcModule->m_iModuleAPI == CLP_MODULE_API_1 )
   {
-    pcCurrAppModuleIf->m_pcModule->create( pcCurrAppModuleIf->m_pcSubWindow[0]->getCurrFrame() );
+    pcCurrAppModuleIf->m_pcModule->create( pcCurrAppModuleIf->getModuleFrame( 0 ) );
     moduleCreated = true;
   }
 
@@ -24,6 +24,7 @@
 
 #include "VideoSubWindow.h"
 #include <QScrollArea>
+#include <QSettings>
 #include <QStaticText>
 #include "ConfigureFormatDialog.h"
 #include "ModulesHandle.h"
@@ -283,10 +284,11 @@ void VideoSubWindow::updateWindowOnTimeout()
 
 void VideoSubWindow::loadAll()
 {
-  QApplication::setOverrideCursor( Qt::WaitCursor );
-  m_pCurrStream->loadAll();
+  // Frames around the current one are loaded in background up to the budget
+  QSettings appSettings;
+  std::size_t uiBudgetMB = appSettings.value( "VideoSubWindow/PreloadBudgetMB", 2048 ).toUInt();
+  m_pCurrStream->preload( uiBudgetMB << 20 );
   refreshFrame();
-  QApplication::restoreOverrideCursor();
 }
 
 void VideoSubWindow::refreshSubWindow()
@@ -317,6 +319,8 @@ bool VideoSubWindow::loadFile( QString cFilename, bool bForceDialog )
   if( !m_pCurrStream )
   {
     m_pCurrStream = new CalypStream;
+    m_pCurrStream->setReadAhead( 4 );
+    m_pCurrStream->setCacheBudget( 256 << 20 );
   }
 
   bool bConfig = guessFormat( cFilename, Width, Height, InputFormat, BitsPel, Endianness ) || bForceDialog;
@@ -360,6 +364,8 @@ bool VideoSubWindow::loadFile( CalypFileInfo* streamInfo )
   if( !m_pCurrStream )
   {
     m_pCurrStream = new CalypStream;
+    m_pCurrStream->setReadAhead( 4 );
+    m_pCurrStream->setCacheBudget( 256 << 20 );
   }
 
   if( !m_pCurrStream->open( streamInfo->m_cFilename.toStdString(), streamInfo->m_uiWidth, streamInfo->m_uiHeight,
@@ -721,13 +727,15 @@ bool VideoSubWindow::save( QString filename )
   if( m_cSelectedArea.isValid() )
   {
     saveFrame = new CalypFrame( m_pcCurrFrame, m_cSelectedArea.x(), m_cSelectedArea.y(), m_cSelectedArea.width(),
-                                m_cSelectedArea.height() );
+                                m_cSelectedArea.height(), CalypFrame::REGION_VIEW );
   }
   if( !saveFrame )
   {
     return false;
   }
   iRet = CalypStream::saveFrame( filename.toStdString(), saveFrame );
+  if( saveFrame != m_pcCurrFrame )
+    delete saveFrame;
   QApplication::restoreOverrideCursor();
   return iRet;
 }
@@ -33,6 +33,7 @@ FramePropertiesDock::FramePropertiesDock( QWidget* parent, bool* pbMainPlaySwitc
 {
   // -------------- Variables definition --------------
   m_pcFrame = NULL;
+  m_pcSelectionSource = NULL;
   m_pcSelectedFrame = NULL;
   m_iLastFrameType = -1;
 
@@ -249,10 +250,22 @@ FramePropertiesDock::~FramePropertiesDock()
   // If there is a currently histogram computation when dialog is closed,
   // stop it before the image data are deleted automatically!
   histogramWidget->stopHistogramComputation();
+  releaseSelection();
   if( histogramWidget )
     delete histogramWidget;
 }
 
+/**
+ * The histogram computations must be stopped before
+ */
+void FramePropertiesDock::releaseSelection()
+{
+  delete m_pcSelectedFrame;
+  m_pcSelectedFrame = NULL;
+  delete m_pcSelectionSource;
+  m_pcSelectionSource = NULL;
+}
+
 QSize FramePropertiesDock::sizeHint() const
 {
   QSize currSize = size();
@@ -266,11 +279,8 @@ void FramePropertiesDock::reset()
 {
   m_pcFrame = NULL;
   m_cSelectionArea = QRect();
-  if( m_pcSelectedFrame )
-  {
-    delete m_pcSelectedFrame;
-    m_pcSelectedFrame = NULL;
-  }
+  histogramWidget->stopHistogramComputation();
+  releaseSelection();
 
   m_iLastFrameType = -1;
 
@@ -367,17 +377,15 @@ void FramePropertiesDock::setSelection( const QRect& selectionArea )
       histogramWidget->stopHistogramComputation();
 
       /*
-       * Allocate a new image for the selection
-       * or just copy information
+       * Create a new view for the selection in a copy of the frame
+       * (no samples are copied) or just move the existing one
        */
       if( bSelectionChanged )
       {
-        if( m_pcSelectedFrame )
-        {
-          delete m_pcSelectedFrame;
-        }
-        m_pcSelectedFrame = new CalypFrame( m_pcFrame, selectionArea.x(), selectionArea.y(), selectionArea.width(),
-                                            selectionArea.height() );
+        releaseSelection();
+        m_pcSelectionSource = new CalypFrame( m_pcFrame );
+        m_pcSelectedFrame = new CalypFrame( m_pcSelectionSource, selectionArea.x(), selectionArea.y(), selectionArea.width(),
+                                            selectionArea.height(), CalypFrame::REGION_VIEW );
       }
       updateDataHistogram();
       selectionImageButton->click();
@@ -400,7 +408,18 @@ void FramePropertiesDock::updateDataHistogram()
     {
       if( m_pcSelectedFrame )
       {
-        m_pcSelectedFrame->copyFrom( m_pcFrame, m_cSelectionArea.x(), m_cSelectionArea.y() );
+        // The selection must not change under a running computation
+        histogramWidget->stopHistogramComputation();
+        // Shares the planes of the new frame
+        *m_pcSelectionSource = *m_pcFrame;
+        if( !m_pcSelectedFrame->setViewSource( m_pcSelectionSource, m_cSelectionArea.x(), m_cSelectionArea.y() ) )
+        {
+          // The selection does not fit in the new frame
+          releaseSelection();
+        }
+      }
+      if( m_pcSelectedFrame )
+      {
         fullImageButton->show();
         selectionImageButton->show();
       }
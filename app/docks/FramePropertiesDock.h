@@ -48,7 +48,12 @@ public:
   void stopHistogram();
 
 private:
+  void releaseSelection();
+
   CalypFrame* m_pcFrame;
+  //! Copy of m_pcFrame (copy-on-write), so the selection does not depend on the stream buffers
+  CalypFrame* m_pcSelectionSource;
+  //! View of the selection in m_pcSelectionSource
   CalypFrame* m_pcSelectedFrame;
   int m_iLastFrameType;
 
@@ -42,20 +42,38 @@ class HistogramWorker : public QThread
 private:
   QObject* m_parent;
   CalypFrame* m_pcFrame;
+  unsigned int m_uiGeneration;
 
 public:
   HistogramWorker( QObject* parent )
   {
     m_pcFrame = NULL;
+    m_uiGeneration = 0;
     m_parent = parent;
   }
 
   void setup( CalypFrame* frame )
   {
+    // A running computation would keep the thread from starting again
+    cancel();
     m_pcFrame = frame;
+    // Cancelling after this point stops the computation even before it starts
+    if( m_pcFrame )
+      m_uiGeneration = m_pcFrame->getHistogramGeneration();
     // run();
     start();
   }
+
+  /**
+	 * Stop the computation requested by setup and wait for the thread
+	 */
+  void cancel()
+  {
+    if( isRunning() && m_pcFrame )
+      m_pcFrame->cancelHistogram();
+    wait();
+  }
+
   void run()
   {
     if( m_pcFrame && m_parent )
@@ -68,7 +86,12 @@ public:
 
       eventData->starting = true;
 
-      m_pcFrame->calcHistogram();
+      if( !m_pcFrame->calcHistogram( m_uiGeneration ) )
+      {
+        // Cancelled on purpose, the widget does not wait for it
+        delete eventData;
+        return;
+      }
 
       eventData->starting = false;
       //       eventData->success = m_pcFrame->getHasHistogram();
@@ -208,7 +231,7 @@ HistogramWidget::HistogramWidget( int width, int height, QWidget* parent )
 ////////////////////////////////////////////////////////////////////////////////
 HistogramWidget::~HistogramWidget()
 {
-  d->blinkTimer->stop();
+  stopHistogramComputation();
 
   delete m_imageWorker;
   delete m_selectionWorker;
@@ -366,11 +389,8 @@ void HistogramWidget::setLoadingFailed()
 
 void HistogramWidget::stopHistogramComputation()
 {
-  //  if( m_imageHistogram )
-  //    m_imageHistogram->setRunningFlag( false );
-  //
-  //  if( m_selectionHistogram )
-  //    m_selectionHistogram->setRunningFlag( false );
+  m_imageWorker->cancel();
+  m_selectionWorker->cancel();
 
   d->blinkTimer->stop();
 }
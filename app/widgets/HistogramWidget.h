@@ -86,7 +86,7 @@ public:
 
   ~HistogramWidget();
 
-  /** Stop current histogram computations.*/
+  /** Cancel current histogram computations and wait for them.*/
   void stopHistogramComputation();
 
   /** Update full image histogram data. */
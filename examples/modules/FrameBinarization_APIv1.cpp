@@ -52,13 +52,15 @@ void FrameBinarization_APIv1::create( CalypFrame* frame )
 
 CalypFrame* FrameBinarization_APIv1::process( CalypFrame* frame )
 {
-  const ClpPel* pPelInput = frame->getPelBufferYUV()[0][0];
-  ClpPel* pPelBin = m_pcBinFrame->getPelBufferYUV()[0][0];
   for( unsigned int y = 0; y < frame->getHeight(); y++ )
+  {
+    const ClpPel* pPelInput = frame->getPelBufferYUV()[0][y];
+    ClpPel* pPelBin = m_pcBinFrame->getPelBufferYUV()[0][y];
     for( unsigned int x = 0; x < frame->getWidth(); x++ )
     {
       *pPelBin++ = *pPelInput++ >= m_uiThreshold ? 255 : 0;
     }
+  }
   return m_pcBinFrame;
 }
 
@@ -58,6 +58,30 @@ enum CalypColorSpace
   CLP_COLOR_MAX = 255,     //!< Account for future formats
 };
 
+/**
+ * \enum CalypColorMatrix
+ * \brief List of supported YUV to RGB conversion matrices
+ * \ingroup CalypLibGrp
+ */
+enum CalypColorMatrix
+{
+  CLP_MATRIX_DEFAULT = 0,  //!< Integer approximation of BT.601 (full range) used since the first releases
+  CLP_MATRIX_BT601,        //!< ITU-R BT.601
+  CLP_MATRIX_BT709,        //!< ITU-R BT.709
+  CLP_MATRIX_BT2020,       //!< ITU-R BT.2020 (non-constant luminance)
+};
+
+/**
+ * \enum CalypColorRange
+ * \brief Range of the YUV samples
+ * \ingroup CalypLibGrp
+ */
+enum CalypColorRange
+{
+  CLP_RANGE_FULL = 0,     //!< Samples use the whole range
+  CLP_RANGE_LIMITED = 1,  //!< Studio swing (16-235 for luma and 16-240 for chroma at 8 bits)
+};
+
 /**
  * \enum CalypPixelFormats
  * \brief List of supported pixel formats
@@ -24,12 +24,25 @@
 
 #include "CalypFrame.h"
 
+#include "ColorMatrix.h"
+#include "FrameKernels.h"
+#include "FramePool.h"
+#include "FrameQuality.h"
 #include "LibMemory.h"
 #include "PixelFormats.h"
+#include "ThreadPool.h"
 #include "config.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #ifdef USE_OPENCV
 #include <opencv2/core/core.hpp>
@@ -45,12 +58,30 @@ std::vector<ClpString> CalypFrame::supportedColorSpacesListNames()
   };
 }
 
+std::vector<ClpString> CalypFrame::supportedColorMatrixListNames()
+{
+  return std::vector<ClpString>{
+      "Default",
+      "BT.601",
+      "BT.709",
+      "BT.2020",
+  };
+}
+
+std::vector<ClpString> CalypFrame::supportedColorRangeListNames()
+{
+  return std::vector<ClpString>{
+      "Full",
+      "Limited",
+  };
+}
+
 std::vector<ClpString> CalypFrame::supportedPixelFormatListNames()
 {
   std::vector<ClpString> formatsList;
   for( int i = 0; i < numberOfFormats(); i++ )
   {
-    formatsList.push_back( g_CalypPixFmtDescriptorsMap.at( i ).name );
+    formatsList.push_back( getPixFmtDescriptor( i ).name );
   }
   return formatsList;
 }
@@ -60,27 +91,82 @@ std::vector<ClpString> CalypFrame::supportedPixelFormatListNames( int colorSpace
   std::vector<ClpString> formatsList;
   for( int i = 0; i < numberOfFormats(); i++ )
   {
-    if( g_CalypPixFmtDescriptorsMap.at( i ).colorSpace == colorSpace )
-      formatsList.push_back( g_CalypPixFmtDescriptorsMap.at( i ).name );
+    if( getPixFmtDescriptor( i ).colorSpace == colorSpace )
+      formatsList.push_back( getPixFmtDescriptor( i ).name );
   }
   return formatsList;
 }
 
 int CalypFrame::numberOfFormats()
 {
-  return g_CalypPixFmtDescriptorsMap.size();
+  return CLP_NUMBER_FORMATS;
 }
 
 int CalypFrame::findPixelFormat( const ClpString& name )
 {
   for( int i = 0; i < numberOfFormats(); i++ )
   {
-    if( g_CalypPixFmtDescriptorsMap.at( i ).name == name )
+    if( getPixFmtDescriptor( i ).name == name )
       return i;
   }
   return -1;
 }
 
+
+/**
+ * Extend an area so that it starts and ends on a chroma sample
+ */
+static void alignAreaToChroma( int pelFormat, unsigned int& x, unsigned int& y, unsigned int& width, unsigned int& height )
+{
+  const CalypPixelFormatDescriptor* pcPelFormat = &( getPixFmtDescriptor( pelFormat ) );
+  if( pcPelFormat->log2ChromaWidth )
+  {
+    if( x % ( 1 << pcPelFormat->log2ChromaWidth ) )
+      x--;
+    if( ( x + width ) % ( 1 << pcPelFormat->log2ChromaWidth ) )
+      width++;
+  }
+
+  if( pcPelFormat->log2ChromaHeight )
+  {
+    if( y % ( 1 << pcPelFormat->log2ChromaHeight ) )
+      y--;
+
+    if( ( y + height ) % ( 1 << pcPelFormat->log2ChromaHeight ) )
+      height++;
+  }
+}
+
+/**
+ * Planes and row pointers block, shared by the frames that hold the same
+ * samples until one of them is written (copy-on-write). The last
+ * reference gives it back to the frame pool
+ */
+struct CalypFramePlanes
+{
+  void* pBlock;  //!< Channel pointers, row pointers and samples (ClpPel or ClpByte)
+  unsigned int uiWidth;
+  unsigned int uiHeight;
+  int iPelFormat;
+  unsigned int uiVariant;
+  std::size_t uiBytes;
+
+  ~CalypFramePlanes()
+  {
+    CalypFramePool::global()->release( pBlock, CalypFramePool::PLANES_BUFFER, uiWidth, uiHeight, iPelFormat, uiVariant, uiBytes );
+  }
+};
+
+/**
+ * State of the pel planes of a frame with native 8 bits samples
+ */
+enum PelCopyStates
+{
+  PEL_COPY_STALE = 0,  //!< The byte planes are newer (or there is no copy)
+  PEL_COPY_SYNCED,     //!< Both hold the same samples
+  PEL_COPY_AHEAD,      //!< Handed out for writing, the byte planes are older
+};
+
 struct CalypFramePrivate
 {
 public:
@@ -95,100 +181,981 @@ public:
   int m_iPixelFormat;             //!< Pixel format number (it follows the list of supported pixel formats)
   unsigned int m_uiBitsPel;       //!< Bits per pixel/channel
   unsigned int m_uiHalfPelValue;  //!< Bits per pixel/channel
+  unsigned int m_uiSampleBytes;   //!< Size of the samples in the planes (1 for frames up to 8 bits)
+  const CalypFormatKernels<ClpPel>* m_pcPelKernels;    //!< Kernels of the pixel format
+  const CalypFormatKernels<ClpByte>* m_pcByteKernels;  //!< Same for native 8 bits planes
+  int m_iColorMatrix;             //!< YUV to RGB matrix (follows CalypColorMatrix enum)
+  int m_iColorRange;              //!< Range of the YUV samples (follows CalypColorRange enum)
 
+  /**
+   * Frames up to 8 bits keep native samples in m_pppcBytePel; m_pppcInputPel
+   * is then a copy for the ClpPel API, converted on demand (see PelCopyStates)
+   */
   ClpPel*** m_pppcInputPel;
+  ClpByte*** m_pppcBytePel;
+  std::shared_ptr<CalypFramePlanes> m_pcPlanes;   //!< Block holding the planes (NULL for views)
+  std::unique_ptr<CalypFramePlanes> m_pcPelCopy;  //!< Block holding m_pppcInputPel of 8 bits frames
+  int m_iPelCopyState;                            //!< Follows PelCopyStates enum
+  std::mutex m_cPelCopyMutex;
+  bool m_bIsView;                                 //!< Planes belong to another frame (only the row pointers are ours)
+  CalypFramePrivate* m_pcViewParent;              //!< Frame owning the planes of a view
+  unsigned int m_uiViewX;                         //!< Position of a view in its parent
+  unsigned int m_uiViewY;
+  ClpPel*** m_pppcViewPelSource;                  //!< Pel planes of the parent the pel rows of an 8 bits view point to
+  std::vector<CalypFramePrivate*> m_apcViews;     //!< Views pointing into our planes
+  std::mutex m_cViewsMutex;
+  std::vector<ClpPel**> m_appcViewChannels;
+  std::vector<ClpPel*> m_apcViewRows;
+  std::vector<ClpByte**> m_appcViewByteChannels;
+  std::vector<ClpByte*> m_apcViewByteRows;
+  int m_iLayout;                                          //!< Planes layout (follows CalypFrame::FrameLayouts enum)
+  unsigned int m_auiStride[CALYP_PIXEL_MAX_COMPONENTS];     //!< Samples between two rows of each channel
+  unsigned int m_auiPelStride[CALYP_PIXEL_MAX_COMPONENTS];  //!< Same for m_pppcInputPel
 
   bool m_bHasRGBPel;          //!< Flag indicating that the ARGB buffer was computed
   unsigned char* m_pcARGB32;  //!< Buffer with the ARGB pixels used in Qt libs
 
   /** Histogram control variables **/
   bool m_bHasHistogram;
-  bool m_bHistogramRunning;
+  std::mutex m_cHistogramMutex;             //!< Held while the histogram is computed
+  std::atomic<unsigned int> m_uiHistogramGen;  //!< Bumped by every cancel request
   /** The histogram data.*/
   unsigned int* m_puiHistogram;
   /** If the image is RGB and calcLuma is true, we have 1 more channel */
   unsigned int m_uiHistoChannels;
   /** Numbers of histogram segments depending of image bytes depth*/
   unsigned int m_uiHistoSegments;
+  /** Cumulative count, sum and sum of squares of each histogram channel
+   *  (m_uiHistoSegments + 1 entries per channel, the first one is zero) */
+  std::vector<unsigned long long> m_aullHistoCount;
+  std::vector<unsigned long long> m_aullHistoSum;
+  std::vector<unsigned long long> m_aullHistoSumSq;
+
+  CalypFramePrivate()
+      : m_bInit( false ),
+        m_uiSampleBytes( sizeof( ClpPel ) ),
+        m_pppcInputPel( NULL ),
+        m_pppcBytePel( NULL ),
+        m_iPelCopyState( PEL_COPY_STALE ),
+        m_bIsView( false ),
+        m_pcViewParent( NULL ),
+        m_uiViewX( 0 ),
+        m_uiViewY( 0 ),
+        m_pppcViewPelSource( NULL ),
+        m_iLayout( CalypFrame::PACKED_LAYOUT ),
+        m_pcARGB32( NULL ),
+        m_puiHistogram( NULL )
+  {
+  }
 
   /**
-	 * Common constructor function of a frame
-	 *
-	 * @param width width of the frame
-	 * @param height height of the frame
-	 * @param pel_format pixel format index (always use PixelFormats enum)
-	 *
+	 * Set the format of the frame (everything but the planes)
 	 */
-  void init( unsigned int width, unsigned int height, int pel_format, int bitsPixel )
+  void initFormat( unsigned int width, unsigned int height, int pel_format, int bitsPixel )
   {
     m_bInit = false;
     m_bHasRGBPel = false;
     m_pppcInputPel = NULL;
+    m_pppcBytePel = NULL;
+    m_pcPelCopy.reset();
+    m_iPelCopyState = PEL_COPY_STALE;
     m_pcARGB32 = NULL;
     m_uiWidth = width;
     m_uiHeight = height;
     m_iPixelFormat = pel_format;
     m_uiBitsPel = bitsPixel < 8 ? 8 : bitsPixel;
     m_uiHalfPelValue = 1 << ( m_uiBitsPel - 1 );
+    m_uiSampleBytes = m_uiBitsPel <= 8 ? sizeof( ClpByte ) : sizeof( ClpPel );
+    m_iColorMatrix = CLP_MATRIX_DEFAULT;
+    m_iColorRange = CLP_RANGE_FULL;
 
     if( m_uiWidth == 0 || m_uiHeight == 0 || m_iPixelFormat == -1 || bitsPixel > 16 )
     {
       throw CalypFailure( "CalypFrame", "Cannot create a PlYUVerFrame of this type" );
     }
 
-    m_pcPelFormat = &( g_CalypPixFmtDescriptorsMap.at( pel_format ) );
+    m_pcPelFormat = &( getPixFmtDescriptor( pel_format ) );
+    m_pcPelKernels = &getFormatKernels<ClpPel>( pel_format );
+    m_pcByteKernels = &getFormatKernels<ClpByte>( pel_format );
+
+    /* ARGB and histogram buffers are allocated on first use */
+    m_puiHistogram = NULL;
+    m_bHasHistogram = false;
+    m_uiHistogramGen = 0;
+
+    m_uiHistoSegments = 1 << m_uiBitsPel;
+
+    if( m_pcPelFormat->colorSpace == CLP_COLOR_RGB ||
+        m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
+      m_uiHistoChannels = m_pcPelFormat->numberChannels + 1;
+    else
+      m_uiHistoChannels = m_pcPelFormat->numberChannels;
+
+    m_cPelFmtName = CalypFrame::supportedPixelFormatListNames()[m_iPixelFormat].c_str();
+  }
+
+  /**
+	 * Common constructor function of a frame
+	 *
+	 * @param width width of the frame
+	 * @param height height of the frame
+	 * @param pel_format pixel format index (always use PixelFormats enum)
+	 * @param layout planes layout (use CalypFrame::FrameLayouts enum)
+	 *
+	 */
+  void init( unsigned int width, unsigned int height, int pel_format, int bitsPixel, int layout )
+  {
+    initFormat( width, height, pel_format, bitsPixel );
+    m_iLayout = layout;
+    allocPlanes();
+    setPelStrides();
+    m_bInit = true;
+  }
+
+  /**
+	 * Constructor function of a frame sharing the planes of another one
+	 */
+  void initShared( CalypFramePrivate* other )
+  {
+    initFormat( other->m_uiWidth, other->m_uiHeight, other->m_iPixelFormat, other->m_uiBitsPel );
+    sharePlanes( other );
+    m_bInit = true;
+  }
+
+  unsigned int planeWidth( unsigned int ch ) const { return CHROMASHIFT( m_uiWidth, ch > 0 ? m_pcPelFormat->log2ChromaWidth : 0 ); }
+  unsigned int planeHeight( unsigned int ch ) const { return CHROMASHIFT( m_uiHeight, ch > 0 ? m_pcPelFormat->log2ChromaHeight : 0 ); }
+
+  /**
+	 * Row stride of a plane in the current m_iLayout
+	 */
+  unsigned int planeStride( unsigned int ch, unsigned int sampleBytes ) const
+  {
+    return m_iLayout == CalypFrame::ALIGNED_LAYOUT ? alignedStride( planeWidth( ch ), sampleBytes ) : planeWidth( ch );
+  }
+
+  //! Strides of the pel planes that are not shared with another frame
+  void setPelStrides()
+  {
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+      m_auiPelStride[ch] = planeStride( ch, sizeof( ClpPel ) );
+  }
+
+  /**
+	 * Planes of the native sample type (ClpPel or ClpByte)
+	 */
+  template <typename T>
+  T*** planes() const
+  {
+    return (T***)( sizeof( T ) == sizeof( ClpByte ) ? (void*)m_pppcBytePel : (void*)m_pppcInputPel );
+  }
+
+  /**
+	 * Take a planes block for the current format and m_iLayout
+	 * @param sampleBytes size of each sample (ClpPel or ClpByte)
+	 * @param puiStride returns the row stride of each channel in samples
+	 */
+  CalypFramePlanes* allocBlock( unsigned int sampleBytes, unsigned int* puiStride )
+  {
     int iNumberChannels = m_pcPelFormat->numberChannels;
 
-    std::size_t mem_size = 0;
+    /*
+     * Block layout: channel pointers, row pointers and then the planes.
+     * The planes start on a DATA_ALIGN_SIZE boundary; in the aligned layout
+     * every plane and row does and rows are padded (see alignedStride)
+     */
     std::size_t num_of_ptrs = 0;
+    std::size_t planeOffset[CALYP_PIXEL_MAX_COMPONENTS];
+    std::size_t pel_size = 0;
     for( int ch = 0; ch < iNumberChannels; ch++ )
     {
-      int ratioW = ch > 0 ? m_pcPelFormat->log2ChromaWidth : 0;
-      int ratioH = ch > 0 ? m_pcPelFormat->log2ChromaHeight : 0;
+      puiStride[ch] = planeStride( ch, sampleBytes );
       // Add pointers mem
-      num_of_ptrs += CHROMASHIFT( m_uiHeight, ratioH );
+      num_of_ptrs += planeHeight( ch );
       // Add pixel mem
-      mem_size += CHROMASHIFT( m_uiHeight, ratioH ) * CHROMASHIFT( m_uiWidth, ratioW ) * sizeof( ClpPel );
+      if( m_iLayout == CalypFrame::ALIGNED_LAYOUT )
+        pel_size = alignSize( pel_size );
+      planeOffset[ch] = pel_size;
+      pel_size += planeHeight( ch ) * std::size_t( puiStride[ch] ) * sampleBytes;
+    }
+    std::size_t ptr_size = alignSize( num_of_ptrs * sizeof( void* ) + sizeof( void** ) * iNumberChannels );
+
+    // Blocks from the pool keep the row pointers of the same format
+    std::size_t uiPlanesBytes = ptr_size + pel_size;
+    unsigned int uiVariant = ( m_iLayout << 2 ) | sampleBytes;
+    void* pBlock = CalypFramePool::global()->acquire( CalypFramePool::PLANES_BUFFER, m_uiWidth, m_uiHeight, m_iPixelFormat, uiVariant,
+                                                      uiPlanesBytes );
+    if( !pBlock )
+    {
+      throw CalypFailure( "CalypFrame", "Cannot allocate the frame buffer" );
     }
-    mem_size += num_of_ptrs * sizeof( ClpPel* ) + sizeof( ClpPel** ) * iNumberChannels;
+    if( sampleBytes == sizeof( ClpByte ) )
+      setRowPointers<ClpByte>( pBlock, ptr_size, planeOffset, puiStride );
+    else
+      setRowPointers<ClpPel>( pBlock, ptr_size, planeOffset, puiStride );
+    return new CalypFramePlanes{ pBlock, m_uiWidth, m_uiHeight, m_iPixelFormat, uiVariant, uiPlanesBytes };
+  }
 
-    m_pppcInputPel = (ClpPel***)xMallocMem( mem_size );
+  template <typename T>
+  void setRowPointers( void* pBlock, std::size_t ptrSize, const std::size_t* planeOffset, const unsigned int* puiStride )
+  {
+    T*** pppcPel = (T***)pBlock;
+    T** pelPtrMem = (T**)( pppcPel + m_pcPelFormat->numberChannels );
+    ClpByte* pelMem = (ClpByte*)pBlock + ptrSize;
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+    {
+      T* pPlane = (T*)( pelMem + planeOffset[ch] );
+      pppcPel[ch] = pelPtrMem;
+      for( unsigned int h = 0; h < planeHeight( ch ); h++ )
+      {
+        *pelPtrMem = pPlane;
+        pelPtrMem++;
+        pPlane += puiStride[ch];
+      }
+    }
+  }
 
-    ClpPel** pelPtrMem = (ClpPel**)( m_pppcInputPel + iNumberChannels );
-    ClpPel* pelMem = (ClpPel*)( pelPtrMem + num_of_ptrs );
-    for( int ch = 0; ch < iNumberChannels; ch++ )
+  /**
+	 * Take a planes block of our own for the current format and m_iLayout
+	 */
+  void allocPlanes()
+  {
+    m_pcPlanes.reset( allocBlock( m_uiSampleBytes, m_auiStride ) );
+    if( m_uiSampleBytes == sizeof( ClpByte ) )
+      m_pppcBytePel = (ClpByte***)m_pcPlanes->pBlock;
+    else
+      m_pppcInputPel = (ClpPel***)m_pcPlanes->pBlock;
+  }
+
+  /**
+	 * Use the planes of another frame of the same format
+	 */
+  void sharePlanes( CalypFramePrivate* other )
+  {
+    other->syncBytePlanes();
+    if( m_iLayout != other->m_iLayout && m_uiSampleBytes == sizeof( ClpByte ) )
+    {
+      // The pel copy follows the layout of the planes
+      std::lock_guard<std::mutex> lock( m_cPelCopyMutex );
+      m_pcPelCopy.reset();
+      m_pppcInputPel = NULL;
+    }
+    m_pcPlanes = other->m_pcPlanes;
+    m_iLayout = other->m_iLayout;
+    if( m_uiSampleBytes == sizeof( ClpByte ) )
+      m_pppcBytePel = other->m_pppcBytePel;
+    else
+      m_pppcInputPel = other->m_pppcInputPel;
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+      m_auiStride[ch] = other->m_auiStride[ch];
+    setPelStrides();
+    refreshViews();
+    samplesChanged();
+  }
+
+  /**
+	 * Called before writing the planes: take a block of our own when the
+	 * current one is shared with other frames
+	 * @param bKeepSamples copy the current samples (false when all of them
+	 * are going to be written)
+	 *
+	 * A view detaches its parent keeping the samples (it only writes an area)
+	 */
+  void detachPlanes( bool bKeepSamples )
+  {
+    if( m_bIsView )
+    {
+      if( m_pcViewParent )
+        m_pcViewParent->detachPlanes( true );
+      return;
+    }
+    if( !m_pcPlanes || m_pcPlanes.use_count() == 1 )
+      return;
+    std::shared_ptr<CalypFramePlanes> pcShared = m_pcPlanes;
+    allocPlanes();
+    if( bKeepSamples )
+    {
+      if( m_uiSampleBytes == sizeof( ClpByte ) )
+        copyBlockRows<ClpByte>( pcShared.get() );
+      else
+        copyBlockRows<ClpPel>( pcShared.get() );
+    }
+    refreshViews();
+  }
+
+  template <typename T>
+  void copyBlockRows( const CalypFramePlanes* pcSrc )
+  {
+    T*** pppcSrc = (T***)pcSrc->pBlock;
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+      for( unsigned int y = 0; y < planeHeight( ch ); y++ )
+        memcpy( planes<T>()[ch][y], pppcSrc[ch][y], planeWidth( ch ) * sizeof( T ) );
+  }
+
+  /**
+	 * Called after the planes were written
+	 */
+  void samplesChanged()
+  {
+    CalypFramePrivate* pcOwner = owner();
+    pcOwner->m_iPelCopyState = PEL_COPY_STALE;
+    pcOwner->derivedChanged();
+  }
+
+  //! Frame holding the planes (the parent of a view)
+  CalypFramePrivate* owner() { return m_bIsView && m_pcViewParent ? m_pcViewParent : this; }
+
+  /**
+	 * The ARGB buffer and histogram of the frame and of its views are outdated
+	 */
+  void derivedChanged()
+  {
+    m_bHasRGBPel = false;
+    m_bHasHistogram = false;
+    std::lock_guard<std::mutex> lock( m_cViewsMutex );
+    for( CalypFramePrivate* pcView : m_apcViews )
+    {
+      pcView->m_bHasRGBPel = false;
+      pcView->m_bHasHistogram = false;
+    }
+  }
+
+  /**
+	 * Bring the pel planes of a frame with native 8 bits samples up to date
+	 * @param bForWriting the caller is going to write them, so they become
+	 * newer than the byte planes
+	 */
+  void syncPelPlanes( bool bForWriting )
+  {
+    if( m_uiSampleBytes != sizeof( ClpByte ) )
+      return;
+    if( m_bIsView )
+    {
+      // Views use the pel copy (and its state) of the parent
+      m_pcViewParent->syncPelPlanes( bForWriting );
+      std::lock_guard<std::mutex> lock( m_cPelCopyMutex );
+      if( m_pppcViewPelSource != m_pcViewParent->m_pppcInputPel )
+        fillViewPelRows();
+      return;
+    }
+    std::lock_guard<std::mutex> lock( m_cPelCopyMutex );
+    if( m_iPelCopyState == PEL_COPY_STALE )
+    {
+      if( !m_pcPelCopy )
+      {
+        m_pcPelCopy.reset( allocBlock( sizeof( ClpPel ), m_auiPelStride ) );
+        m_pppcInputPel = (ClpPel***)m_pcPelCopy->pBlock;
+      }
+      for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+        for( unsigned int y = 0; y < planeHeight( ch ); y++ )
+          widenSamples( m_pppcBytePel[ch][y], m_pppcInputPel[ch][y], planeWidth( ch ) );
+      m_iPelCopyState = PEL_COPY_SYNCED;
+    }
+    if( bForWriting )
+      m_iPelCopyState = PEL_COPY_AHEAD;
+  }
+
+  /**
+	 * Bring the byte planes up to date after the pel planes were handed out
+	 * for writing (samples above 255 are saturated)
+	 */
+  void syncBytePlanes()
+  {
+    if( m_uiSampleBytes != sizeof( ClpByte ) )
+      return;
+    if( m_bIsView )
+    {
+      m_pcViewParent->syncBytePlanes();
+      return;
+    }
+    std::lock_guard<std::mutex> lock( m_cPelCopyMutex );
+    if( m_iPelCopyState != PEL_COPY_AHEAD )
+      return;
+    detachPlanes( false );
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+      for( unsigned int y = 0; y < planeHeight( ch ); y++ )
+        narrowSamples( m_pppcInputPel[ch][y], m_pppcBytePel[ch][y], planeWidth( ch ) );
+    m_iPelCopyState = PEL_COPY_SYNCED;
+  }
+
+  ClpPel*** pelPlanes()
+  {
+    syncPelPlanes( false );
+    return m_pppcInputPel;
+  }
+
+  ClpByte*** bytePlanes()
+  {
+    syncBytePlanes();
+    return m_pppcBytePel;
+  }
+
+  //! The pel copy of a view belongs to the parent
+  void releasePelCopy()
+  {
+    if( m_uiSampleBytes != sizeof( ClpByte ) || m_bIsView )
+      return;
+    syncBytePlanes();
+    {
+      std::lock_guard<std::mutex> lock( m_cPelCopyMutex );
+      m_pcPelCopy.reset();
+      m_pppcInputPel = NULL;
+      m_iPelCopyState = PEL_COPY_STALE;
+    }
+    std::lock_guard<std::mutex> lock( m_cViewsMutex );
+    for( CalypFramePrivate* pcView : m_apcViews )
+    {
+      std::lock_guard<std::mutex> viewLock( pcView->m_cPelCopyMutex );
+      pcView->m_pppcViewPelSource = NULL;
+    }
+  }
+
+  ClpPel getSample( unsigned int ch, unsigned int x, unsigned int y ) const
+  {
+    if( m_bIsView )
+      return m_pcViewParent->getSample( ch, x + viewX( ch ), y + viewY( ch ) );
+    if( m_uiSampleBytes == sizeof( ClpByte ) && m_iPelCopyState != PEL_COPY_AHEAD )
+      return m_pppcBytePel[ch][y][x];
+    return m_pppcInputPel[ch][y][x];
+  }
+
+  //! Writes both copies of the samples that are up to date
+  void setSample( unsigned int ch, unsigned int x, unsigned int y, ClpPel value )
+  {
+    if( m_bIsView )
+    {
+      m_pcViewParent->setSample( ch, x + viewX( ch ), y + viewY( ch ), value );
+      return;
+    }
+    if( m_uiSampleBytes != sizeof( ClpByte ) )
+    {
+      m_pppcInputPel[ch][y][x] = value;
+      return;
+    }
+    if( m_iPelCopyState != PEL_COPY_AHEAD )
+    {
+      value = std::min<ClpPel>( value, 255 );
+      m_pppcBytePel[ch][y][x] = value;
+    }
+    if( m_iPelCopyState != PEL_COPY_STALE )
+      m_pppcInputPel[ch][y][x] = value;
+  }
+
+  /**
+	 * Constructor function of a view: an area of the parent frame
+	 * (already aligned to the chroma subsampling) shared through row pointers
+	 */
+  void initView( CalypFramePrivate* parent, unsigned int x, unsigned int y, unsigned int width, unsigned int height )
+  {
+    // Keep the view inside its parent
+    width = x < parent->m_uiWidth ? std::min( width, parent->m_uiWidth - x ) : 0;
+    height = y < parent->m_uiHeight ? std::min( height, parent->m_uiHeight - y ) : 0;
+    initFormat( width, height, parent->m_iPixelFormat, parent->m_uiBitsPel );
+
+    m_bIsView = true;
+    m_iLayout = parent->m_iLayout;
+    std::size_t num_of_ptrs = 0;
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+      num_of_ptrs += planeHeight( ch );
+    if( m_uiSampleBytes == sizeof( ClpByte ) )
+    {
+      // The pel rows point to the pel copy of the parent once it exists
+      m_appcViewByteChannels.resize( m_pcPelFormat->numberChannels );
+      m_apcViewByteRows.resize( num_of_ptrs );
+      m_pppcBytePel = m_appcViewByteChannels.data();
+    }
+    m_appcViewChannels.resize( m_pcPelFormat->numberChannels );
+    m_apcViewRows.resize( num_of_ptrs );
+    m_pppcInputPel = m_appcViewChannels.data();
+    setViewRows( parent, x, y );
+
+    m_bInit = true;
+  }
+
+  /**
+	 * Move a view to the area at (x, y) of parent
+	 */
+  void setViewRows( CalypFramePrivate* parent, unsigned int x, unsigned int y )
+  {
+    // Views always point into the frame holding the planes
+    if( parent->m_bIsView )
+    {
+      x += parent->m_uiViewX;
+      y += parent->m_uiViewY;
+      parent = parent->m_pcViewParent;
+    }
+    if( parent != m_pcViewParent )
+    {
+      if( m_pcViewParent )
+        m_pcViewParent->removeView( this );
+      parent->addView( this );
+      m_pcViewParent = parent;
+    }
+    m_uiViewX = x;
+    m_uiViewY = y;
+    fillViewPlanes();
+  }
+
+  /**
+	 * Point the rows of a view to the current planes of its parent
+	 */
+  void fillViewPlanes()
+  {
+    if( m_uiSampleBytes == sizeof( ClpByte ) )
+    {
+      fillViewRows( m_pcViewParent->m_pppcBytePel, m_pppcBytePel, m_apcViewByteRows.data() );
+      std::lock_guard<std::mutex> lock( m_cPelCopyMutex );
+      fillViewPelRows();
+    }
+    else
+    {
+      fillViewRows( m_pcViewParent->m_pppcInputPel, m_pppcInputPel, m_apcViewRows.data() );
+      for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+        m_auiPelStride[ch] = m_pcViewParent->m_auiStride[ch];
+    }
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+      m_auiStride[ch] = m_pcViewParent->m_auiStride[ch];
+    m_bHasRGBPel = false;
+    m_bHasHistogram = false;
+  }
+
+  //! Point the pel rows of an 8 bits view to the pel copy of its parent
+  void fillViewPelRows()
+  {
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+      m_auiPelStride[ch] = m_pcViewParent->m_auiPelStride[ch];
+    m_pppcViewPelSource = m_pcViewParent->m_pppcInputPel;
+    if( m_pppcViewPelSource )
+      fillViewRows( m_pppcViewPelSource, m_pppcInputPel, m_apcViewRows.data() );
+  }
+
+  unsigned int viewX( unsigned int ch ) const { return m_uiViewX >> ( ch > 0 ? m_pcPelFormat->log2ChromaWidth : 0 ); }
+  unsigned int viewY( unsigned int ch ) const { return m_uiViewY >> ( ch > 0 ? m_pcPelFormat->log2ChromaHeight : 0 ); }
+
+  template <typename T>
+  void fillViewRows( T*** pppcParent, T*** pppcView, T** pelPtrMem )
+  {
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+    {
+      pppcView[ch] = pelPtrMem;
+      for( unsigned int h = 0; h < planeHeight( ch ); h++ )
+      {
+        *pelPtrMem = pppcParent[ch][viewY( ch ) + h] + viewX( ch );
+        pelPtrMem++;
+      }
+    }
+  }
+
+  void addView( CalypFramePrivate* pcView )
+  {
+    std::lock_guard<std::mutex> lock( m_cViewsMutex );
+    m_apcViews.push_back( pcView );
+  }
+
+  void removeView( CalypFramePrivate* pcView )
+  {
+    std::lock_guard<std::mutex> lock( m_cViewsMutex );
+    m_apcViews.erase( std::remove( m_apcViews.begin(), m_apcViews.end(), pcView ), m_apcViews.end() );
+  }
+
+  /**
+	 * Called after our planes were replaced (copy-on-write or shared from
+	 * another frame): the rows of the views still point to the old ones
+	 */
+  void refreshViews()
+  {
+    std::lock_guard<std::mutex> lock( m_cViewsMutex );
+    for( CalypFramePrivate* pcView : m_apcViews )
+      pcView->fillViewPlanes();
+  }
+
+  /**
+	 * Take over the views of the frame this one replaces (assignment); the
+	 * views that do not fit in the new samples lose their parent
+	 */
+  void adoptViews( CalypFramePrivate* other )
+  {
+    std::vector<CalypFramePrivate*> apcViews;
+    {
+      std::lock_guard<std::mutex> lock( other->m_cViewsMutex );
+      apcViews.swap( other->m_apcViews );
+    }
+    for( CalypFramePrivate* pcView : apcViews )
+    {
+      if( pcView->m_iPixelFormat != m_iPixelFormat || pcView->m_uiBitsPel != m_uiBitsPel ||
+          pcView->m_uiViewX + pcView->m_uiWidth > m_uiWidth || pcView->m_uiViewY + pcView->m_uiHeight > m_uiHeight )
+      {
+        pcView->m_pcViewParent = NULL;
+        continue;
+      }
+      pcView->m_pcViewParent = this;
+      addView( pcView );
+      pcView->fillViewPlanes();
+    }
+  }
+
+  /**
+	 * Set every sample to the middle of the range; the padding samples at
+	 * the end of the rows as well, except for views (the rest of the rows
+	 * belongs to the parent)
+	 */
+  template <typename T>
+  void resetPlanes()
+  {
+    T pelValue = m_uiHalfPelValue;
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+    {
+      if( m_bIsView )
+      {
+        for( unsigned int y = 0; y < planeHeight( ch ); y++ )
+          std::fill( planes<T>()[ch][y], planes<T>()[ch][y] + planeWidth( ch ), pelValue );
+        continue;
+      }
+      T* pPel = planes<T>()[ch][0];
+      std::fill( pPel, pPel + std::size_t( planeHeight( ch ) ) * m_auiStride[ch], pelValue );
+    }
+  }
+
+  /**
+	 * Copy the area at (x, y) of a frame of the same format
+	 */
+  template <typename T>
+  void copyPlanes( const CalypFramePrivate* src, unsigned int x, unsigned int y )
+  {
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
     {
       int ratioW = ch > 0 ? m_pcPelFormat->log2ChromaWidth : 0;
       int ratioH = ch > 0 ? m_pcPelFormat->log2ChromaHeight : 0;
-      m_pppcInputPel[ch] = pelPtrMem;
-      for( unsigned int h = 0; h < CHROMASHIFT( m_uiHeight, ratioH ); h++ )
+      for( unsigned int i = 0; i < planeHeight( ch ); i++ )
       {
-        *pelPtrMem = pelMem;
-        pelPtrMem++;
-        pelMem += CHROMASHIFT( m_uiWidth, ratioW );
+        memcpy( planes<T>()[ch][i], &( src->planes<T>()[ch][( y >> ratioH ) + i][( x >> ratioW )] ), planeWidth( ch ) * sizeof( T ) );
       }
     }
+  }
 
-    /* Alloc ARGB memory */
-    getMem1D( &m_pcARGB32, m_uiHeight * m_uiWidth * 4 );
+  /**
+	 * Store one row shifting the samples by shift bits (see shiftSamples);
+	 * pScratch holds a row of pel samples when both types are not ClpPel
+	 */
+  static void storeRow( const ClpPel* in, ClpPel* out, unsigned int count, int shift, ClpPel maxval, ClpPel* )
+  {
+    if( shift )
+      shiftSamples( in, out, count, shift, maxval );
+    else
+      memcpy( out, in, count * sizeof( ClpPel ) );
+  }
 
-    m_puiHistogram = NULL;
-    m_bHasHistogram = false;
-    m_bHistogramRunning = false;
+  static void storeRow( const ClpByte* in, ClpPel* out, unsigned int count, int shift, ClpPel maxval, ClpPel* )
+  {
+    widenSamples( in, out, count );
+    if( shift )
+      shiftSamples( out, out, count, shift, maxval );
+  }
 
-    m_uiHistoSegments = 1 << m_uiBitsPel;
+  static void storeRow( const ClpPel* in, ClpByte* out, unsigned int count, int shift, ClpPel maxval, ClpPel* pScratch )
+  {
+    if( shift )
+    {
+      shiftSamples( in, pScratch, count, shift, maxval );
+      in = pScratch;
+    }
+    narrowSamples( in, out, count );
+  }
 
-    if( m_pcPelFormat->colorSpace == CLP_COLOR_RGB ||
-        m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
-      m_uiHistoChannels = m_pcPelFormat->numberChannels + 1;
+  static void storeRow( const ClpByte* in, ClpByte* out, unsigned int count, int shift, ClpPel maxval, ClpPel* pScratch )
+  {
+    if( !shift )
+    {
+      memcpy( out, in, count );
+      return;
+    }
+    widenSamples( in, pScratch, count );
+    shiftSamples( pScratch, pScratch, count, shift, maxval );
+    narrowSamples( pScratch, out, count );
+  }
+
+  /**
+	 * Resample a plane of a frame of the same size into the same plane of
+	 * this frame and shift the samples to m_uiBitsPel. Chroma is halved with
+	 * the co-sited [1 2 1] filter horizontally and [1 1] vertically, and
+	 * doubled by linear interpolation (chroma rows sit between luma rows).
+	 * Rows run on the worker pool
+	 * @tparam S sample type of the source planes
+	 * @tparam T sample type of the planes of this frame
+	 */
+  template <typename S, typename T>
+  void resamplePlane( const CalypFramePrivate* src, unsigned int ch )
+  {
+    S** ppSrc = src->planes<S>()[ch];
+    T** ppDst = planes<T>()[ch];
+    unsigned int srcWidth = src->planeWidth( ch );
+    unsigned int srcHeight = src->planeHeight( ch );
+    unsigned int width = planeWidth( ch );
+    unsigned int height = planeHeight( ch );
+    int shift = int( m_uiBitsPel ) - int( src->m_uiBitsPel );
+    ClpPel maxval = ( 1 << m_uiBitsPel ) - 1;
+    CalypThreadPool::global()->parallelFor( height, 16, [=]( unsigned int startRow, unsigned int endRow ) {
+      std::vector<S> aVertical( srcWidth );
+      std::vector<S> aBlend( srcWidth );
+      std::vector<S> aHorizontal( width );
+      std::vector<ClpPel> aScratch( width );
+      for( unsigned int y = startRow; y < endRow; y++ )
+      {
+        const S* pRow = ppSrc[y];
+        if( height < srcHeight )
+        {
+          averageRows( ppSrc[2 * y], ppSrc[std::min( 2 * y + 1, srcHeight - 1 )], aVertical.data(), srcWidth );
+          pRow = aVertical.data();
+        }
+        else if( height > srcHeight )
+        {
+          // 3/4 of the nearest row and 1/4 of the other neighbour
+          unsigned int nearRow = y / 2;
+          unsigned int farRow = y % 2 ? std::min( nearRow + 1, srcHeight - 1 ) : ( nearRow > 0 ? nearRow - 1 : 0 );
+          averageRows( ppSrc[nearRow], ppSrc[farRow], aBlend.data(), srcWidth );
+          averageRows( ppSrc[nearRow], aBlend.data(), aVertical.data(), srcWidth );
+          pRow = aVertical.data();
+        }
+        if( width < srcWidth )
+        {
+          downsampleRow( pRow, aHorizontal.data(), width, srcWidth );
+          pRow = aHorizontal.data();
+        }
+        else if( width > srcWidth )
+        {
+          upsampleRow( pRow, aHorizontal.data(), width, srcWidth );
+          pRow = aHorizontal.data();
+        }
+        storeRow( pRow, ppDst[y], width, shift, maxval, aScratch.data() );
+      }
+    } );
+  }
+
+  template <typename S>
+  void resamplePlane( const CalypFramePrivate* src, unsigned int ch )
+  {
+    if( m_uiSampleBytes == sizeof( ClpByte ) )
+      resamplePlane<S, ClpByte>( src, ch );
     else
-      m_uiHistoChannels = m_pcPelFormat->numberChannels;
+      resamplePlane<S, ClpPel>( src, ch );
+  }
 
-    getMem1D<unsigned int>( &( m_puiHistogram ), m_uiHistoSegments * m_uiHistoChannels );
+  template <typename T>
+  void fillPlane( unsigned int ch, ClpPel value )
+  {
+    for( unsigned int y = 0; y < planeHeight( ch ); y++ )
+      std::fill_n( planes<T>()[ch][y], planeWidth( ch ), T( value ) );
+  }
 
-    m_cPelFmtName = CalypFrame::supportedPixelFormatListNames()[m_iPixelFormat].c_str();
+  /**
+	 * Convert the planes into the ARGB buffer (already allocated)
+	 */
+  template <typename T>
+  void fillArgb( T*** pppInputPel, const CalypFormatKernels<T>* pcKernels )
+  {
+    int shiftBits = m_uiBitsPel - 8;
+    const CalypPixelFormatDescriptor* pcPelFormat = m_pcPelFormat;
+    unsigned int uiWidth = m_uiWidth;
+    unsigned int* pARGB = (unsigned int*)m_pcARGB32;
+    const CalypYuvToRgbLut* pcLut = NULL;
+    if( pcPelFormat->colorSpace == CLP_COLOR_YUV && m_iColorMatrix != CLP_MATRIX_DEFAULT )
+      pcLut = getYuvToRgbLut( m_iColorMatrix, m_iColorRange, m_uiBitsPel );
+
+    // Rows are independent, convert them in bands across the worker pool
+    CalypThreadPool::global()->parallelFor( m_uiHeight, 16, [=]( unsigned int startRow, unsigned int endRow ) {
+      if( !pcLut )
+      {
+        pcKernels->argbRows( pppInputPel, pARGB, uiWidth, startRow, endRow, shiftBits );
+        return;
+      }
+      for( unsigned int y = startRow; y < endRow; y++ )
+      {
+        unsigned int yChroma = y >> pcPelFormat->log2ChromaHeight;
+        yuvToArgbRowLut( pcLut, pppInputPel[CLP_LUMA][y], pppInputPel[CLP_CHROMA_U][yChroma], pppInputPel[CLP_CHROMA_V][yChroma],
+                         pARGB + y * uiWidth, uiWidth, pcPelFormat->log2ChromaWidth );
+      }
+    } );
+  }
 
-    m_bInit = true;
+  /**
+	 * Add the rows of one histogram slot
+	 * @return false if the computation was cancelled (uiGen is no longer current)
+	 */
+  template <typename T>
+  bool accumulateHistogramSlot( T*** pppPlanes, unsigned int slot, unsigned int uiSlots, unsigned int* puiHist, std::vector<T>& aLumaRow,
+                                unsigned int uiGen )
+  {
+    for( unsigned int ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+    {
+      unsigned int uiWidth = planeWidth( ch );
+      unsigned int uiHeight = planeHeight( ch );
+      for( unsigned int y = slot * uiHeight / uiSlots; y < ( slot + 1 ) * uiHeight / uiSlots; y++ )
+      {
+        if( m_uiHistogramGen != uiGen )
+          return false;
+        accumulateHistogram( pppPlanes[ch][y], uiWidth, puiHist + ch * m_uiHistoSegments, m_uiHistoSegments - 1 );
+      }
+    }
+    if( m_uiHistoChannels > m_pcPelFormat->numberChannels )
+    {
+      unsigned int* puiLumaHist = puiHist + ( m_uiHistoChannels - 1 ) * m_uiHistoSegments;
+      for( unsigned int y = slot * m_uiHeight / uiSlots; y < ( slot + 1 ) * m_uiHeight / uiSlots; y++ )
+      {
+        if( m_uiHistogramGen != uiGen )
+          return false;
+        const T* pR = pppPlanes[CLP_COLOR_R][y];
+        const T* pG = pppPlanes[CLP_COLOR_G][y];
+        const T* pB = pppPlanes[CLP_COLOR_B][y];
+        if( m_iColorMatrix == CLP_MATRIX_DEFAULT )
+          rgbToLumaRow( pR, pG, pB, aLumaRow.data(), m_uiWidth );
+        else
+          rgbToLumaRowMatrix( m_iColorMatrix, m_iColorRange, m_uiBitsPel, pR, pG, pB, aLumaRow.data(), m_uiWidth );
+        accumulateHistogram( aLumaRow.data(), m_uiWidth, puiLumaHist, m_uiHistoSegments - 1 );
+      }
+    }
+    return true;
+  }
+
+  /**
+	 * Copy one plane into OpenCV rows of the same sample type
+	 */
+  template <typename T>
+  void planeToMat( T** ppPlane, unsigned char* pCvData, std::size_t cvStep )
+  {
+    for( unsigned int y = 0; y < m_uiHeight; y++ )
+      memcpy( pCvData + y * cvStep, ppPlane[y], m_uiWidth * sizeof( T ) );
+  }
+
+  /**
+	 * Interleave the RGB planes into BGR OpenCV rows of the same sample type
+	 */
+  template <typename T>
+  void bgrToMat( T*** pppPlanes, unsigned char* pCvData, std::size_t cvStep )
+  {
+    for( unsigned int y = 0; y < m_uiHeight; y++ )
+      interleaveSamples( pppPlanes[CLP_COLOR_B][y], pppPlanes[CLP_COLOR_G][y], pppPlanes[CLP_COLOR_R][y],
+                         (T*)( pCvData + y * cvStep ), m_uiWidth );
+  }
+
+  static void convertSamples( const ClpByte* in, ClpByte* out, unsigned long count ) { memcpy( out, in, count ); }
+  static void convertSamples( const ClpPel* in, ClpPel* out, unsigned long count ) { memcpy( out, in, count * sizeof( ClpPel ) ); }
+  static void convertSamples( const ClpByte* in, ClpPel* out, unsigned long count ) { widenSamples( in, out, count ); }
+  static void convertSamples( const ClpPel* in, ClpByte* out, unsigned long count ) { narrowSamples( in, out, count ); }
+
+  /**
+	 * Copy OpenCV rows (BGR or gray) of samples S into the planes; samples
+	 * are converted when the frame keeps another sample type
+	 */
+  template <typename T, typename S>
+  void planesFromMat( T*** pppPlanes, const unsigned char* pCvData, std::size_t cvStep )
+  {
+    bool bColor = m_pcPelFormat->colorSpace != CLP_COLOR_GRAY;
+    std::vector<T> aConverted( std::is_same<T, S>::value || !bColor ? 0 : 3 * m_uiWidth );
+    for( unsigned int y = 0; y < m_uiHeight; y++ )
+    {
+      const S* pCvRow = (const S*)( pCvData + y * cvStep );
+      if( !bColor )
+      {
+        convertSamples( pCvRow, pppPlanes[CLP_LUMA][y], m_uiWidth );
+        continue;
+      }
+      const T* pRow = (const T*)pCvRow;
+      if( !aConverted.empty() )
+      {
+        convertSamples( pCvRow, aConverted.data(), 3 * m_uiWidth );
+        pRow = aConverted.data();
+      }
+      deinterleaveSamples( pRow, pppPlanes[CLP_COLOR_B][y], pppPlanes[CLP_COLOR_G][y], pppPlanes[CLP_COLOR_R][y], m_uiWidth );
+    }
+  }
+
+  static std::size_t alignSize( std::size_t size )
+  {
+    return ( size + DATA_ALIGN_SIZE - 1 ) / DATA_ALIGN_SIZE * DATA_ALIGN_SIZE;
+  }
+
+  /**
+   * Row stride of the aligned layout: a multiple of DATA_ALIGN_SIZE bytes,
+   * one line longer when it is a multiple of 1 KB so that vertically
+   * adjacent samples do not map to the same cache sets
+   */
+  static unsigned int alignedStride( unsigned int width, unsigned int sampleBytes )
+  {
+    const unsigned int uiAlignSamples = DATA_ALIGN_SIZE / sampleBytes;
+    unsigned int uiStride = ( width + uiAlignSamples - 1 ) / uiAlignSamples * uiAlignSamples;
+    if( ( uiStride * sampleBytes ) % 1024 == 0 )
+      uiStride += uiAlignSamples;
+    return uiStride;
+  }
+
+  std::size_t getARGBBytes() const { return std::size_t( m_uiWidth ) * m_uiHeight * 4; }
+  std::size_t getHistogramBytes() const { return std::size_t( m_uiHistoSegments ) * m_uiHistoChannels * sizeof( unsigned int ); }
+
+  bool allocARGB()
+  {
+    if( !m_pcARGB32 )
+      m_pcARGB32 = (unsigned char*)CalypFramePool::global()->acquire( CalypFramePool::ARGB_BUFFER, m_uiWidth, m_uiHeight, -1, 0,
+                                                                      getARGBBytes() );
+    return m_pcARGB32 != NULL;
+  }
+
+  void releaseARGB()
+  {
+    m_bHasRGBPel = false;
+    if( m_pcARGB32 )
+      CalypFramePool::global()->release( m_pcARGB32, CalypFramePool::ARGB_BUFFER, m_uiWidth, m_uiHeight, -1, 0, getARGBBytes() );
+    m_pcARGB32 = NULL;
+  }
+
+  bool allocHistogram()
+  {
+    if( !m_puiHistogram )
+      m_puiHistogram = (unsigned int*)CalypFramePool::global()->acquire( CalypFramePool::HISTOGRAM_BUFFER, 0, 0, -1, 0,
+                                                                         getHistogramBytes() );
+    return m_puiHistogram != NULL;
+  }
+
+  //! Must be called with m_cHistogramMutex held
+  void releaseHistogram()
+  {
+    m_bHasHistogram = false;
+    if( m_puiHistogram )
+      CalypFramePool::global()->release( m_puiHistogram, CalypFramePool::HISTOGRAM_BUFFER, 0, 0, -1, 0, getHistogramBytes() );
+    m_puiHistogram = NULL;
+    std::vector<unsigned long long>().swap( m_aullHistoCount );
+    std::vector<unsigned long long>().swap( m_aullHistoSum );
+    std::vector<unsigned long long>().swap( m_aullHistoSumSq );
+  }
+
+  void calcHistogramStats()
+  {
+    unsigned int uiStride = m_uiHistoSegments + 1;
+    m_aullHistoCount.resize( uiStride * m_uiHistoChannels );
+    m_aullHistoSum.resize( uiStride * m_uiHistoChannels );
+    m_aullHistoSumSq.resize( uiStride * m_uiHistoChannels );
+    for( unsigned int ch = 0; ch < m_uiHistoChannels; ch++ )
+    {
+      const unsigned int* puiHist = m_puiHistogram + ch * m_uiHistoSegments;
+      unsigned long long* pullCount = &m_aullHistoCount[ch * uiStride];
+      unsigned long long* pullSum = &m_aullHistoSum[ch * uiStride];
+      unsigned long long* pullSumSq = &m_aullHistoSumSq[ch * uiStride];
+      pullCount[0] = pullSum[0] = pullSumSq[0] = 0;
+      for( unsigned int i = 0; i < m_uiHistoSegments; i++ )
+      {
+        unsigned long long ullBin = puiHist[i];
+        pullCount[i + 1] = pullCount[i] + ullBin;
+        pullSum[i + 1] = pullSum[i] + ullBin * i;
+        pullSumSq[i + 1] = pullSumSq[i] + ullBin * i * i;
+      }
+    }
+  }
+
+  /**
+   * Sum of the entries [start, end] of a cumulative table
+   */
+  unsigned long long rangeSum( const std::vector<unsigned long long>& table, int channel, unsigned int start, unsigned int end )
+  {
+    const unsigned long long* pullTable = &table[channel * ( m_uiHistoSegments + 1 )];
+    return pullTable[end + 1] - pullTable[start];
   }
 
   int getRealHistogramChannel( int channel )
@@ -234,17 +1201,18 @@ public:
 
   ~CalypFramePrivate()
   {
-    while( m_bHistogramRunning )
-      ;
-    if( m_puiHistogram )
-      freeMem1D( m_puiHistogram );
-    m_bHasHistogram = false;
-
-    if( m_pppcInputPel )
-      xFreeMem( m_pppcInputPel );
-
-    if( m_pcARGB32 )
-      freeMem1D( m_pcARGB32 );
+    // Stop a computation running in another thread and wait for it
+    m_uiHistogramGen++;
+    std::lock_guard<std::mutex> lock( m_cHistogramMutex );
+    releaseHistogram();
+    releaseARGB();
+    if( m_bIsView && m_pcViewParent )
+      m_pcViewParent->removeView( this );
+    // Views left behind must not reach us (they are invalid anyway)
+    std::lock_guard<std::mutex> viewsLock( m_cViewsMutex );
+    for( CalypFramePrivate* pcView : m_apcViews )
+      pcView->m_pcViewParent = NULL;
+    // The planes go back to the pool with their last reference
   }
 };
 
@@ -255,14 +1223,28 @@ public:
 CalypFrame::CalypFrame( unsigned int width, unsigned int height, int pelFormat, int bitsPixel )
     : d( new CalypFramePrivate )
 {
-  d->init( width, height, pelFormat, bitsPixel );
+  d->init( width, height, pelFormat, bitsPixel, PACKED_LAYOUT );
+}
+
+CalypFrame::CalypFrame( unsigned int width, unsigned int height, int pelFormat, int bitsPixel, int layout )
+    : d( new CalypFramePrivate )
+{
+  d->init( width, height, pelFormat, bitsPixel, layout );
 }
 
 CalypFrame::CalypFrame( const CalypFrame& other )
     : d( new CalypFramePrivate )
 {
-  d->init( other.getWidth(), other.getHeight(), other.getPelFormat(), other.getBitsPel() );
-  copyFrom( &other );
+  if( other.isView() )
+  {
+    d->init( other.getWidth(), other.getHeight(), other.getPelFormat(), other.getBitsPel(), other.getLayout() );
+    copyFrom( &other );
+  }
+  else
+  {
+    d->initShared( other.d );
+  }
+  setColorMatrix( other.getColorMatrix(), other.getColorRange() );
 }
 
 CalypFrame::CalypFrame( const CalypFrame* other )
@@ -270,62 +1252,82 @@ CalypFrame::CalypFrame( const CalypFrame* other )
 {
   if( other )
   {
-    d->init( other->getWidth(), other->getHeight(), other->getPelFormat(), other->getBitsPel() );
-    copyFrom( other );
+    if( other->isView() )
+    {
+      d->init( other->getWidth(), other->getHeight(), other->getPelFormat(), other->getBitsPel(), other->getLayout() );
+      copyFrom( other );
+    }
+    else
+    {
+      d->initShared( other->d );
+    }
+    setColorMatrix( other->getColorMatrix(), other->getColorRange() );
   }
 }
 
-CalypFrame::CalypFrame( const CalypFrame& other, unsigned int x, unsigned int y, unsigned int width, unsigned int height )
-    : d( new CalypFramePrivate )
+CalypFrame::CalypFrame( CalypFrame&& other ) noexcept
+    : d( other.d )
 {
-  const CalypPixelFormatDescriptor* pcPelFormat = &( g_CalypPixFmtDescriptorsMap.at( other.getPelFormat() ) );
-  if( pcPelFormat->log2ChromaWidth )
+  other.d = NULL;
+}
+
+CalypFrame& CalypFrame::operator=( const CalypFrame& other )
+{
+  if( this != &other )
   {
-    if( x % ( 1 << pcPelFormat->log2ChromaWidth ) )
-      x--;
-    if( ( x + width ) % ( 1 << pcPelFormat->log2ChromaWidth ) )
-      width++;
+    CalypFrame cCopy( other );
+    std::swap( d, cCopy.d );
+    // A moved-from frame has no private data and hence no views
+    if( cCopy.d )
+      d->adoptViews( cCopy.d );
   }
+  return *this;
+}
 
-  if( pcPelFormat->log2ChromaHeight )
-  {
-    if( y % ( 1 << pcPelFormat->log2ChromaHeight ) )
-      y--;
+CalypFrame& CalypFrame::operator=( CalypFrame&& other ) noexcept
+{
+  std::swap( d, other.d );
+  if( d && other.d )
+    d->adoptViews( other.d );
+  return *this;
+}
 
-    if( ( y + height ) % ( 1 << pcPelFormat->log2ChromaHeight ) )
-      height++;
+CalypFrame::CalypFrame( const CalypFrame& other, unsigned int x, unsigned int y, unsigned int width, unsigned int height, int mode )
+    : d( new CalypFramePrivate )
+{
+  alignAreaToChroma( other.getPelFormat(), x, y, width, height );
+  if( mode == REGION_VIEW )
+  {
+    d->initView( other.d, x, y, width, height );
+    setColorMatrix( other.getColorMatrix(), other.getColorRange() );
+  }
+  else
+  {
+    d->init( width, height, other.getPelFormat(), other.getBitsPel(), other.getLayout() );
+    setColorMatrix( other.getColorMatrix(), other.getColorRange() );
+    copyFrom( other, x, y );
   }
-
-  d->init( width, height, other.getPelFormat(), other.getBitsPel() );
-  copyFrom( other, x, y );
 }
 
-CalypFrame::CalypFrame( const CalypFrame* other, unsigned int posX, unsigned int posY, unsigned int areaWidth, unsigned int areaHeight )
+CalypFrame::CalypFrame( const CalypFrame* other, unsigned int posX, unsigned int posY, unsigned int areaWidth, unsigned int areaHeight,
+                        int mode )
     : d( new CalypFramePrivate )
 {
   if( !other )
     return;
 
-  const CalypPixelFormatDescriptor* pcPelFormat = &( g_CalypPixFmtDescriptorsMap.at( other->getPelFormat() ) );
-  if( pcPelFormat->log2ChromaWidth )
+  alignAreaToChroma( other->getPelFormat(), posX, posY, areaWidth, areaHeight );
+  if( mode == REGION_VIEW )
   {
-    if( posX % ( 1 << pcPelFormat->log2ChromaWidth ) )
-      posX--;
-    if( ( posX + areaWidth ) % ( 1 << pcPelFormat->log2ChromaWidth ) )
-      areaWidth++;
+    d->initView( other->d, posX, posY, areaWidth, areaHeight );
+    setColorMatrix( other->getColorMatrix(), other->getColorRange() );
   }
-
-  if( pcPelFormat->log2ChromaHeight )
+  else
   {
-    if( posY % ( 1 << pcPelFormat->log2ChromaHeight ) )
-      posY--;
-
-    if( ( posY + areaHeight ) % ( 1 << pcPelFormat->log2ChromaHeight ) )
-      areaHeight++;
+    d->init( areaWidth, areaHeight, other->getPelFormat(), other->getBitsPel(), other->getLayout() );
+    setColorMatrix( other->getColorMatrix(), other->getColorRange() );
+    copyFrom( other, posX, posY );
   }
-
-  d->init( areaWidth, areaHeight, other->getPelFormat(), other->getBitsPel() );
-  copyFrom( other, posX, posY );
 }
 
 CalypFrame::~CalypFrame()
@@ -383,9 +1385,62 @@ unsigned int CalypFrame::getWidth( int channel ) const
 {
   return CHROMASHIFT( d->m_uiWidth, channel > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0 );
 }
-unsigned int CalypFrame::getHeight( int channel ) const
+unsigned int CalypFrame::getHeight( int channel ) const
+{
+  return CHROMASHIFT( d->m_uiHeight, channel > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0 );
+}
+
+unsigned int CalypFrame::getStride( int channel ) const
+{
+  return d->m_auiPelStride[channel];
+}
+
+int CalypFrame::getLayout() const
+{
+  return d->m_iLayout;
+}
+
+bool CalypFrame::isPacked() const
+{
+  return d->m_iLayout == PACKED_LAYOUT && !d->m_bIsView;
+}
+
+CalypFrame* CalypFrame::getPacked( CalypFrame*& pcPacked )
+{
+  if( isPacked() )
+    return this;
+  if( pcPacked && ( !pcPacked->isPacked() || !pcPacked->haveSameFmt( this ) ) )
+  {
+    delete pcPacked;
+    pcPacked = NULL;
+  }
+  if( !pcPacked )
+    pcPacked = new CalypFrame( getWidth(), getHeight(), getPelFormat(), getBitsPel(), PACKED_LAYOUT );
+  pcPacked->setColorMatrix( getColorMatrix(), getColorRange() );
+  // Sharing the planes (copyFrom without position) would take our layout
+  pcPacked->copyFrom( this, 0, 0 );
+  return pcPacked;
+}
+
+bool CalypFrame::isView() const
+{
+  return d->m_bIsView;
+}
+
+bool CalypFrame::setViewSource( const CalypFrame* other, unsigned int x, unsigned int y )
 {
-  return CHROMASHIFT( d->m_uiHeight, channel > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0 );
+  if( !d->m_bIsView || other == this || !haveSameFmt( other, MATCH_PEL_FMT | MATCH_BITS ) )
+    return false;
+  x -= x % ( 1 << d->m_pcPelFormat->log2ChromaWidth );
+  y -= y % ( 1 << d->m_pcPelFormat->log2ChromaHeight );
+  if( x + d->m_uiWidth > other->getWidth() || y + d->m_uiHeight > other->getHeight() )
+    return false;
+
+  // Do not let a running histogram mix both areas
+  d->m_uiHistogramGen++;
+  std::lock_guard<std::mutex> lock( d->m_cHistogramMutex );
+  d->setViewRows( other->d, x, y );
+  return true;
 }
 
 unsigned int CalypFrame::getPixels( int channel ) const
@@ -413,6 +1468,32 @@ unsigned int CalypFrame::getBitsPel() const
   return d->m_uiBitsPel;
 }
 
+unsigned int CalypFrame::getSampleBytes() const
+{
+  return d->m_uiSampleBytes;
+}
+
+void CalypFrame::setColorMatrix( int colorMatrix, int colorRange )
+{
+  if( colorMatrix == d->m_iColorMatrix && colorRange == d->m_iColorRange )
+    return;
+  d->m_iColorMatrix = colorMatrix;
+  d->m_iColorRange = colorRange;
+  d->m_bHasRGBPel = false;
+  if( d->m_pcPelFormat->colorSpace == CLP_COLOR_RGB || d->m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
+    d->m_bHasHistogram = false;
+}
+
+int CalypFrame::getColorMatrix() const
+{
+  return d->m_iColorMatrix;
+}
+
+int CalypFrame::getColorRange() const
+{
+  return d->m_iColorRange;
+}
+
 unsigned long CalypFrame::getBytesPerFrame()
 {
   return getBytesPerFrame( d->m_uiWidth, d->m_uiHeight, d->m_iPixelFormat, d->m_uiBitsPel );
@@ -420,7 +1501,7 @@ unsigned long CalypFrame::getBytesPerFrame()
 
 unsigned long CalypFrame::getBytesPerFrame( unsigned int uiWidth, unsigned int uiHeight, int iPixelFormat, unsigned int bitsPixel )
 {
-  const CalypPixelFormatDescriptor* pcPelFormat = &( g_CalypPixFmtDescriptorsMap.at( iPixelFormat ) );
+  const CalypPixelFormatDescriptor* pcPelFormat = &( getPixFmtDescriptor( iPixelFormat ) );
   unsigned int bytesPerPixel = ( bitsPixel - 1 ) / 8 + 1;
   unsigned long long int numberBytes = uiWidth * uiHeight;
   if( pcPelFormat->numberChannels > 1 )
@@ -434,34 +1515,45 @@ unsigned long CalypFrame::getBytesPerFrame( unsigned int uiWidth, unsigned int u
 
 void CalypFrame::reset()
 {
-  ClpPel* pPel;
-  ClpPel pelValue = 1 << ( d->m_uiBitsPel - 1 );
-  int ratioH, ratioW;
-  unsigned int i;
-  for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
-  {
-    ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    pPel = d->m_pppcInputPel[ch][0];
-    for( i = 0; i < CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ); i++ )
-    {
-      *pPel++ = pelValue;
-    }
-  }
+  d->syncBytePlanes();
+  d->detachPlanes( false );
+  if( d->m_uiSampleBytes == sizeof( ClpByte ) )
+    d->resetPlanes<ClpByte>();
+  else
+    d->resetPlanes<ClpPel>();
+  d->samplesChanged();
 }
 
 ClpPel*** CalypFrame::getPelBufferYUV() const
 {
-  return d->m_pppcInputPel;
+  return d->pelPlanes();
 }
 
 ClpPel*** CalypFrame::getPelBufferYUV()
 {
-  d->m_bHasHistogram = false;
-  d->m_bHasRGBPel = false;
+  if( d->m_uiSampleBytes == sizeof( ClpByte ) )
+    d->syncPelPlanes( true );
+  else
+    d->detachPlanes( true );
+  d->owner()->derivedChanged();
   return d->m_pppcInputPel;
 }
 
+ClpByte*** CalypFrame::getBytePelBufferYUV() const
+{
+  return d->bytePlanes();
+}
+
+ClpByte*** CalypFrame::getBytePelBufferYUV()
+{
+  if( d->m_uiSampleBytes != sizeof( ClpByte ) )
+    return NULL;
+  d->syncBytePlanes();
+  d->detachPlanes( true );
+  d->samplesChanged();
+  return d->m_pppcBytePel;
+}
+
 unsigned char* CalypFrame::getRGBBuffer() const
 {
   if( d->m_bHasRGBPel )
@@ -474,7 +1566,7 @@ unsigned char* CalypFrame::getRGBBuffer() const
 ClpPel CalypFrame::operator()( unsigned int ch, unsigned int xPos, unsigned int yPos )
 {
   if( ch < d->m_pcPelFormat->numberChannels )
-    return d->m_pppcInputPel[ch][yPos][xPos];
+    return d->getSample( ch, xPos, yPos );
   return 0;
 }
 
@@ -488,37 +1580,42 @@ CalypPixel CalypFrame::getPixel( unsigned int xPos, unsigned int yPos )
   CalypPixel PixelValue( d->m_pcPelFormat->colorSpace );
   for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
   {
-    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    PixelValue[ch] = d->m_pppcInputPel[ch][( yPos >> ratioH )][( xPos >> ratioW )];
+    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
+    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
+    PixelValue[ch] = d->getSample( ch, xPos >> ratioW, yPos >> ratioH );
   }
   return PixelValue;
 }
 
 CalypPixel CalypFrame::getPixel( unsigned int xPos, unsigned int yPos, CalypColorSpace eColorSpace )
 {
-  return getPixel( xPos, yPos ).convertPixel( eColorSpace );
+  return getPixel( xPos, yPos ).convertPixel( eColorSpace, d->m_iColorMatrix, d->m_iColorRange, d->m_uiBitsPel );
 }
 
 void CalypFrame::setPixel( unsigned int xPos, unsigned int yPos, CalypPixel pixel )
 {
+  d->syncBytePlanes();
+  d->detachPlanes( true );
   for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
   {
-    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    d->m_pppcInputPel[ch][( yPos >> ratioH )][( xPos >> ratioW )] = pixel[ch];
+    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
+    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
+    d->setSample( ch, xPos >> ratioW, yPos >> ratioH, pixel[ch] );
   }
-  d->m_bHasHistogram = false;
-  d->m_bHasRGBPel = false;
+  d->samplesChanged();
 }
 
 void CalypFrame::copyFrom( const CalypFrame& other )
 {
-  if( haveSameFmt( other, MATCH_ALL ) )
+  if( &other == this || !haveSameFmt( other, MATCH_ALL ) )
     return;
-  d->m_bHasRGBPel = false;
-  d->m_bHasHistogram = false;
-  memcpy( *d->m_pppcInputPel[CLP_LUMA], other.getPelBufferYUV()[CLP_LUMA][0], getBytesPerFrame() * sizeof( ClpPel ) );
+  if( !d->m_bIsView && !other.isView() )
+  {
+    // No copy until one of the frames is written
+    d->sharePlanes( other.d );
+    return;
+  }
+  copyFrom( other, 0, 0 );
 }
 
 void CalypFrame::copyFrom( const CalypFrame* other )
@@ -529,21 +1626,16 @@ void CalypFrame::copyFrom( const CalypFrame* other )
 
 void CalypFrame::copyFrom( const CalypFrame& other, unsigned int xPos, unsigned int yPos )
 {
-  if( haveSameFmt( other, MATCH_ALL ) )
+  if( !haveSameFmt( other, MATCH_PEL_FMT | MATCH_BITS ) )
     return;
-  ClpPel*** pInput = other.getPelBufferYUV();
-  for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
-  {
-    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    for( unsigned int i = 0; i < CHROMASHIFT( d->m_uiHeight, ratioH ); i++ )
-    {
-      memcpy( d->m_pppcInputPel[ch][i], &( pInput[ch][( yPos >> ratioH ) + i][( xPos >> ratioW )] ),
-              ( d->m_uiWidth >> ratioW ) * sizeof( ClpPel ) );
-    }
-  }
-  d->m_bHasRGBPel = false;
-  d->m_bHasHistogram = false;
+  other.d->syncBytePlanes();
+  d->syncBytePlanes();
+  d->detachPlanes( false );
+  if( d->m_uiSampleBytes == sizeof( ClpByte ) )
+    d->copyPlanes<ClpByte>( other.d, xPos, yPos );
+  else
+    d->copyPlanes<ClpPel>( other.d, xPos, yPos );
+  d->samplesChanged();
 }
 
 void CalypFrame::copyFrom( const CalypFrame* other, unsigned int x, unsigned int y )
@@ -552,210 +1644,140 @@ void CalypFrame::copyFrom( const CalypFrame* other, unsigned int x, unsigned int
     copyFrom( *other, x, y );
 }
 
-void CalypFrame::frameFromBuffer( ClpByte* Buff, int iEndianness, unsigned long uiBuffSize )
+/**
+ * Convert the planes of a 4:4:4 frame between YUV and RGB (same bits)
+ * @param coeffs transform of colorTransformRow
+ */
+template <typename T>
+static void convertColorSpace( T*** pppSrc, T*** pppDst, const float* coeffs, unsigned int width, unsigned int height,
+                               unsigned int bitsPel )
 {
-  if( uiBuffSize != getBytesPerFrame() )
-    return;
-
-  frameFromBuffer( Buff, iEndianness );
+  int maxValue = ( 1 << bitsPel ) - 1;
+  CalypThreadPool::global()->parallelFor( height, 16, [&]( unsigned int startRow, unsigned int endRow ) {
+    for( unsigned int y = startRow; y < endRow; y++ )
+      colorTransformRow( coeffs, maxValue, pppSrc[0][y], pppSrc[1][y], pppSrc[2][y], pppDst[0][y], pppDst[1][y], pppDst[2][y], width );
+  } );
 }
 
-void CalypFrame::frameFromBuffer( ClpByte* Buff, int iEndianness )
+bool CalypFrame::convertFrom( const CalypFrame& other )
 {
-  ClpByte* ppBuff[MAX_NUMBER_PLANES];
-  ClpByte* pTmpBuff;
-  ClpPel* pPel;
-  unsigned int bytesPixel = ( d->m_uiBitsPel - 1 ) / 8 + 1;
-  int ratioH, ratioW, step;
-  unsigned int i, ch;
-  int startByte = 0;
-  int endByte = bytesPixel;
-  int incByte = 1;
-  int b;
-  int maxval = pow( 2, d->m_uiBitsPel ) - 1;
-
-  if( iEndianness == 0 )
+  if( other.getWidth() != getWidth() || other.getHeight() != getHeight() )
+    return false;
+  if( &other == this )
+    return true;
+  if( haveSameFmt( other, MATCH_PEL_FMT | MATCH_BITS ) )
   {
-    startByte = bytesPixel - 1;
-    endByte = -1;
-    incByte = -1;
+    copyFrom( other );
+    return true;
   }
 
-  ppBuff[0] = Buff;
-  for( i = 1; i < MAX_NUMBER_PLANES; i++ )
+  int srcSpace = other.getColorSpace();
+  int dstSpace = getColorSpace();
+  bool bSrcRgb = srcSpace == CLP_COLOR_RGB || srcSpace == CLP_COLOR_RGBA;
+  bool bDstRgb = dstSpace == CLP_COLOR_RGB || dstSpace == CLP_COLOR_RGBA;
+  if( bSrcRgb != bDstRgb )
   {
-    ratioW = i > 1 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    ratioH = i > 1 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    ppBuff[i] = ppBuff[i - 1] + CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ) * bytesPixel;
+    // Pixels are converted at 4:4:4, the matrix is the one of the YUV frame
+    const CalypFrame& yuvFrame = bSrcRgb ? *this : other;
+    int colorMatrix = yuvFrame.getColorMatrix();
+    int colorRange = yuvFrame.getColorRange();
+    if( colorMatrix == CLP_MATRIX_DEFAULT )
+    {
+      // The integer matrix of CalypPixel::convertPixel approximates this one
+      colorMatrix = CLP_MATRIX_BT601;
+      colorRange = CLP_RANGE_FULL;
+    }
+    float afCoeffs[12];
+    unsigned int bitsPel = other.getBitsPel();
+    if( bSrcRgb )
+      getRgbToYuvTransform( colorMatrix, colorRange, bitsPel, afCoeffs );
+    else
+      getYuvToRgbTransform( colorMatrix, colorRange, bitsPel, afCoeffs );
+
+    CalypFrame cSrc444( getWidth(), getHeight(), findPixelFormat( bSrcRgb ? "RGBp" : "YUV444p" ), bitsPel );
+    CalypFrame cDst444( getWidth(), getHeight(), findPixelFormat( bSrcRgb ? "YUV444p" : "RGBp" ), bitsPel );
+    cSrc444.convertFrom( other );
+    const CalypFrame& cSrc = cSrc444;
+    if( cSrc.getSampleBytes() == sizeof( ClpByte ) )
+      convertColorSpace( cSrc.getBytePelBufferYUV(), cDst444.getBytePelBufferYUV(), afCoeffs, getWidth(), getHeight(), bitsPel );
+    else
+      convertColorSpace( cSrc.getPelBufferYUV(), cDst444.getPelBufferYUV(), afCoeffs, getWidth(), getHeight(), bitsPel );
+    return convertFrom( cDst444 );
   }
 
-  for( ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
+  other.d->syncBytePlanes();
+  d->detachPlanes( false );
+  for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
   {
-    ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    step = d->m_pcPelFormat->comp[ch].step_minus1;
-
-    pPel = d->m_pppcInputPel[ch][0];
-    pTmpBuff = ppBuff[d->m_pcPelFormat->comp[ch].plane] + ( d->m_pcPelFormat->comp[ch].offset_plus1 - 1 );
-
-    for( i = 0; i < CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ); i++ )
+    if( ch < other.getNumberChannels() )
     {
-      *pPel = 0;
-      for( b = startByte; b != endByte; b += incByte )
-      {
-        *pPel += *pTmpBuff << ( b * 8 );
-        pTmpBuff++;
-        // Check max value and bound it to "maxval" to prevent segfault when
-        // calculating histogram
-        if( *pPel > maxval )
-          *pPel = 0;
-        // -----
-      }
-      pPel++;
-      pTmpBuff += step;
+      if( other.d->m_uiSampleBytes == sizeof( ClpByte ) )
+        d->resamplePlane<ClpByte>( other.d, ch );
+      else
+        d->resamplePlane<ClpPel>( other.d, ch );
+      continue;
     }
+    // Opaque alpha and neutral chroma
+    ClpPel value = dstSpace == CLP_COLOR_RGBA && ch == CLP_COLOR_A ? ( 1 << d->m_uiBitsPel ) - 1 : 1 << ( d->m_uiBitsPel - 1 );
+    if( d->m_uiSampleBytes == sizeof( ClpByte ) )
+      d->fillPlane<ClpByte>( ch, value );
+    else
+      d->fillPlane<ClpPel>( ch, value );
   }
-  d->m_bHasRGBPel = false;
-  d->m_bHasHistogram = false;
+  d->samplesChanged();
+  return true;
 }
 
-void CalypFrame::frameToBuffer( ClpByte* output_buffer, int iEndianness )
+bool CalypFrame::convertFrom( const CalypFrame* other )
 {
-  unsigned int bytesPixel = ( d->m_uiBitsPel - 1 ) / 8 + 1;
-  ClpByte* ppBuff[MAX_NUMBER_PLANES];
-  ClpByte* pTmpBuff;
-  ClpPel* pTmpPel;
-  int ratioH, ratioW, step;
-  unsigned int i, ch;
-  int startByte = 0;
-  int endByte = bytesPixel;
-  int incByte = 1;
-  int b;
+  return other ? convertFrom( *other ) : false;
+}
 
-  if( iEndianness == 0 )
-  {
-    startByte = bytesPixel - 1;
-    endByte = -1;
-    incByte = -1;
-  }
+void CalypFrame::frameFromBuffer( ClpByte* Buff, int iEndianness, unsigned long uiBuffSize )
+{
+  if( uiBuffSize != getBytesPerFrame() )
+    return;
 
-  ppBuff[0] = output_buffer;
-  for( int i = 1; i < MAX_NUMBER_PLANES; i++ )
-  {
-    ratioW = i > 1 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    ratioH = i > 1 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    ppBuff[i] = ppBuff[i - 1] + CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ) * bytesPixel;
-  }
+  frameFromBuffer( Buff, iEndianness );
+}
 
-  for( ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
-  {
-    ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    step = d->m_pcPelFormat->comp[ch].step_minus1;
+void CalypFrame::frameFromBuffer( ClpByte* Buff, int iEndianness )
+{
+  unsigned int bytesPixel = ( d->m_uiBitsPel - 1 ) / 8 + 1;
+  // Samples above maxval are bounded to prevent segfault when calculating histogram
+  int maxval = pow( 2, d->m_uiBitsPel ) - 1;
 
-    pTmpPel = d->m_pppcInputPel[ch][0];
-    pTmpBuff = ppBuff[d->m_pcPelFormat->comp[ch].plane];
+  d->detachPlanes( false );
+  if( d->m_uiSampleBytes == sizeof( ClpByte ) )
+    d->m_pcByteKernels->unpackFrame( Buff, d->m_pppcBytePel, d->m_uiWidth, d->m_uiHeight, d->m_auiStride, bytesPixel, iEndianness,
+                                     maxval );
+  else
+    d->m_pcPelKernels->unpackFrame( Buff, d->m_pppcInputPel, d->m_uiWidth, d->m_uiHeight, d->m_auiStride, bytesPixel, iEndianness,
+                                    maxval );
+  d->samplesChanged();
+}
 
-    for( i = 0; i < CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ); i++ )
-    {
-      for( b = startByte; b != endByte; b += incByte )
-      {
-        *pTmpBuff = *pTmpPel >> ( 8 * b );
-        pTmpBuff++;
-      }
-      pTmpPel++;
-      pTmpBuff += step;
-    }
-  }
+void CalypFrame::frameToBuffer( ClpByte* output_buffer, int iEndianness )
+{
+  unsigned int bytesPixel = ( d->m_uiBitsPel - 1 ) / 8 + 1;
+
+  d->syncBytePlanes();
+  if( d->m_uiSampleBytes == sizeof( ClpByte ) )
+    d->m_pcByteKernels->packFrame( d->m_pppcBytePel, output_buffer, d->m_uiWidth, d->m_uiHeight, d->m_auiStride, bytesPixel,
+                                   iEndianness );
+  else
+    d->m_pcPelKernels->packFrame( d->m_pppcInputPel, output_buffer, d->m_uiWidth, d->m_uiHeight, d->m_auiStride, bytesPixel,
+                                  iEndianness );
 }
 
 void CalypFrame::fillRGBBuffer()
 {
-#define PEL_ARGB( a, r, g, b ) ( ( a & 0xff ) << 24 ) | ( ( r & 0xff ) << 16 ) | ( ( g & 0xff ) << 8 ) | ( b & 0xff )
-#define PEL_RGB( r, g, b ) PEL_ARGB( 0xffu, r, g, b )
-#define CLAMP_YUV2RGB( X ) X = X < 0 ? 0 : X > 255 ? 255 : X;
-#define YUV2RGB( iY, iU, iV, iR, iG, iB )                          \
-  iR = iY + ( ( 1436 * ( iV - 128 ) ) >> 10 );                     \
-  iG = iY - ( ( 352 * ( iU - 128 ) + 731 * ( iV - 128 ) ) >> 10 ); \
-  iB = iY + ( ( 1812 * ( iU - 128 ) ) >> 10 );                     \
-  CLAMP_YUV2RGB( iR )                                              \
-  CLAMP_YUV2RGB( iG )                                              \
-  CLAMP_YUV2RGB( iB )
-
-  if( d->m_bHasRGBPel )
+  if( d->m_bHasRGBPel || !d->allocARGB() )
     return;
-  int shiftBits = d->m_uiBitsPel - 8;
-  unsigned int* pARGB = (unsigned int*)d->m_pcARGB32;
-  if( d->m_pcPelFormat->colorSpace == CLP_COLOR_GRAY )
-  {
-    ClpPel* pY = d->m_pppcInputPel[CLP_LUMA][0];
-    for( unsigned int i = 0; i < d->m_uiHeight * d->m_uiWidth; i++ )
-    {
-      *pARGB++ = PEL_RGB( *pY, *pY, *pY );
-      pY++;
-    }
-  }
-  else if( d->m_pcPelFormat->colorSpace == CLP_COLOR_RGB )
-  {
-    ClpPel* pR = d->m_pppcInputPel[CLP_COLOR_R][0];
-    ClpPel* pG = d->m_pppcInputPel[CLP_COLOR_G][0];
-    ClpPel* pB = d->m_pppcInputPel[CLP_COLOR_B][0];
-    for( unsigned int i = 0; i < d->m_uiHeight * d->m_uiWidth; i++ )
-      *pARGB++ = PEL_RGB( ( *pR++ ) >> shiftBits, ( *pG++ ) >> shiftBits, ( *pB++ ) >> shiftBits );
-  }
-  else if( d->m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
-  {
-    ClpPel* pR = d->m_pppcInputPel[CLP_COLOR_R][0];
-    ClpPel* pG = d->m_pppcInputPel[CLP_COLOR_G][0];
-    ClpPel* pB = d->m_pppcInputPel[CLP_COLOR_B][0];
-    ClpPel* pA = d->m_pppcInputPel[CLP_COLOR_A][0];
-    for( unsigned int i = 0; i < d->m_uiHeight * d->m_uiWidth; i++ )
-      *pARGB++ = PEL_ARGB( ( *pA++ ) >> shiftBits, ( *pR++ ) >> shiftBits, ( *pG++ ) >> shiftBits, ( *pB++ ) >> shiftBits );
-  }
-  else if( d->m_pcPelFormat->colorSpace == CLP_COLOR_YUV )
-  {
-    ClpPel* pLineY = d->m_pppcInputPel[CLP_LUMA][0];
-    ClpPel* pLineU = d->m_pppcInputPel[CLP_CHROMA_U][0];
-    ClpPel* pLineV = d->m_pppcInputPel[CLP_CHROMA_V][0];
-    unsigned int uiChromaStride = CHROMASHIFT( d->m_uiWidth, d->m_pcPelFormat->log2ChromaWidth );
-    ClpPel* pY;
-    ClpPel* pU;
-    ClpPel* pV;
-    int iY, iU, iV, iR, iG, iB;
-    unsigned int* pARGBLine = pARGB;
-    unsigned int* pARGB;
-
-    unsigned int y, x;
-    int i, j;
-    for( y = 0; y < CHROMASHIFT( d->m_uiHeight, d->m_pcPelFormat->log2ChromaHeight ); y++ )
-    {
-      for( i = 0; i < 1 << d->m_pcPelFormat->log2ChromaHeight; i++ )
-      {
-        pY = pLineY;
-        pU = pLineU;
-        pV = pLineV;
-        pARGB = pARGBLine;
-        for( x = 0; x < CHROMASHIFT( d->m_uiWidth, d->m_pcPelFormat->log2ChromaWidth ); x++ )
-        {
-          iU = *pU++;
-          iU >>= shiftBits;
-          iV = *pV++;
-          iV >>= shiftBits;
-          for( j = 0; j < ( 1 << d->m_pcPelFormat->log2ChromaWidth ); j++ )
-          {
-            iY = *pY++;
-            iY >>= shiftBits;
-            YUV2RGB( iY, iU, iV, iR, iG, iB );
-            *pARGB++ = PEL_RGB( iR, iG, iB );
-          }
-        }
-        pLineY += d->m_uiWidth;
-        pARGBLine += d->m_uiWidth;
-      }
-      pLineU += uiChromaStride;
-      pLineV += uiChromaStride;
-    }
-  }
+  if( d->m_uiSampleBytes == sizeof( ClpByte ) )
+    d->fillArgb( d->bytePlanes(), d->m_pcByteKernels );
+  else
+    d->fillArgb( d->m_pppcInputPel, d->m_pcPelKernels );
   d->m_bHasRGBPel = true;
 }
 
@@ -763,41 +1785,89 @@ void CalypFrame::fillRGBBuffer()
  * Histogram
  */
 
-void CalypFrame::calcHistogram()
+bool CalypFrame::calcHistogram()
 {
-  if( d->m_bHasHistogram || !d->m_puiHistogram )
-    return;
-
-  d->m_bHistogramRunning = true;
-
-  xMemSet( unsigned int, d->m_uiHistoSegments * d->m_uiHistoChannels, d->m_puiHistogram );
-
-  unsigned int numberChannels = d->m_pcPelFormat->numberChannels;
-  for( unsigned int ch = 0; ch < numberChannels; ch++ )
-  {
-    unsigned int size = CHROMASHIFT( d->m_uiWidth, ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0 ) *
-                        CHROMASHIFT( d->m_uiHeight, ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0 );
+  return calcHistogram( d->m_uiHistogramGen );
+}
 
-    ClpPel* chPel = &( d->m_pppcInputPel[ch][0][0] );
-    for( unsigned int i = 0; i < size; i++ )
+bool CalypFrame::calcHistogram( unsigned int uiGeneration )
+{
+  if( d->m_bHasHistogram )
+    return true;
+
+  std::lock_guard<std::mutex> lock( d->m_cHistogramMutex );
+  if( d->m_bHasHistogram )
+    return true;
+  // Cancelled before it started
+  if( d->m_uiHistogramGen != uiGeneration || !d->allocHistogram() )
+    return false;
+  d->syncBytePlanes();
+
+  const CalypPixelFormatDescriptor* pcPelFormat = d->m_pcPelFormat;
+  unsigned int uiSegments = d->m_uiHistoSegments;
+  unsigned int uiHistoSize = uiSegments * d->m_uiHistoChannels;
+  bool bCalcLuma = pcPelFormat->colorSpace == CLP_COLOR_RGB || pcPelFormat->colorSpace == CLP_COLOR_RGBA;
+
+  // One sub-histogram per slot so that threads never write the same bins;
+  // slot 0 writes directly to the frame histogram
+  unsigned int uiSlots = std::max( 1u, std::min( CalypThreadPool::global()->numberThreads(), d->m_uiHeight / 16 ) );
+  std::vector<unsigned int> auiSubHistograms( ( uiSlots - 1 ) * uiHistoSize, 0 );
+  xMemSet( unsigned int, uiHistoSize, d->m_puiHistogram );
+
+  CalypThreadPool::global()->parallelFor( uiSlots, 1, [&]( unsigned int startSlot, unsigned int endSlot ) {
+    std::vector<ClpPel> aLumaRow( bCalcLuma && d->m_uiSampleBytes != sizeof( ClpByte ) ? d->m_uiWidth : 0 );
+    std::vector<ClpByte> aLumaByteRow( bCalcLuma && d->m_uiSampleBytes == sizeof( ClpByte ) ? d->m_uiWidth : 0 );
+    for( unsigned int slot = startSlot; slot < endSlot; slot++ )
     {
-      d->m_puiHistogram[*chPel + ch * d->m_uiHistoSegments]++;
-      chPel++;
+      unsigned int* puiHist = slot == 0 ? d->m_puiHistogram : &auiSubHistograms[( slot - 1 ) * uiHistoSize];
+      bool bDone = d->m_uiSampleBytes == sizeof( ClpByte ) ? d->accumulateHistogramSlot( d->m_pppcBytePel, slot, uiSlots, puiHist, aLumaByteRow, uiGeneration )
+                                                            : d->accumulateHistogramSlot( d->m_pppcInputPel, slot, uiSlots, puiHist, aLumaRow, uiGeneration );
+      if( !bDone )
+        return;
     }
-  }
+  } );
 
-  if( d->m_pcPelFormat->colorSpace == CLP_COLOR_RGB ||
-      d->m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
+  if( d->m_uiHistogramGen != uiGeneration )
+    return false;
+
+  for( unsigned int slot = 1; slot < uiSlots; slot++ )
   {
-    for( unsigned int y = 0; y < d->m_uiHeight; y++ )
-      for( unsigned int x = 0; x < d->m_uiWidth; x++ )
-      {
-        ClpPel luma = getPixel( x, y ).convertPixel( CLP_COLOR_YUV )[0];
-        d->m_puiHistogram[luma + ( d->m_uiHistoChannels - 1 ) * d->m_uiHistoSegments]++;
-      }
+    const unsigned int* puiSubHist = &auiSubHistograms[( slot - 1 ) * uiHistoSize];
+    for( unsigned int i = 0; i < uiHistoSize; i++ )
+      d->m_puiHistogram[i] += puiSubHist[i];
   }
+  d->calcHistogramStats();
   d->m_bHasHistogram = true;
-  d->m_bHistogramRunning = false;
+  return true;
+}
+
+unsigned int CalypFrame::getHistogramGeneration() const
+{
+  return d->m_uiHistogramGen;
+}
+
+void CalypFrame::cancelHistogram()
+{
+  d->m_uiHistogramGen++;
+}
+
+void CalypFrame::releaseRGBBuffer()
+{
+  d->releaseARGB();
+}
+
+void CalypFrame::releaseHistogram()
+{
+  d->m_uiHistogramGen++;
+  std::lock_guard<std::mutex> lock( d->m_cHistogramMutex );
+  d->releaseHistogram();
+}
+
+void CalypFrame::releaseSideBuffers()
+{
+  releaseRGBBuffer();
+  releaseHistogram();
+  d->releasePelCopy();
 }
 
 int CalypFrame::getNumHistogramSegment()
@@ -914,14 +1984,7 @@ unsigned int CalypFrame::getNumPixelsRange( int channel, unsigned int start, uns
     return 0;
   }
 
-  unsigned int count = 0;
-  int indexStart;
-  indexStart = channel * d->m_uiHistoSegments;
-  for( unsigned int i = start; i <= end; i++ )
-  {
-    count += d->m_puiHistogram[indexStart + i];
-  }
-  return count;
+  return d->rangeSum( d->m_aullHistoCount, channel, start, end );
 }
 
 double CalypFrame::getMean( int channel, unsigned int start, unsigned int end )
@@ -936,15 +1999,8 @@ double CalypFrame::getMean( int channel, unsigned int start, unsigned int end )
     return 0.0;
   }
 
-  double mean = 0.0;
-  double count;
-  int indexStart = channel * d->m_uiHistoSegments;
-  for( unsigned int i = start; i <= end; i++ )
-  {
-    mean += i * d->m_puiHistogram[indexStart + i];
-  }
-
-  count = getNumPixelsRange( channel, start, end );
+  double mean = d->rangeSum( d->m_aullHistoSum, channel, start, end );
+  double count = d->rangeSum( d->m_aullHistoCount, channel, start, end );
 
   if( count > 0.0 )
   {
@@ -967,17 +2023,13 @@ int CalypFrame::getMedian( int channel, unsigned int start, unsigned int end )
     return 0;
   }
 
-  double sum = 0.0;
-  int indexStart = channel * d->m_uiHistoSegments;
-  double count = getNumPixelsRange( channel, start, end );
-  for( unsigned int i = start; i <= end; i++ )
-  {
-    sum += d->m_puiHistogram[indexStart + i];
-    if( sum * 2 > count )
-      return i;
-  }
-
-  return 0;
+  // First bin where the cumulative count goes above half of the range count
+  const unsigned long long* pullCount = &d->m_aullHistoCount[channel * ( d->m_uiHistoSegments + 1 )];
+  unsigned long long count = pullCount[end + 1] - pullCount[start];
+  const unsigned long long* pullMedian = std::upper_bound( pullCount + start + 1, pullCount + end + 2, pullCount[start] + count / 2 );
+  if( pullMedian == pullCount + end + 2 )
+    return 0;
+  return pullMedian - pullCount - 1;
 }
 
 double CalypFrame::getStdDev( int channel, unsigned int start, unsigned int end )
@@ -993,29 +2045,12 @@ double CalypFrame::getStdDev( int channel, unsigned int start, unsigned int end
     return 0.0;
   }
 
-  int indexStart = channel * d->m_uiHistoSegments;
-  double mean = getMean( channel, start, end );
-  double count = getNumPixelsRange( channel, start, end );
-  double dev = 0.0;
+  double count = d->rangeSum( d->m_aullHistoCount, channel, start, end );
+  double mean = count > 0.0 ? d->rangeSum( d->m_aullHistoSum, channel, start, end ) / count : 0.0;
+  double dev = d->rangeSum( d->m_aullHistoSumSq, channel, start, end );
   if( count == 0.0 )
     count = 1.0;
 
-  /*------------ original
-
-	 for ( i = start ; i <= end ; i++ )
-	 {
-	 dev += ( i - mean ) * ( i - mean ) * d->m_puiHistogram[indexStart +i];
-	 }
-
-	 return sqrt( dev / count );
-
-	 -----------------------*/
-
-  for( unsigned int i = start; i <= end; i++ )
-  {
-    dev += ( i * i ) * d->m_puiHistogram[indexStart + i];
-  }
-
   return sqrt( ( dev - count * mean * mean ) / ( count - 1 ) );
 }
 
@@ -1040,44 +2075,54 @@ double CalypFrame::getHistogramValue( int channel, unsigned int bin )
  **************************************************************
  */
 
-bool CalypFrame::toMat( cv::Mat& cvMat, bool convertToGray )
+bool CalypFrame::toMat( cv::Mat& cvMat, bool convertToGray, bool shareData )
 {
   bool bRet = false;
 #ifdef USE_OPENCV
-  if( convertToGray && !( d->m_pcPelFormat->colorSpace == CLP_COLOR_YUV ||
-                          d->m_pcPelFormat->colorSpace == CLP_COLOR_GRAY ) )
-  {
-    return bRet;
-  }
-  int cvType = CV_MAKETYPE( CV_8U, convertToGray ? 1 : d->m_pcPelFormat->numberChannels );
-  cvMat.create( d->m_uiHeight, d->m_uiWidth, cvType );
-  unsigned char* pCvPel = cvMat.data;
-  if( !convertToGray && ( d->m_pcPelFormat->colorSpace == CLP_COLOR_YUV ||
-                          d->m_pcPelFormat->colorSpace == CLP_COLOR_RGB ) )
+  int colorSpace = d->m_pcPelFormat->colorSpace;
+  bool bByte = d->m_uiSampleBytes == sizeof( ClpByte );
+  int cvDepth = bByte ? CV_8U : CV_16U;
+  if( convertToGray || colorSpace == CLP_COLOR_GRAY )
   {
-    fillRGBBuffer();
-    unsigned char* pARGB = d->m_pcARGB32;
-    for( unsigned int i = 0; i < d->m_uiWidth * d->m_uiHeight; i++ )
+    if( !( colorSpace == CLP_COLOR_YUV || colorSpace == CLP_COLOR_GRAY ) )
+    {
+      return bRet;
+    }
+    if( shareData )
     {
-      *pCvPel++ = *pARGB++;
-      *pCvPel++ = *pARGB++;
-      *pCvPel++ = *pARGB++;
-      pARGB++;
+      void* pPlane = bByte ? (void*)d->bytePlanes()[CLP_LUMA][0] : (void*)d->m_pppcInputPel[CLP_LUMA][0];
+      cvMat = cv::Mat( d->m_uiHeight, d->m_uiWidth, CV_MAKETYPE( cvDepth, 1 ), pPlane,
+                       d->m_auiStride[CLP_LUMA] * d->m_uiSampleBytes );
+      return true;
     }
+    // Never copy into a Mat that wraps the planes of a frame
+    cvMat.release();
+    cvMat.create( d->m_uiHeight, d->m_uiWidth, CV_MAKETYPE( cvDepth, 1 ) );
+    if( bByte )
+      d->planeToMat( d->bytePlanes()[CLP_LUMA], cvMat.data, cvMat.step );
+    else
+      d->planeToMat( d->m_pppcInputPel[CLP_LUMA], cvMat.data, cvMat.step );
     bRet = true;
   }
-  else if( convertToGray || d->m_pcPelFormat->colorSpace == CLP_COLOR_GRAY )
+  else if( colorSpace == CLP_COLOR_RGB )
   {
-    ClpPel* pPel = d->m_pppcInputPel[CLP_LUMA][0];
-    for( unsigned int i = 0; i < d->m_uiWidth * d->m_uiHeight; i++ )
-    {
-      *pCvPel++ = *pPel++;
-    }
+    cvMat.release();
+    cvMat.create( d->m_uiHeight, d->m_uiWidth, CV_MAKETYPE( cvDepth, 3 ) );
+    if( bByte )
+      d->bgrToMat( d->bytePlanes(), cvMat.data, cvMat.step );
+    else
+      d->bgrToMat( d->m_pppcInputPel, cvMat.data, cvMat.step );
     bRet = true;
   }
-  else
+  else if( colorSpace == CLP_COLOR_YUV )
   {
-    return false;
+    fillRGBBuffer();
+    cvMat.release();
+    cvMat.create( d->m_uiHeight, d->m_uiWidth, CV_8UC3 );
+    const unsigned int* pARGB = (const unsigned int*)d->m_pcARGB32;
+    for( unsigned int y = 0; y < d->m_uiHeight; y++ )
+      argbToBgrRow( pARGB + y * d->m_uiWidth, cvMat.data + y * cvMat.step, d->m_uiWidth );
+    bRet = true;
   }
 #endif
   return bRet;
@@ -1087,51 +2132,45 @@ bool CalypFrame::fromMat( cv::Mat& cvMat )
 {
   bool bRet = false;
 #ifdef USE_OPENCV
+  int cvDepth = cvMat.depth();
+  if( ( cvDepth != CV_8U && cvDepth != CV_16U ) || ( cvMat.channels() != 1 && cvMat.channels() != 3 ) )
+  {
+    return bRet;
+  }
   if( !d->m_bInit )
   {
     if( d->m_iPixelFormat == CLP_INVALID_FMT )
     {
-      switch( cvMat.channels() )
-      {
-      case 1:
-        d->m_iPixelFormat = findPixelFormat( "GRAY" );
-        break;
-      case 3:
-        d->m_iPixelFormat = findPixelFormat( "BGR24" );
-        break;
-      default:
-        return false;
-      }
+      d->m_iPixelFormat = findPixelFormat( cvMat.channels() == 1 ? "GRAY" : "BGR" );
     }
-    d->init( cvMat.cols, cvMat.rows, d->m_iPixelFormat, 8 );
+    d->init( cvMat.cols, cvMat.rows, d->m_iPixelFormat, cvDepth == CV_8U ? 8 : 16, d->m_iLayout );
   }
 
-  d->m_bHasRGBPel = false;
-  d->m_bHasHistogram = false;
+  int colorSpace = d->m_pcPelFormat->colorSpace;
+  int channels = colorSpace == CLP_COLOR_GRAY ? 1 : colorSpace == CLP_COLOR_RGB ? 3 : 0;
+  if( cvMat.channels() != channels || cvMat.cols != int( d->m_uiWidth ) || cvMat.rows != int( d->m_uiHeight ) )
+  {
+    return bRet;
+  }
+
+  d->detachPlanes( false );
 
-  unsigned char* pCvPel = cvMat.data;
-  if( d->m_iPixelFormat != CLP_GRAY )
+  if( d->m_uiSampleBytes == sizeof( ClpByte ) )
   {
-    ClpPel* pInputPelR = d->m_pppcInputPel[CLP_COLOR_R][0];
-    ClpPel* pInputPelG = d->m_pppcInputPel[CLP_COLOR_G][0];
-    ClpPel* pInputPelB = d->m_pppcInputPel[CLP_COLOR_B][0];
-    for( unsigned int i = 0; i < d->m_uiHeight * d->m_uiWidth; i++ )
-    {
-      *pInputPelB++ = *pCvPel++;
-      *pInputPelG++ = *pCvPel++;
-      *pInputPelR++ = *pCvPel++;
-    }
-    bRet = true;
+    if( cvDepth == CV_8U )
+      d->planesFromMat<ClpByte, ClpByte>( d->m_pppcBytePel, cvMat.data, cvMat.step );
+    else
+      d->planesFromMat<ClpByte, ClpPel>( d->m_pppcBytePel, cvMat.data, cvMat.step );
   }
   else
   {
-    ClpPel* pPel = d->m_pppcInputPel[CLP_LUMA][0];
-    for( unsigned int i = 0; i < d->m_uiWidth * d->m_uiHeight; i++ )
-    {
-      *pPel++ = *pCvPel++;
-    }
-    bRet = true;
+    if( cvDepth == CV_8U )
+      d->planesFromMat<ClpPel, ClpByte>( d->m_pppcInputPel, cvMat.data, cvMat.step );
+    else
+      d->planesFromMat<ClpPel, ClpPel>( d->m_pppcInputPel, cvMat.data, cvMat.step );
   }
+  d->samplesChanged();
+  bRet = true;
 #endif
   return bRet;
 }
@@ -1170,15 +2209,78 @@ double CalypFrame::getQuality( int Metric, CalypFrame* Org, int component )
   return 0;
 }
 
-double CalypFrame::getMSE( CalypFrame* Org, int component )
+void CalypFrame::getQuality( const std::vector<int>& metrics, const std::vector<unsigned int>& components, CalypFrame* Org,
+                             QualityResult& result )
 {
-  ClpPel* pPelYUV = getPelBufferYUV()[component][0];
-  ClpPel* pOrgPelYUV = Org->getPelBufferYUV()[component][0];
+  bool bNeedSSD = false;
+  bool bNeedSSIM = false;
+  for( unsigned int i = 0; i < metrics.size(); i++ )
+  {
+    bNeedSSD |= metrics[i] == PSNR_METRIC || metrics[i] == MSE_METRIC;
+    bNeedSSIM |= metrics[i] == SSIM_METRIC;
+  }
+
+  memset( result.adQuality, 0, sizeof( result.adQuality ) );
+
+  const CalypFrame* pcOrg = Org;
+  int maxValue = ( 1 << Org->getBitsPel() ) - 1;
+  unsigned int bitsPel = std::max( d->m_uiBitsPel, Org->getBitsPel() );
+  // Native 8 bits planes when both frames have them
+  bool bBytePlanes = d->m_uiSampleBytes == sizeof( ClpByte ) && Org->getSampleBytes() == sizeof( ClpByte );
+  for( unsigned int i = 0; i < components.size(); i++ )
+  {
+    unsigned int c = components[i];
+    if( c >= d->m_pcPelFormat->numberChannels || c >= CALYP_PIXEL_MAX_COMPONENTS )
+      continue;
 
-  int aux_pel_1, aux_pel_2;
-  int diff = 0;
-  double ssd = 0;
+    unsigned long long ullSSD = 0;
+    double dSSIM = 0;
+    int winSize = c == CLP_LUMA ? 8 : 4;
+    if( bBytePlanes )
+      computePlaneQuality( d->bytePlanes()[c], pcOrg->getBytePelBufferYUV()[c], getWidth( c ), getHeight( c ), winSize, maxValue,
+                           bitsPel, bNeedSSD ? &ullSSD : NULL, bNeedSSIM ? &dSSIM : NULL );
+    else
+      computePlaneQuality( d->pelPlanes()[c], pcOrg->getPelBufferYUV()[c], getWidth( c ), getHeight( c ), winSize, maxValue,
+                           bitsPel, bNeedSSD ? &ullSSD : NULL, bNeedSSIM ? &dSSIM : NULL );
+
+    double dMSE = double( ullSSD ) / double( getWidth( c ) * getHeight( c ) );
+    for( unsigned int m = 0; m < metrics.size(); m++ )
+    {
+      switch( metrics[m] )
+      {
+      case PSNR_METRIC:
+        result.adQuality[PSNR_METRIC][c] = dMSE != 0 ? 10 * log10( double( maxValue ) * double( maxValue ) / dMSE ) : 100;
+        break;
+      case MSE_METRIC:
+        result.adQuality[MSE_METRIC][c] = dMSE;
+        break;
+      case SSIM_METRIC:
+        result.adQuality[SSIM_METRIC][c] = dSSIM;
+        break;
+      default:
+        assert( 0 );
+      }
+    }
+  }
+}
+
+unsigned long long CalypFrame::getSSD( CalypFrame* Org, int component )
+{
+  const CalypFrame* pcOrg = Org;
+  unsigned long long ullSSD = 0;
+  if( d->m_uiSampleBytes == sizeof( ClpByte ) && Org->getSampleBytes() == sizeof( ClpByte ) )
+    computePlaneQuality( d->bytePlanes()[component], pcOrg->getBytePelBufferYUV()[component], getWidth( component ),
+                         getHeight( component ), 8, ( 1 << Org->getBitsPel() ) - 1, std::max( d->m_uiBitsPel, Org->getBitsPel() ),
+                         &ullSSD, NULL );
+  else
+    computePlaneQuality( d->pelPlanes()[component], pcOrg->getPelBufferYUV()[component], getWidth( component ),
+                         getHeight( component ), 8, ( 1 << Org->getBitsPel() ) - 1, std::max( d->m_uiBitsPel, Org->getBitsPel() ),
+                         &ullSSD, NULL );
+  return ullSSD;
+}
 
+double CalypFrame::getMSE( CalypFrame* Org, int component )
+{
   unsigned int numberOfPixels = 0;
   if( component == CLP_LUMA )
   {
@@ -1189,13 +2291,7 @@ double CalypFrame::getMSE( CalypFrame* Org, int component )
     numberOfPixels = getChromaLength();
   }
 
-  for( unsigned int i = 0; i < numberOfPixels; i++ )
-  {
-    aux_pel_1 = *pPelYUV++;
-    aux_pel_2 = *pOrgPelYUV++;
-    diff = aux_pel_1 - aux_pel_2;
-    ssd += (double)( diff * diff );
-  }
+  double ssd = getSSD( Org, component );
   if( ssd == 0.0 )
   {
     return 0.0;
@@ -1214,85 +2310,49 @@ double CalypFrame::getPSNR( CalypFrame* Org, int component )
   return dPSNR;
 }
 
-float compute_ssim( ClpPel** refImg, ClpPel** encImg, int width, int height, int win_width, int win_height,
-                    int max_pel_value_comp, int overlapSize )
+double CalypFrame::getSSIM( CalypFrame* Org, int component )
 {
-  static const float K1 = 0.01f, K2 = 0.03f;
-  float max_pix_value_sqd;
-  float C1, C2;
-  float win_pixels = (float)( win_width * win_height );
-#ifdef UNBIASED_VARIANCE
-  float win_pixels_bias = win_pixels - 1;
-#else
-  float win_pixels_bias = win_pixels;
-#endif
-  float mb_ssim, meanOrg, meanEnc;
-  float varOrg, varEnc, covOrgEnc;
-  int imeanOrg, imeanEnc, ivarOrg, ivarEnc, icovOrgEnc;
-  float cur_distortion = 0.0;
-  int i, j, n, m, win_cnt = 0;
+  return getSSIM( Org, component, SSIM_BLOCK_MODE );
+}
 
-  max_pix_value_sqd = (float)( max_pel_value_comp * max_pel_value_comp );
-  C1 = K1 * K1 * max_pix_value_sqd;
-  C2 = K2 * K2 * max_pix_value_sqd;
+double CalypFrame::getSSIM( CalypFrame* Org, int component, int mode )
+{
+  const CalypFrame* pcOrg = Org;
+  int width = getWidth( component );
+  int height = getHeight( component );
+  int maxValue = ( 1 << Org->getBitsPel() ) - 1;
+  int winSize = component == CLP_LUMA ? 8 : 4;
 
-  for( j = 0; j <= height - win_height; j += overlapSize )
+  if( d->m_uiSampleBytes == sizeof( ClpByte ) && Org->getSampleBytes() == sizeof( ClpByte ) )
   {
-    for( i = 0; i <= width - win_width; i += overlapSize )
-    {
-      imeanOrg = 0;
-      imeanEnc = 0;
-      ivarOrg = 0;
-      ivarEnc = 0;
-      icovOrgEnc = 0;
-
-      for( n = j; n < j + win_height; n++ )
-      {
-        for( m = i; m < i + win_width; m++ )
-        {
-          imeanOrg += refImg[n][m];
-          imeanEnc += encImg[n][m];
-          ivarOrg += refImg[n][m] * refImg[n][m];
-          ivarEnc += encImg[n][m] * encImg[n][m];
-          icovOrgEnc += refImg[n][m] * encImg[n][m];
-        }
-      }
-
-      meanOrg = (float)imeanOrg / win_pixels;
-      meanEnc = (float)imeanEnc / win_pixels;
-
-      varOrg = ( (float)ivarOrg - ( (float)imeanOrg ) * meanOrg ) / win_pixels_bias;
-      varEnc = ( (float)ivarEnc - ( (float)imeanEnc ) * meanEnc ) / win_pixels_bias;
-      covOrgEnc = ( (float)icovOrgEnc - ( (float)imeanOrg ) * meanEnc ) / win_pixels_bias;
-
-      mb_ssim = (float)( ( 2.0 * meanOrg * meanEnc + C1 ) * ( 2.0 * covOrgEnc + C2 ) );
-      mb_ssim /= (float)( meanOrg * meanOrg + meanEnc * meanEnc + C1 ) * ( varOrg + varEnc + C2 );
-
-      cur_distortion += mb_ssim;
-      win_cnt++;
-    }
+    ClpByte** refImg = d->bytePlanes()[component];
+    ClpByte** encImg = pcOrg->getBytePelBufferYUV()[component];
+    if( mode == SSIM_GAUSSIAN_MODE )
+      return computeSsimGaussian( refImg, encImg, width, height, maxValue );
+    return computeSsimBlocks( refImg, encImg, width, height, winSize, winSize, maxValue, winSize );
   }
 
-  cur_distortion /= (float)win_cnt;
+  ClpPel** refImg = d->pelPlanes()[component];
+  ClpPel** encImg = pcOrg->getPelBufferYUV()[component];
+  if( mode == SSIM_GAUSSIAN_MODE )
+  {
+    return computeSsimGaussian( refImg, encImg, width, height, maxValue );
+  }
+  return computeSsimBlocks( refImg, encImg, width, height, winSize, winSize, maxValue, winSize );
+}
 
-  if( cur_distortion >= 1.0 && cur_distortion < 1.01 )  // avoid float accuracy problem at very low QP(e.g.2)
-    cur_distortion = 1.0;
+unsigned long long CalypFrame::computeSSD( const ClpPel* pA, const ClpPel* pB, unsigned long count, unsigned int bitsPel )
+{
+  return sumSquaredDiff( pA, pB, count, bitsPel );
+}
 
-  return cur_distortion;
+unsigned long long CalypFrame::computeWeightedSSD( const ClpPel* pA, const ClpPel* pB, const ClpPel* pWeights, unsigned long count,
+                                                   unsigned long long& weightSum )
+{
+  return weightedSumSquaredDiff( pA, pB, pWeights, count, weightSum );
 }
 
-double CalypFrame::getSSIM( CalypFrame* Org, int component )
+void CalypFrame::computeAbsDiff( const ClpPel* pA, const ClpPel* pB, ClpPel* pOut, unsigned long count )
 {
-  double dSSIM = 1;
-  if( component == CLP_LUMA )
-  {
-    dSSIM = compute_ssim( d->m_pppcInputPel[component], Org->getPelBufferYUV()[component], d->m_uiWidth, d->m_uiHeight,
-                          8, 8, 255, 8 );
-  }
-  else
-  {
-    dSSIM = compute_ssim( d->m_pppcInputPel[component], Org->getPelBufferYUV()[component], getWidth( component ),
-                          getHeight( component ), 4, 4, 255, 4 );
-  }
-  return dSSIM;
+  absoluteDiff( pA, pB, pOut, count );
 }
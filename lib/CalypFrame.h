@@ -35,10 +35,15 @@ class Mat;
 
 #define CHROMASHIFT( SIZE, SHIFT ) (unsigned int)( -( ( -( (int)( SIZE ) ) ) >> ( SHIFT ) ) )
 
+#define CALYP_PIXEL_MAX_COMPONENTS 4
+
 /**
  * \class    CalypPixel
  * \ingroup  CalypLibGrp CalypFrameGrp
  * \brief    Pixel handling class
+ *
+ * Plain value type (trivially copyable), so pixels can be created and
+ * copied in per-pixel loops without touching the heap
  */
 class CalypPixel
 {
@@ -49,15 +54,12 @@ public:
   CalypPixel( const int& CalypColorSpace, const ClpPel& c0 );
   CalypPixel( const int& CalypColorSpace, const ClpPel& c0, const ClpPel& c1, const ClpPel& c2 );
   CalypPixel( const int& CalypColorSpace, const ClpPel& c0, const ClpPel& c1, const ClpPel& c2, const ClpPel& c3 );
-  CalypPixel( const CalypPixel& other );
-  ~CalypPixel();
 
   int colorSpace() const;
 
   ClpPel operator[]( const int& channel ) const;
   ClpPel& operator[]( const int& channel );
 
-  CalypPixel operator=( const CalypPixel& );
   CalypPixel operator+( const CalypPixel& );
   CalypPixel operator+=( const CalypPixel& );
   CalypPixel operator-( const CalypPixel& );
@@ -72,14 +74,40 @@ public:
 	 */
   CalypPixel convertPixel( CalypColorSpace eOutputSpace );
 
+  /**
+	 * Convert a Pixel to a new color space using a specific matrix
+	 * @param eOutputSpace output color space
+	 * @param colorMatrix conversion matrix (use CalypColorMatrix enum)
+	 * @param colorRange range of the YUV samples (use CalypColorRange enum)
+	 * @param bitsPel bits per sample of both input and output pixels
+	 * @return converted pixel
+	 *
+	 * @note CLP_MATRIX_DEFAULT behaves exactly as convertPixel( eOutputSpace )
+	 */
+  CalypPixel convertPixel( CalypColorSpace eOutputSpace, int colorMatrix, int colorRange, unsigned int bitsPel );
+
 private:
-  struct CalypPixelPrivate* d;
+  int m_iColorSpace;
+  ClpPel m_auiPelComp[CALYP_PIXEL_MAX_COMPONENTS];
 };
 
 /**
  * \class    CalypFrame
  * \ingroup	 CalypLibGrp CalypFrameGrp
  * \brief    Frame handling class
+ *
+ * Frames up to 8 bits store their samples as bytes (see getSampleBytes
+ * and getBytePelBufferYUV). For them getPelBufferYUV gives a ClpPel copy
+ * of the planes, made on the first call and kept beside them until
+ * releaseSideBuffers (twice the memory of the planes meanwhile); code
+ * that reads 8 bits frames often should use the byte planes.
+ *
+ * Write-back contract of the ClpPel copy: samples written through the
+ * non-const getPelBufferYUV reach the byte planes (saturated at 255)
+ * the next time the frame, its parent or one of its views is read in any
+ * other way: byte planes, ARGB buffer, histogram, quality, frameToBuffer,
+ * getPixel, copies and assignment. No call is needed for that; the ClpPel
+ * pointers must then be taken again before writing more samples
  */
 class CalypFrame
 {
@@ -91,6 +119,20 @@ public:
 	 */
   static std::vector<ClpString> supportedColorSpacesListNames();
 
+  /**
+	 * Function that handles the supported YUV to RGB
+	 * conversion matrices (follows CalypColorMatrix enum)
+	 * @return vector of strings with matrices names
+	 */
+  static std::vector<ClpString> supportedColorMatrixListNames();
+
+  /**
+	 * Function that handles the supported YUV sample
+	 * ranges (follows CalypColorRange enum)
+	 * @return vector of strings with ranges names
+	 */
+  static std::vector<ClpString> supportedColorRangeListNames();
+
   /**
 	 * Function that handles the supported pixel formats
 	 * of CalypFrame
@@ -101,38 +143,86 @@ public:
   static int numberOfFormats();
   static int findPixelFormat( const ClpString& name );
 
+  /**
+	 * Memory layout of the planes
+	 */
+  enum FrameLayouts
+  {
+    PACKED_LAYOUT = 0,  //!< Planes and rows back to back (stride equals width)
+    ALIGNED_LAYOUT,     //!< Planes and rows aligned to 64 bytes, rows padded
+  };
+
   /**
 	 * Creates a new frame using the following configuration
 	 *
 	 * @param width width of the frame
 	 * @param height height of the frame
 	 * @param pel_format pixel format index (always use PixelFormats enum)
+	 * @param layout planes layout (use FrameLayouts enum), PACKED_LAYOUT
+	 * when not given so code walking a plane linearly from [ch][0] keeps
+	 * working; the frames of the streams use ALIGNED_LAYOUT
 	 *
 	 * @note this function might misbehave if the pixel format enum is not correct
 	 */
   CalypFrame( unsigned int width, unsigned int height, int pelFormat, int bitsPixel = 8 );
+  CalypFrame( unsigned int width, unsigned int height, int pelFormat, int bitsPixel, int layout );
 
   /**
 	 * Copy contructor
+	 * The planes are shared with other until one of them is written
+	 * (copy-on-write, see getPelBufferYUV). Pointers to the planes of other
+	 * taken before the copy must not be used to write afterwards (the
+	 * samples would change in both frames); get them again
 	 *
 	 * @param other existing frame to copy from
 	 */
   CalypFrame( const CalypFrame& other );
   CalypFrame( const CalypFrame* other );
 
+  /**
+	 * Move contructor
+	 * The moved-from frame can only be destroyed or assigned
+	 */
+  CalypFrame( CalypFrame&& other ) noexcept;
+
+  CalypFrame& operator=( const CalypFrame& other );
+  CalypFrame& operator=( CalypFrame&& other ) noexcept;
+
+  /**
+	 * How a frame created from an area of another one gets its samples
+	 */
+  enum RegionModes
+  {
+    REGION_COPY = 0,  //!< Own planes with a copy of the area
+    REGION_VIEW,      //!< No copy, the rows point into the planes of the other frame
+  };
+
   /**
 	 * Creates and new frame with the configuration of an existing one and copy
 	 * its contents. This function only copies a specific region from the existing
 	 * frame
 	 *
+	 * A REGION_VIEW frame shares the samples of other, which must outlive it.
+	 * Writing to the view writes to other (taking a private copy first when
+	 * other shares its planes, see getPelBufferYUV). The rows of the view
+	 * follow other when it gets new planes (copy-on-write, copyFrom or
+	 * assignment); a view of a view points into the planes of the first
+	 * frame. Frames up to 8 bits share the pel planes (getPelBufferYUV) of
+	 * other as well, so both see the writes of the other one. The ARGB
+	 * buffer and histogram of the view are its own and are outdated whenever
+	 * other changes
+	 *
 	 * @param other existing frame to copy from
 	 * @param posX position X to crop from
 	 * @param posY position Y to crop from
 	 * @param areaWidth crop width
 	 * @param areaHeight crop height
+	 * @param mode copy or view the area (use RegionModes enum)
 	 */
-  CalypFrame( const CalypFrame& other, unsigned int x, unsigned int y, unsigned int width, unsigned int height );
-  CalypFrame( const CalypFrame* other, unsigned int x, unsigned int y, unsigned int width, unsigned int height );
+  CalypFrame( const CalypFrame& other, unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+              int mode = REGION_COPY );
+  CalypFrame( const CalypFrame* other, unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+              int mode = REGION_COPY );
 
   ~CalypFrame();
 
@@ -195,6 +285,47 @@ public:
 	 */
   unsigned int getHeight( int channel = 0 ) const;
 
+  /**
+	 * Get the distance between two rows of a plane of getPelBufferYUV
+	 * (row y of channel ch starts at getPelBufferYUV()[ch][0] + y * getStride( ch ))
+	 * @param channel/component
+	 * @return number of samples
+	 */
+  unsigned int getStride( int channel = 0 ) const;
+
+  /**
+	 * Get the planes layout (follows FrameLayouts enum)
+	 */
+  int getLayout() const;
+
+  /**
+	 * Check if every plane can be walked linearly from [ch][0]
+	 * (stride equals width and planes are back to back)
+	 */
+  bool isPacked() const;
+
+  /**
+	 * Get the samples in PACKED_LAYOUT for code that walks a plane linearly
+	 * from [ch][0]: this frame when isPacked(), otherwise a copy in
+	 * pcPacked (created, or created again when its format differs)
+	 *
+	 * @param pcPacked frame kept by the caller for the copy (NULL at first)
+	 * @return frame with packed planes
+	 */
+  CalypFrame* getPacked( CalypFrame*& pcPacked );
+
+  /**
+	 * Check if the frame is a view of another frame (see RegionModes)
+	 */
+  bool isView() const;
+
+  /**
+	 * Point a view to the area of the same size at (x, y) of another frame
+	 * (or move it in the same one; changes of the samples are seen anyway)
+	 * @return false if this is not a view, the format differs or the area does not fit
+	 */
+  bool setViewSource( const CalypFrame* other, unsigned int x, unsigned int y );
+
   /**
 	 * Get number of pixels of the frame
 	 * @param channel/component
@@ -226,6 +357,22 @@ public:
 	 */
   unsigned int getBitsPel() const;
 
+  /**
+	 * Get the size of the stored samples
+	 * @return 1 for frames up to 8 bits (see getBytePelBufferYUV), 2 otherwise
+	 */
+  unsigned int getSampleBytes() const;
+
+  /**
+	 * Set the matrix and range used to convert YUV into RGB
+	 * (ARGB buffer, toMat and getPixel with a color space)
+	 * @param colorMatrix conversion matrix (use CalypColorMatrix enum)
+	 * @param colorRange range of the YUV samples (use CalypColorRange enum)
+	 */
+  void setColorMatrix( int colorMatrix, int colorRange );
+  int getColorMatrix() const;
+  int getColorRange() const;
+
   /**
 	 * Get number of bytes per frame of an existing frame
 	 * @return number of bytes per frame
@@ -243,9 +390,33 @@ public:
 	 */
   void reset();
 
+  /**
+	 * Get the planes ([channel][row])
+	 * The non-const version is meant for writing: a frame sharing its planes
+	 * with copies of it takes a private copy first (copy-on-write). For
+	 * frames up to 8 bits this is the ClpPel copy of the byte planes (see
+	 * the write-back contract in the class description)
+	 *
+	 * The pointers can be written until the frame, its parent or one of its
+	 * views (REGION_VIEW) is accessed in any other way (byte planes, ARGB
+	 * buffer, histogram, quality, frameToBuffer, setPixel, copies, copyFrom
+	 * or assignment); call getPelBufferYUV again before writing after that.
+	 * Pointers from the const version may show older samples once the frame
+	 * changes; get them again as well
+	 */
   ClpPel*** getPelBufferYUV() const;
   ClpPel*** getPelBufferYUV();
 
+  /**
+	 * Get the native 8 bits planes ([channel][row]) of frames up to 8 bits
+	 * @return NULL for frames with more bits
+	 *
+	 * @note samples written through getPelBufferYUV() reach these planes
+	 *       (saturated at 255) the next time the frame is read
+	 */
+  ClpByte*** getBytePelBufferYUV() const;
+  ClpByte*** getBytePelBufferYUV();
+
   unsigned char* getRGBBuffer() const;
 
   /**
@@ -290,17 +461,43 @@ public:
 	 */
   void setPixel( unsigned int xPos, unsigned int yPos, CalypPixel pixel );
 
+  /**
+	 * Copy the samples of a frame of the same format
+	 * (the planes are shared until one of the frames is written)
+	 */
   void copyFrom( const CalypFrame& );
   void copyFrom( const CalypFrame* );
   void copyFrom( const CalypFrame&, unsigned int, unsigned int );
   void copyFrom( const CalypFrame*, unsigned int, unsigned int );
 
+  /**
+	 * Convert the samples of a frame of the same size into the format and
+	 * bits of this frame: chroma is resampled (420, 422, 444 and gray),
+	 * samples are shifted to the new bit depth with rounding and YUV/RGB
+	 * use the color matrix of the YUV frame at the bits of other
+	 * (CLP_MATRIX_DEFAULT is BT.601 full range). Missing chroma is set to the
+	 * middle value and missing alpha to the maximum
+	 * @return false if the sizes are different
+	 */
+  bool convertFrom( const CalypFrame& other );
+  bool convertFrom( const CalypFrame* other );
+
   void frameFromBuffer( ClpByte*, int, unsigned long );
   void frameFromBuffer( ClpByte*, int );
   void frameToBuffer( ClpByte*, int );
 
+  /**
+	 * Convert the frame into the ARGB buffer returned by getRGBBuffer
+	 * The buffer is allocated on the first call
+	 */
   void fillRGBBuffer();
 
+  /**
+	 * Give the ARGB buffer back to the frame pool
+	 * It is allocated again by the next fillRGBBuffer
+	 */
+  void releaseRGBBuffer();
+
   /**
 	 * Histogram
 	 */
@@ -320,7 +517,42 @@ public:
     HIST_ALL_CHANNELS = 254,
     HISTOGRAM_MAX = 255,
   };
-  void calcHistogram();
+  /**
+	 * Compute the histogram of every channel (and luma for RGB frames)
+	 * Rows are split across the worker pool; the call is skipped when
+	 * the histogram is up to date. The buffer is allocated on the first call
+	 *
+	 * @param uiGeneration getHistogramGeneration() when the computation was
+	 * requested: a cancelHistogram after that stops the call, even when it
+	 * comes before the call starts (current generation when not given)
+	 * @return true if the histogram is valid, false if cancelled
+	 */
+  bool calcHistogram();
+  bool calcHistogram( unsigned int uiGeneration );
+
+  /**
+	 * Get the generation to request a computation (see calcHistogram)
+	 */
+  unsigned int getHistogramGeneration() const;
+
+  /**
+	 * Cancel the computations requested so far (see calcHistogram), also
+	 * when they run in another thread. The histogram is left invalid and
+	 * will be computed on the next request
+	 */
+  void cancelHistogram();
+
+  /**
+	 * Give the histogram buffer back to the frame pool
+	 * (a computation running in another thread is cancelled first)
+	 */
+  void releaseHistogram();
+
+  /**
+	 * Release the ARGB and the histogram buffers and the ClpPel copy of the
+	 * planes of frames up to 8 bits, leaving only the planes
+	 */
+  void releaseSideBuffers();
 
   unsigned int getMinimumPelValue( int channel );
   unsigned int getMaximumPelValue( int channel );
@@ -335,8 +567,19 @@ public:
 
   /**
 	 * interface with OpenCV lib
+	 *
+	 * Samples are CV_8U for frames up to 8 bits and CV_16U otherwise,
+	 * except YUV frames converted to BGR which always give CV_8UC3
+	 * @param convertToGray get only the luma (YUV and gray frames)
+	 * @param shareData wrap the luma plane instead of copying it (gray
+	 *        output only): the Mat is read-only and valid while the frame
+	 *        exists and its samples are not changed
+	 */
+  bool toMat( cv::Mat& cvMat, bool convertToGray = false, bool shareData = false );
+  /**
+	 * Copy a CV_8U or CV_16U Mat (gray or BGR) into the frame; a frame
+	 * without format gets GRAY or BGR with 8 or 16 bits
 	 */
-  bool toMat( cv::Mat& cvMat, bool convertToGray = false );
   bool fromMat( cv::Mat& cvMat );
 
   /**
@@ -358,10 +601,69 @@ public:
 
   static std::vector<ClpString> supportedQualityMetricsList();
   double getQuality( int Metric, CalypFrame* Org, int component );
+  unsigned long long getSSD( CalypFrame* Org, int component );
   double getMSE( CalypFrame* Org, int component );
   double getPSNR( CalypFrame* Org, int component );
   double getSSIM( CalypFrame* Org, int component );
 
+  enum SSIMModes
+  {
+    SSIM_BLOCK_MODE = 0,  //!< Non-overlapping 8x8 windows (4x4 for chroma)
+    SSIM_GAUSSIAN_MODE,   //!< 11x11 Gaussian window at every position
+  };
+
+  /**
+	 * Structural similarity of one component
+	 * C1 and C2 follow the bit depth of the reference frame
+	 * @param Org reference frame
+	 * @param component component to compare
+	 * @param mode window type (use SSIMModes enum)
+	 */
+  double getSSIM( CalypFrame* Org, int component, int mode );
+
+  /**
+	 * Results of a batch quality evaluation
+	 * Entries of metrics or components not requested are left at zero
+	 */
+  struct QualityResult
+  {
+    double adQuality[NUMBER_METRICS][CALYP_PIXEL_MAX_COMPONENTS];
+  };
+
+  /**
+	 * Evaluate several metrics on several components at once
+	 * Each plane is read in a single pass shared by all metrics
+	 * (SSIM uses the block mode, as getSSIM( Org, component ))
+	 * @param metrics list of metrics (use QualityMetrics enum)
+	 * @param components list of components
+	 * @param Org reference frame
+	 * @param result output values indexed by metric and component
+	 */
+  void getQuality( const std::vector<int>& metrics, const std::vector<unsigned int>& components, CalypFrame* Org,
+                   QualityResult& result );
+
+  /**
+	 * Sum of squared differences between two buffers of samples
+	 * (vectorized and accumulated in 64-bit integers)
+	 * @param pA first buffer
+	 * @param pB second buffer
+	 * @param count number of samples
+	 * @param bitsPel bits per sample of both buffers
+	 */
+  static unsigned long long computeSSD( const ClpPel* pA, const ClpPel* pB, unsigned long count, unsigned int bitsPel = 16 );
+
+  /**
+	 * Sum of squared differences with each sample multiplied by a weight
+	 * @param weightSum returns the sum of all weights
+	 */
+  static unsigned long long computeWeightedSSD( const ClpPel* pA, const ClpPel* pB, const ClpPel* pWeights, unsigned long count,
+                                                unsigned long long& weightSum );
+
+  /**
+	 * Absolute difference between two buffers of samples
+	 */
+  static void computeAbsDiff( const ClpPel* pA, const ClpPel* pB, ClpPel* pOut, unsigned long count );
+
   /** @} */
 
 private:
@@ -77,6 +77,10 @@ enum Module_Type
  * \ingroup Calyp_Modules
  * Features/Requirements of a module
  * @see m_uiModuleRequirements
+ *
+ * Modules that walk the planes row by row (CalypFrame::getStride) set
+ * CLP_MODULE_USES_STRIDE; the others are handed packed copies of the
+ * input frames (see CalypFrame::getPacked)
  */
 enum Module_Features
 {
@@ -86,6 +90,7 @@ enum Module_Features
   CLP_MODULE_REQUIRES_NEW_WINDOW = 4,
   CLP_MODULE_USES_KEYS = 8,
   CLP_MODULES_VARIABLE_NUM_FRAMES = 16,
+  CLP_MODULE_USES_STRIDE = 32,
   CLP_MODULE_REQURES_MAX = 1024,
 };
 
@@ -24,27 +24,13 @@
 
 #include "CalypFrame.h"
 
+#include "ColorMatrix.h"
 #include "PixelFormats.h"
 #include "config.h"
 
-#define MAX_NUMBER_COMPONENTS 4
+#include <type_traits>
 
-struct CalypPixelPrivate
-{
-  CalypPixelPrivate( const int& ColorSpace )
-  {
-    iColorSpace = ColorSpace == CLP_COLOR_GRAY ?
-                      CLP_COLOR_YUV :
-                      ColorSpace;
-    for( int i = 0; i < MAX_NUMBER_COMPONENTS; i++ )
-    {
-      PelComp[i] = 0;
-    }
-  }
-
-  int iColorSpace;
-  ClpPel PelComp[MAX_NUMBER_COMPONENTS];
-};
+static_assert( std::is_trivially_copyable<CalypPixel>::value, "CalypPixel must remain a plain value type" );
 
 static inline void yuvToRgb( const int& iY, const int& iU, const int& iV, int& iR, int& iG, int& iB )
 {
@@ -65,89 +51,70 @@ static inline void rgbToYuv( const int& iR, const int& iG, const int& iB, int& i
 
 int CalypPixel::getMaxNumberOfComponents()
 {
-  return MAX_NUMBER_COMPONENTS;
+  return CALYP_PIXEL_MAX_COMPONENTS;
 }
 
 CalypPixel::CalypPixel( const int& ColorSpace )
-    : d( new CalypPixelPrivate( ColorSpace ) )
+    : m_iColorSpace( ColorSpace == CLP_COLOR_GRAY ? CLP_COLOR_YUV : ColorSpace )
 {
+  for( int i = 0; i < CALYP_PIXEL_MAX_COMPONENTS; i++ )
+  {
+    m_auiPelComp[i] = 0;
+  }
 }
 
 CalypPixel::CalypPixel( const int& ColorSpace, const ClpPel& c0 )
-    : d( new CalypPixelPrivate( ColorSpace ) )
+    : CalypPixel( ColorSpace )
 {
-  d->PelComp[0] = c0;
+  m_auiPelComp[0] = c0;
 }
 
 CalypPixel::CalypPixel( const int& ColorSpace, const ClpPel& c0, const ClpPel& c1, const ClpPel& c2 )
-    : d( new CalypPixelPrivate( ColorSpace ) )
+    : CalypPixel( ColorSpace )
 {
-  d->PelComp[0] = c0;
-  d->PelComp[1] = c1;
-  d->PelComp[2] = c2;
+  m_auiPelComp[0] = c0;
+  m_auiPelComp[1] = c1;
+  m_auiPelComp[2] = c2;
 }
 
 CalypPixel::CalypPixel( const int& ColorSpace, const ClpPel& c0, const ClpPel& c1, const ClpPel& c2, const ClpPel& c3 )
-    : d( new CalypPixelPrivate( ColorSpace ) )
-{
-  d->PelComp[0] = c0;
-  d->PelComp[1] = c1;
-  d->PelComp[2] = c2;
-  d->PelComp[3] = c3;
-}
-
-CalypPixel::CalypPixel( const CalypPixel& other )
-    : d( new CalypPixelPrivate( other.colorSpace() ) )
-{
-  for( int i = 0; i < MAX_NUMBER_COMPONENTS; i++ )
-  {
-    d->PelComp[i] = other[i];
-  }
-}
-
-CalypPixel::~CalypPixel()
+    : CalypPixel( ColorSpace )
 {
-  delete d;
+  m_auiPelComp[0] = c0;
+  m_auiPelComp[1] = c1;
+  m_auiPelComp[2] = c2;
+  m_auiPelComp[3] = c3;
 }
 
 int CalypPixel::colorSpace() const
 {
-  return d->iColorSpace;
+  return m_iColorSpace;
 }
 
 ClpPel CalypPixel::operator[]( const int& channel ) const
 {
-  return d->PelComp[channel];
+  return m_auiPelComp[channel];
 }
 ClpPel& CalypPixel::operator[]( const int& channel )
 {
-  return d->PelComp[channel];
-}
-
-CalypPixel CalypPixel::operator=( const CalypPixel& other )
-{
-  for( int i = 0; i < MAX_NUMBER_COMPONENTS; i++ )
-  {
-    d->PelComp[i] = other[i];
-  }
-  return *this;
+  return m_auiPelComp[channel];
 }
 
 CalypPixel CalypPixel::operator+( const CalypPixel& in )
 {
   CalypPixel result;
-  for( int i = 0; i < MAX_NUMBER_COMPONENTS; i++ )
+  for( int i = 0; i < CALYP_PIXEL_MAX_COMPONENTS; i++ )
   {
-    result[i] = d->PelComp[i] + in[i];
+    result[i] = m_auiPelComp[i] + in[i];
   }
   return result;
 }
 
 CalypPixel CalypPixel::operator+=( const CalypPixel& in )
 {
-  for( int i = 0; i < MAX_NUMBER_COMPONENTS; i++ )
+  for( int i = 0; i < CALYP_PIXEL_MAX_COMPONENTS; i++ )
   {
-    d->PelComp[i] += in[i];
+    m_auiPelComp[i] += in[i];
   }
   return *this;
 }
@@ -155,18 +122,18 @@ CalypPixel CalypPixel::operator+=( const CalypPixel& in )
 CalypPixel CalypPixel::operator-( const CalypPixel& in )
 {
   CalypPixel result;
-  for( int i = 0; i < MAX_NUMBER_COMPONENTS; i++ )
+  for( int i = 0; i < CALYP_PIXEL_MAX_COMPONENTS; i++ )
   {
-    result[i] = d->PelComp[i] - in[i];
+    result[i] = m_auiPelComp[i] - in[i];
   }
   return result;
 }
 
 CalypPixel CalypPixel::operator-=( const CalypPixel& in )
 {
-  for( int i = 0; i < MAX_NUMBER_COMPONENTS; i++ )
+  for( int i = 0; i < CALYP_PIXEL_MAX_COMPONENTS; i++ )
   {
-    d->PelComp[i] -= in[i];
+    m_auiPelComp[i] -= in[i];
   }
   return *this;
 }
@@ -174,46 +141,46 @@ CalypPixel CalypPixel::operator-=( const CalypPixel& in )
 CalypPixel CalypPixel::operator*( const double& op )
 {
   CalypPixel result;
-  for( int i = 0; i < MAX_NUMBER_COMPONENTS; i++ )
+  for( int i = 0; i < CALYP_PIXEL_MAX_COMPONENTS; i++ )
   {
-    result[i] = d->PelComp[i] * op;
+    result[i] = m_auiPelComp[i] * op;
   }
   return result;
 }
 
 CalypPixel CalypPixel::convertPixel( CalypColorSpace eOutputSpace )
 {
-  if( d->iColorSpace == eOutputSpace )
+  if( m_iColorSpace == eOutputSpace )
     return *this;
 
   int outA = 0;
   int outB = 0;
   int outC = 0;
   int outD = 0;
-  if( d->iColorSpace == CLP_COLOR_YUV )
+  if( m_iColorSpace == CLP_COLOR_YUV )
   {
     switch( eOutputSpace )
     {
     case CLP_COLOR_GRAY:
-      outA = d->PelComp[0];
+      outA = m_auiPelComp[0];
       break;
     case CLP_COLOR_RGBA:
       outD = 255;
     case CLP_COLOR_RGB:
-      yuvToRgb( d->PelComp[0], d->PelComp[1], d->PelComp[2], outA, outB, outC );
+      yuvToRgb( m_auiPelComp[0], m_auiPelComp[1], m_auiPelComp[2], outA, outB, outC );
       break;
     default:
       break;
     }
   }
-  if( d->iColorSpace == CLP_COLOR_RGB )
+  if( m_iColorSpace == CLP_COLOR_RGB )
   {
     switch( eOutputSpace )
     {
     case CLP_COLOR_GRAY:
-      rgbToYuv( d->PelComp[0], d->PelComp[1], d->PelComp[2], outA, outB, outC );
+      rgbToYuv( m_auiPelComp[0], m_auiPelComp[1], m_auiPelComp[2], outA, outB, outC );
     case CLP_COLOR_YUV:
-      rgbToYuv( d->PelComp[0], d->PelComp[1], d->PelComp[2], outA, outB, outC );
+      rgbToYuv( m_auiPelComp[0], m_auiPelComp[1], m_auiPelComp[2], outA, outB, outC );
       break;
     case CLP_COLOR_RGBA:
       outD = 255;
@@ -224,3 +191,49 @@ CalypPixel CalypPixel::convertPixel( CalypColorSpace eOutputSpace )
   }
   return CalypPixel( eOutputSpace, outA, outB, outC, outD );
 }
+
+CalypPixel CalypPixel::convertPixel( CalypColorSpace eOutputSpace, int colorMatrix, int colorRange, unsigned int bitsPel )
+{
+  if( colorMatrix == CLP_MATRIX_DEFAULT || m_iColorSpace == eOutputSpace )
+    return convertPixel( eOutputSpace );
+
+  int outA = 0;
+  int outB = 0;
+  int outC = 0;
+  int outD = 0;
+  if( m_iColorSpace == CLP_COLOR_YUV )
+  {
+    switch( eOutputSpace )
+    {
+    case CLP_COLOR_GRAY:
+      outA = m_auiPelComp[0];
+      break;
+    case CLP_COLOR_RGBA:
+      outD = ( 1 << bitsPel ) - 1;
+    case CLP_COLOR_RGB:
+      yuvToRgbMatrix( colorMatrix, colorRange, bitsPel, m_auiPelComp[0], m_auiPelComp[1], m_auiPelComp[2], outA, outB, outC );
+      break;
+    default:
+      break;
+    }
+  }
+  if( m_iColorSpace == CLP_COLOR_RGB )
+  {
+    switch( eOutputSpace )
+    {
+    case CLP_COLOR_GRAY:
+    case CLP_COLOR_YUV:
+      rgbToYuvMatrix( colorMatrix, colorRange, bitsPel, m_auiPelComp[0], m_auiPelComp[1], m_auiPelComp[2], outA, outB, outC );
+      break;
+    case CLP_COLOR_RGBA:
+      outA = m_auiPelComp[0];
+      outB = m_auiPelComp[1];
+      outC = m_auiPelComp[2];
+      outD = ( 1 << bitsPel ) - 1;
+      break;
+    default:
+      break;
+    }
+  }
+  return CalypPixel( eOutputSpace, outA, outB, outC, outD );
+}
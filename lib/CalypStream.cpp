@@ -38,7 +38,15 @@
 #include "StreamHandlerOpenCV.h"
 #endif
 
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
 #include <cstdio>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 std::vector<CalypStreamFormat> CalypStream::supportedReadFormats()
 {
@@ -68,6 +76,16 @@ std::vector<CalypStreamFormat> CalypStream::supportedWriteFormats()
   END_REGIST_CALYP_SUPPORTED_FMT;
 }
 
+void CalypStream::beginReadBatch()
+{
+  StreamHandlerRaw::beginReadBatch();
+}
+
+void CalypStream::endReadBatch()
+{
+  StreamHandlerRaw::endReadBatch();
+}
+
 std::vector<CalypStandardResolution> CalypStream::stdResolutionSizes()
 {
 #define REGIST_CALYP_STANDARD_RESOLUTION( name, width, height ) \
@@ -104,7 +122,7 @@ public:
   {
     for( unsigned int i = 0; i < size; i++ )
     {
-      CalypFrame* pFrame = new CalypFrame( width, height, pelFormat, bitsPixel );
+      CalypFrame* pFrame = new CalypFrame( width, height, pelFormat, bitsPixel, CalypFrame::ALIGNED_LAYOUT );
       m_apcFrameBuffer.push_back( pFrame );
     }
     m_uiIndex = 0;
@@ -118,16 +136,14 @@ public:
       m_apcFrameBuffer.pop_back();
     }
   }
-  void increase( unsigned int newSize )
+  unsigned int size() { return m_apcFrameBuffer.size(); }
+  void setColorMatrix( int colorMatrix, int colorRange )
   {
-    for( unsigned int i = m_apcFrameBuffer.size(); i < newSize; i++ )
-    {
-      CalypFrame* pFrame = new CalypFrame( m_apcFrameBuffer.at( 0 ) );
-      m_apcFrameBuffer.push_back( pFrame );
-    }
+    for( unsigned int i = 0; i < m_apcFrameBuffer.size(); i++ )
+      m_apcFrameBuffer[i]->setColorMatrix( colorMatrix, colorRange );
   }
-  unsigned int size() { return m_apcFrameBuffer.size(); }
   void setIndex( unsigned int i ) { m_uiIndex = i; }
+  unsigned int index() { return m_uiIndex; }
   CalypFrame* frame( int i ) { return m_apcFrameBuffer.at( i ); }
 
   CalypFrame* current() { return m_apcFrameBuffer.at( m_uiIndex ); }
@@ -139,6 +155,484 @@ private:
   inline int prevIndex() { return m_uiIndex - 1 < 0 ? m_apcFrameBuffer.size() - 1 : m_uiIndex - 1; }
 };
 
+/**
+ * Background reader that keeps the frames after the current one loaded.
+ * The frame buffer is used as a ring: the consumer owns the current slot
+ * and the reader fills the following ones until the ring is full. Both
+ * sides hand frames over through two counters (single producer, single
+ * consumer); the mutex is only taken to sleep on a full or empty ring
+ */
+class CalypStreamReaderPrivate
+{
+private:
+  CalypStreamHandlerIf* m_pcHandler;
+  CalypStreamBufferPrivate* m_pcFrameBuffer;
+  std::thread m_cThread;
+  std::mutex m_cMutex;
+  std::condition_variable m_cCond;
+  std::atomic<unsigned long> m_uiConsumed;  //!< Frames made current by the consumer
+  std::atomic<unsigned long> m_uiProduced;  //!< Frames loaded in the ring (including the current one)
+  std::atomic<bool> m_bStop;
+  std::atomic<bool> m_bEnd;    //!< No more frames in the stream
+  std::atomic<bool> m_bError;  //!< The handler failed to read a frame
+
+  void notify()
+  {
+    {
+      std::lock_guard<std::mutex> lock( m_cMutex );
+    }
+    m_cCond.notify_all();
+  }
+
+  void readLoop()
+  {
+    unsigned long slots = m_pcFrameBuffer->size();
+    while( !m_bStop )
+    {
+      unsigned long produced = m_uiProduced.load( std::memory_order_relaxed );
+      if( produced - m_uiConsumed.load( std::memory_order_acquire ) >= slots )
+      {
+        // Back-pressure: wait for the consumer to release a slot
+        std::unique_lock<std::mutex> lock( m_cMutex );
+        m_cCond.wait( lock, [&] { return m_bStop || produced - m_uiConsumed.load( std::memory_order_acquire ) < slots; } );
+        continue;
+      }
+      if( m_pcHandler->m_uiCurrFrameFileIdx >= m_pcHandler->m_uiTotalNumberFrames )
+      {
+        m_bEnd = true;
+        break;
+      }
+      bool bRead;
+      try
+      {
+        bRead = m_pcHandler->read( m_pcFrameBuffer->frame( produced % slots ) );
+      }
+      catch( ... )
+      {
+        bRead = false;
+      }
+      if( !bRead )
+      {
+        m_bError = true;
+        break;
+      }
+      m_uiProduced.store( produced + 1, std::memory_order_release );
+      notify();
+    }
+    notify();
+  }
+
+public:
+  CalypStreamReaderPrivate( CalypStreamHandlerIf* handler, CalypStreamBufferPrivate* frameBuffer )
+      : m_pcHandler( handler )
+      , m_pcFrameBuffer( frameBuffer )
+      , m_uiConsumed( 0 )
+      , m_uiProduced( 0 )
+      , m_bStop( false )
+      , m_bEnd( false )
+      , m_bError( false )
+  {
+  }
+
+  ~CalypStreamReaderPrivate() { stop(); }
+
+  /**
+   * Start reading after the current frame, which must be loaded in the
+   * current slot of the buffer with the handler positioned at the next frame
+   */
+  void start()
+  {
+    stop();
+    m_uiConsumed = m_pcFrameBuffer->index();
+    m_uiProduced = m_uiConsumed + 1;
+    m_bStop = false;
+    m_bEnd = false;
+    m_bError = false;
+    m_cThread = std::thread( &CalypStreamReaderPrivate::readLoop, this );
+  }
+
+  /**
+   * Stop the reader, the handler is free to be used by the caller
+   */
+  void stop()
+  {
+    if( !m_cThread.joinable() )
+      return;
+    m_bStop = true;
+    notify();
+    m_cThread.join();
+  }
+
+  /**
+   * Wait until the frame after the current one is loaded
+   * @return false if the stream has no more frames or the read failed
+   */
+  bool waitNext()
+  {
+    unsigned long consumed = m_uiConsumed.load( std::memory_order_relaxed );
+    if( m_uiProduced.load( std::memory_order_acquire ) > consumed + 1 )
+      return true;
+    std::unique_lock<std::mutex> lock( m_cMutex );
+    m_cCond.wait( lock, [&] { return m_uiProduced.load( std::memory_order_acquire ) > consumed + 1 || m_bEnd || m_bError || m_bStop; } );
+    return m_uiProduced.load( std::memory_order_acquire ) > consumed + 1;
+  }
+
+  bool failed() { return m_bError; }
+
+  /**
+   * Make the next frame current and hand the old slot back to the reader
+   * (only after waitNext returned true)
+   */
+  void advance()
+  {
+    m_pcFrameBuffer->setNextFrame();
+    m_uiConsumed.fetch_add( 1, std::memory_order_release );
+    notify();
+  }
+};
+
+/**
+ * Decoded frames kept by frame number, the least recently used frames
+ * are dropped to fit the memory budget. Cached frames share the planes
+ * of the frames they were taken from until one of them is rewritten
+ */
+class CalypStreamCachePrivate
+{
+private:
+  struct Entry
+  {
+    unsigned long uiFrameNum;
+    CalypFrame* pcFrame;
+    std::size_t uiBytes;
+  };
+  std::list<Entry> m_cEntries;  //!< Most recently used first
+  std::unordered_map<unsigned long, std::list<Entry>::iterator> m_cIndex;
+  std::size_t m_uiBudget;
+  CalypStreamCacheStats m_sStats;
+
+  void trim( std::size_t maxBytes )
+  {
+    while( m_sStats.uiBytesCached > maxBytes && !m_cEntries.empty() )
+    {
+      Entry& entry = m_cEntries.back();
+      m_sStats.uiBytesCached -= entry.uiBytes;
+      m_sStats.uiFrames--;
+      m_sStats.ullEvictions++;
+      m_cIndex.erase( entry.uiFrameNum );
+      delete entry.pcFrame;
+      m_cEntries.pop_back();
+    }
+  }
+
+public:
+  CalypStreamCachePrivate()
+      : m_uiBudget( 0 )
+  {
+    resetStats();
+    m_sStats.uiBytesCached = 0;
+    m_sStats.uiFrames = 0;
+  }
+
+  ~CalypStreamCachePrivate() { clear(); }
+
+  void setBudget( std::size_t bytes )
+  {
+    m_uiBudget = bytes;
+    trim( bytes );
+  }
+  std::size_t budget() { return m_uiBudget; }
+
+  /**
+   * Copy a cached frame into pcFrame
+   * @return false if the frame is not cached
+   */
+  bool get( unsigned long frameNum, CalypFrame* pcFrame )
+  {
+    if( m_uiBudget == 0 )
+      return false;
+    std::unordered_map<unsigned long, std::list<Entry>::iterator>::iterator it = m_cIndex.find( frameNum );
+    if( it == m_cIndex.end() )
+    {
+      m_sStats.ullMisses++;
+      return false;
+    }
+    m_cEntries.splice( m_cEntries.begin(), m_cEntries, it->second );
+    pcFrame->copyFrom( it->second->pcFrame );
+    m_sStats.ullHits++;
+    return true;
+  }
+
+  void put( unsigned long frameNum, const CalypFrame* pcFrame )
+  {
+    if( m_uiBudget == 0 )
+      return;
+    std::unordered_map<unsigned long, std::list<Entry>::iterator>::iterator it = m_cIndex.find( frameNum );
+    if( it != m_cIndex.end() )
+    {
+      m_cEntries.splice( m_cEntries.begin(), m_cEntries, it->second );
+      return;
+    }
+    Entry entry;
+    entry.uiFrameNum = frameNum;
+    entry.uiBytes = CalypFrame::getBytesPerFrame( pcFrame->getWidth(), pcFrame->getHeight(), pcFrame->getPelFormat(),
+                                                  pcFrame->getBitsPel() );
+    if( entry.uiBytes > m_uiBudget )
+      return;
+    entry.pcFrame = new CalypFrame( pcFrame );
+    m_cEntries.push_front( entry );
+    m_cIndex[frameNum] = m_cEntries.begin();
+    m_sStats.uiBytesCached += entry.uiBytes;
+    m_sStats.uiFrames++;
+    trim( m_uiBudget );
+  }
+
+  void clear()
+  {
+    trim( 0 );
+  }
+
+  CalypStreamCacheStats getStats() { return m_sStats; }
+  void resetStats()
+  {
+    m_sStats.ullHits = 0;
+    m_sStats.ullMisses = 0;
+    m_sStats.ullEvictions = 0;
+  }
+};
+
+/**
+ * Background loader of the frames around the current one. It reads with
+ * its own handler, next to the stream reader, and keeps the window of
+ * frames that fits the memory budget (a quarter of it behind the current
+ * frame). Frames leaving the window are freed as it moves
+ */
+class CalypStreamPreloadPrivate
+{
+private:
+  CalypStreamHandlerIf* m_pcHandler;
+  unsigned int m_uiWidth;
+  unsigned int m_uiHeight;
+  int m_iPelFormat;
+  unsigned int m_uiBitsPel;
+  unsigned long m_uiTotalFrames;
+  std::size_t m_uiBudget;
+  unsigned long m_uiWindowFrames;
+
+  std::thread m_cThread;
+  std::mutex m_cMutex;
+  std::condition_variable m_cCond;
+  std::map<unsigned long, CalypFrame*> m_cFrames;
+  unsigned long m_uiCenter;
+  bool m_bStop;
+  bool m_bFailed;
+
+  /**
+   * Frames [first, last) of the window (lock held)
+   */
+  void window( unsigned long& first, unsigned long& last )
+  {
+    first = m_uiCenter > m_uiWindowFrames / 4 ? m_uiCenter - m_uiWindowFrames / 4 : 0;
+    last = std::min( first + m_uiWindowFrames, m_uiTotalFrames );
+    first = last > m_uiWindowFrames ? last - m_uiWindowFrames : 0;
+  }
+
+  /**
+   * Free the frames outside the window and find the next one to load,
+   * going forward from the current frame first (lock held)
+   */
+  bool findMissing( unsigned long& frameNum )
+  {
+    unsigned long first, last;
+    window( first, last );
+    for( std::map<unsigned long, CalypFrame*>::iterator it = m_cFrames.begin(); it != m_cFrames.end(); )
+    {
+      if( it->first >= first && it->first < last )
+      {
+        ++it;
+        continue;
+      }
+      delete it->second;
+      it = m_cFrames.erase( it );
+    }
+    for( unsigned long n = m_uiCenter; n < last; n++ )
+    {
+      if( !m_cFrames.count( n ) )
+      {
+        frameNum = n;
+        return true;
+      }
+    }
+    for( unsigned long n = m_uiCenter; n > first; n-- )
+    {
+      if( !m_cFrames.count( n - 1 ) )
+      {
+        frameNum = n - 1;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void loadLoop()
+  {
+    std::unique_lock<std::mutex> lock( m_cMutex );
+    while( !m_bStop )
+    {
+      unsigned long frameNum;
+      if( !findMissing( frameNum ) )
+      {
+        m_cCond.wait( lock );
+        continue;
+      }
+      lock.unlock();
+      CalypFrame* pcFrame = NULL;
+      bool bRead;
+      try
+      {
+        pcFrame = new CalypFrame( m_uiWidth, m_uiHeight, m_iPelFormat, m_uiBitsPel, CalypFrame::ALIGNED_LAYOUT );
+        bRead = ( m_pcHandler->m_uiCurrFrameFileIdx == frameNum || m_pcHandler->seek( frameNum ) ) && m_pcHandler->read( pcFrame );
+      }
+      catch( ... )
+      {
+        bRead = false;
+      }
+      lock.lock();
+      if( !bRead )
+      {
+        // Out of memory or a bad stream, keep what is loaded
+        delete pcFrame;
+        m_bFailed = true;
+        break;
+      }
+      // Dropped in the next pass if the window moved meanwhile
+      m_cFrames[frameNum] = pcFrame;
+    }
+  }
+
+public:
+  CalypStreamPreloadPrivate( CreateStreamHandlerFn pfctCreateHandler, const CalypStreamHandlerIf* pcStreamHandler, std::size_t budget,
+                             unsigned long currFrameNum )
+      : m_pcHandler( NULL )
+      , m_uiWidth( pcStreamHandler->m_uiWidth )
+      , m_uiHeight( pcStreamHandler->m_uiHeight )
+      , m_iPelFormat( pcStreamHandler->m_iPixelFormat )
+      , m_uiBitsPel( pcStreamHandler->m_uiBitsPerPixel )
+      , m_uiTotalFrames( pcStreamHandler->m_uiTotalNumberFrames )
+      , m_uiBudget( budget )
+      , m_uiCenter( currFrameNum )
+      , m_bStop( false )
+      , m_bFailed( true )
+  {
+    std::size_t frameBytes = CalypFrame::getBytesPerFrame( m_uiWidth, m_uiHeight, m_iPelFormat, m_uiBitsPel );
+    m_uiWindowFrames = std::min( std::max( budget / frameBytes, std::size_t( 1 ) ), std::size_t( m_uiTotalFrames ) );
+
+    m_pcHandler = pfctCreateHandler();
+    if( !m_pcHandler )
+      return;
+    m_pcHandler->m_cFilename = pcStreamHandler->m_cFilename;
+    m_pcHandler->m_uiWidth = m_uiWidth;
+    m_pcHandler->m_uiHeight = m_uiHeight;
+    m_pcHandler->m_iPixelFormat = m_iPelFormat;
+    m_pcHandler->m_uiBitsPerPixel = m_uiBitsPel;
+    m_pcHandler->m_iEndianness = pcStreamHandler->m_iEndianness;
+    m_pcHandler->m_dFrameRate = pcStreamHandler->m_dFrameRate;
+    if( !m_pcHandler->openHandler( m_pcHandler->m_cFilename, true ) )
+    {
+      m_pcHandler->Delete();
+      m_pcHandler = NULL;
+      return;
+    }
+    m_pcHandler->m_uiNBytesPerFrame = pcStreamHandler->m_uiNBytesPerFrame;
+    m_pcHandler->calculateFrameNumber();
+    CalypFrame cFormatFrame( m_uiWidth, m_uiHeight, m_iPelFormat, m_uiBitsPel );
+    if( !m_pcHandler->configureBuffer( &cFormatFrame ) )
+      return;
+    m_bFailed = false;
+    m_cThread = std::thread( &CalypStreamPreloadPrivate::loadLoop, this );
+  }
+
+  ~CalypStreamPreloadPrivate()
+  {
+    if( m_cThread.joinable() )
+    {
+      {
+        std::lock_guard<std::mutex> lock( m_cMutex );
+        m_bStop = true;
+      }
+      m_cCond.notify_all();
+      m_cThread.join();
+    }
+    for( std::map<unsigned long, CalypFrame*>::iterator it = m_cFrames.begin(); it != m_cFrames.end(); ++it )
+      delete it->second;
+    if( m_pcHandler )
+    {
+      m_pcHandler->closeHandler();
+      m_pcHandler->Delete();
+    }
+  }
+
+  std::size_t budget() { return m_uiBudget; }
+
+  /**
+   * Move the window to a new current frame
+   */
+  void setCenter( unsigned long frameNum )
+  {
+    {
+      std::lock_guard<std::mutex> lock( m_cMutex );
+      if( m_uiCenter == frameNum )
+        return;
+      m_uiCenter = frameNum;
+    }
+    m_cCond.notify_all();
+  }
+
+  /**
+   * Copy a loaded frame into pcFrame
+   * @return false if the frame is not loaded yet
+   */
+  bool get( unsigned long frameNum, CalypFrame* pcFrame )
+  {
+    std::lock_guard<std::mutex> lock( m_cMutex );
+    std::map<unsigned long, CalypFrame*>::iterator it = m_cFrames.find( frameNum );
+    if( it == m_cFrames.end() )
+      return false;
+    pcFrame->copyFrom( it->second );
+    return true;
+  }
+
+  CalypStreamPreloadStatus getStatus()
+  {
+    std::lock_guard<std::mutex> lock( m_cMutex );
+    unsigned long first, last;
+    window( first, last );
+    CalypStreamPreloadStatus sStatus;
+    sStatus.uiBudget = m_uiBudget;
+    sStatus.uiWindowFirst = first;
+    sStatus.uiWindowFrames = last - first;
+    sStatus.uiLoadedFrames = 0;
+    for( std::map<unsigned long, CalypFrame*>::iterator it = m_cFrames.begin(); it != m_cFrames.end(); ++it )
+      if( it->first >= first && it->first < last )
+        sStatus.uiLoadedFrames++;
+    sStatus.bFailed = m_bFailed;
+    return sStatus;
+  }
+
+  std::vector<std::pair<unsigned int, unsigned int>> getRanges()
+  {
+    std::lock_guard<std::mutex> lock( m_cMutex );
+    std::vector<std::pair<unsigned int, unsigned int>> ranges;
+    for( std::map<unsigned long, CalypFrame*>::iterator it = m_cFrames.begin(); it != m_cFrames.end(); ++it )
+    {
+      if( !ranges.empty() && ranges.back().second + 1 == it->first )
+        ranges.back().second = it->first;
+      else
+        ranges.push_back( std::make_pair( it->first, it->first ) );
+    }
+    return ranges;
+  }
+};
+
 struct CalypStreamPrivate
 {
   bool isInit;
@@ -148,21 +642,40 @@ struct CalypStreamPrivate
   CreateStreamHandlerFn pfctCreateHandler;
 
   CalypStreamBufferPrivate* frameBuffer;
+  CalypStreamReaderPrivate* reader;  //!< NULL when frames are read synchronously
+  unsigned int uiReadAhead;
+  CalypStreamCachePrivate cache;
+  CalypStreamPreloadPrivate* preloader;
+  bool bNextPending;  //!< Frames come from the cache or the preloader, the handler is not positioned after the current one
 
   ClpString cFilename;
   long long int iCurrFrameNum;
-  bool bLoadAll;
+  int iColorMatrix;
+  int iColorRange;
 
   CalypStreamPrivate()
   {
     isInit = false;
     pfctCreateHandler = NULL;
     handler = NULL;
+    reader = NULL;
+    uiReadAhead = 0;
+    preloader = NULL;
+    bNextPending = false;
     isInput = true;
-    bLoadAll = false;
+    iColorMatrix = CLP_MATRIX_DEFAULT;
+    iColorRange = CLP_RANGE_FULL;
     iCurrFrameNum = -1;
     cFilename = "";
   }
+
+  /**
+   * Get a frame from the preloaded window or from the cache
+   */
+  bool fetchFrame( unsigned long frameNum, CalypFrame* pcFrame )
+  {
+    return ( preloader && preloader->get( frameNum, pcFrame ) ) || cache.get( frameNum, pcFrame );
+  }
 };
 
 std::vector<ClpString> CalypStreamFormat::getExts()
@@ -307,10 +820,13 @@ bool CalypStream::open( ClpString filename, unsigned int width, unsigned int hei
     return d->isInit;
   }
 
-  // Keep past, current and future frames
+  // Keep past, current and future frames (or the read-ahead ring)
+  unsigned int uiBufferSize = 1;
+  if( d->isInput )
+    uiBufferSize = d->uiReadAhead > 0 ? d->uiReadAhead + 1 : 3;
   try
   {
-    d->frameBuffer = new CalypStreamBufferPrivate( d->isInput ? 3 : 1, d->handler->m_uiWidth, d->handler->m_uiHeight,
+    d->frameBuffer = new CalypStreamBufferPrivate( uiBufferSize, d->handler->m_uiWidth, d->handler->m_uiHeight,
                                                    d->handler->m_iPixelFormat, d->handler->m_uiBitsPerPixel );
   }
   catch( CalypFailure& e )
@@ -320,6 +836,7 @@ bool CalypStream::open( ClpString filename, unsigned int width, unsigned int hei
     return d->isInit;
   }
 
+  d->frameBuffer->setColorMatrix( d->iColorMatrix, d->iColorRange );
   d->handler->m_uiNBytesPerFrame = d->frameBuffer->current()->getBytesPerFrame();
 
   // Some handlers need to know how long is a frame to get frame number
@@ -339,6 +856,9 @@ bool CalypStream::open( ClpString filename, unsigned int width, unsigned int hei
     return d->isInit;
   }
 
+  if( d->isInput && d->uiReadAhead > 0 )
+    d->reader = new CalypStreamReaderPrivate( d->handler, d->frameBuffer );
+
   d->iCurrFrameNum = -1;
   d->isInit = true;
 
@@ -350,6 +870,11 @@ bool CalypStream::open( ClpString filename, unsigned int width, unsigned int hei
 
 bool CalypStream::reload()
 {
+  if( d->reader )
+    d->reader->stop();
+  std::size_t uiPreloadBudget = d->preloader ? d->preloader->budget() : 0;
+  delete d->preloader;
+  d->preloader = NULL;
   d->handler->closeHandler();
   if( !d->handler->openHandler( d->cFilename, d->isInput ) )
   {
@@ -369,6 +894,10 @@ bool CalypStream::reload()
   {
     d->iCurrFrameNum = 0;
   }
+  // The file may have changed
+  d->cache.clear();
+  if( uiPreloadBudget > 0 )
+    d->preloader = new CalypStreamPreloadPrivate( d->pfctCreateHandler, d->handler, uiPreloadBudget, d->iCurrFrameNum );
   int currFrameNum = d->iCurrFrameNum;
   d->iCurrFrameNum = -1;
   seekInput( currFrameNum );
@@ -380,12 +909,18 @@ void CalypStream::close()
   if( !d->isInit )
     return;
 
+  delete d->reader;
+  d->reader = NULL;
+  delete d->preloader;
+  d->preloader = NULL;
+  d->cache.clear();
+  d->bNextPending = false;
+
   d->handler->closeHandler();
   d->handler->Delete();
 
   delete d->frameBuffer;
 
-  d->bLoadAll = false;
   d->isInit = false;
 }
 
@@ -448,28 +983,124 @@ void CalypStream::getFormat( unsigned int& rWidth, unsigned int& rHeight, int& r
   }
 }
 
-void CalypStream::loadAll()
+void CalypStream::setColorMatrix( int colorMatrix, int colorRange )
 {
-  if( d->bLoadAll || !d->isInput )
+  d->iColorMatrix = colorMatrix;
+  d->iColorRange = colorRange;
+  if( d->isInit )
+    d->frameBuffer->setColorMatrix( colorMatrix, colorRange );
+}
+
+int CalypStream::getColorMatrix() const
+{
+  return d->iColorMatrix;
+}
+
+int CalypStream::getColorRange() const
+{
+  return d->iColorRange;
+}
+
+void CalypStream::setReadAhead( unsigned int frames )
+{
+  if( frames == d->uiReadAhead )
+    return;
+  d->uiReadAhead = frames;
+  if( !d->isInit || !d->isInput )
     return;
 
+  // Rebuild the frame buffer with the new ring size and reload the current frame
+  delete d->reader;
+  d->reader = NULL;
+  CalypStreamBufferPrivate* newBuffer;
   try
   {
-    d->frameBuffer->increase( d->handler->m_uiTotalNumberFrames );
+    newBuffer = new CalypStreamBufferPrivate( frames > 0 ? frames + 1 : 3, d->handler->m_uiWidth, d->handler->m_uiHeight,
+                                              d->handler->m_iPixelFormat, d->handler->m_uiBitsPerPixel );
   }
   catch( CalypFailure& e )
   {
     close();
-    throw CalypFailure( "CalypStream", "Cannot allocated frame buffer for the whole stream" );
+    throw CalypFailure( "CalypStream", "Cannot allocated frame buffer" );
   }
+  delete d->frameBuffer;
+  d->frameBuffer = newBuffer;
+  d->frameBuffer->setColorMatrix( d->iColorMatrix, d->iColorRange );
+  if( frames > 0 )
+    d->reader = new CalypStreamReaderPrivate( d->handler, d->frameBuffer );
 
-  seekInput( 0 );
-  for( unsigned int i = 2; i < d->frameBuffer->size(); i++ )
-  {
-    readFrame( d->frameBuffer->frame( i ) );
-  }
-  d->bLoadAll = true;
-  d->iCurrFrameNum = 0;
+  long long int currFrameNum = d->iCurrFrameNum;
+  d->iCurrFrameNum = -1;
+  seekInput( currFrameNum );
+}
+
+unsigned int CalypStream::getReadAhead() const
+{
+  return d->uiReadAhead;
+}
+
+void CalypStream::setCacheBudget( std::size_t bytes )
+{
+  d->cache.setBudget( bytes );
+}
+
+std::size_t CalypStream::getCacheBudget() const
+{
+  return d->cache.budget();
+}
+
+CalypStreamCacheStats CalypStream::getCacheStats() const
+{
+  return d->cache.getStats();
+}
+
+void CalypStream::resetCacheStats()
+{
+  d->cache.resetStats();
+}
+
+void CalypStream::preload( std::size_t bytes )
+{
+  if( !d->isInit || !d->isInput )
+    return;
+  delete d->preloader;
+  d->preloader = NULL;
+  if( bytes > 0 )
+    d->preloader = new CalypStreamPreloadPrivate( d->pfctCreateHandler, d->handler, bytes, d->iCurrFrameNum );
+
+  // Reload the next frames from the preloader (or the stream reader when stopping)
+  long long int currFrameNum = d->iCurrFrameNum;
+  d->iCurrFrameNum = -1;
+  seekInput( currFrameNum );
+}
+
+CalypStreamPreloadStatus CalypStream::getPreloadStatus() const
+{
+  if( d->preloader )
+    return d->preloader->getStatus();
+  CalypStreamPreloadStatus sStatus;
+  sStatus.uiBudget = 0;
+  sStatus.uiWindowFirst = 0;
+  sStatus.uiWindowFrames = 0;
+  sStatus.uiLoadedFrames = 0;
+  sStatus.bFailed = false;
+  return sStatus;
+}
+
+std::vector<std::pair<unsigned int, unsigned int>> CalypStream::getPreloadedRanges() const
+{
+  if( d->preloader )
+    return d->preloader->getRanges();
+  return std::vector<std::pair<unsigned int, unsigned int>>();
+}
+
+void CalypStream::loadAll()
+{
+  if( !d->isInit || !d->isInput )
+    return;
+  preload( std::size_t( d->handler->m_uiTotalNumberFrames ) *
+           CalypFrame::getBytesPerFrame( d->handler->m_uiWidth, d->handler->m_uiHeight, d->handler->m_iPixelFormat,
+                                         d->handler->m_uiBitsPerPixel ) );
 }
 
 void CalypStream::getDuration( int* duration_array )
@@ -500,9 +1131,6 @@ bool CalypStream::readFrame( CalypFrame* frame )
   if( !d->isInit || !d->isInput || d->handler->m_uiCurrFrameFileIdx >= d->handler->m_uiTotalNumberFrames )
     return false;
 
-  if( d->bLoadAll )
-    return true;
-
   if( !d->handler->read( frame ) )
   {
     throw CalypFailure( "CalypStream", "Cannot read frame from stream" );
@@ -549,8 +1177,20 @@ bool CalypStream::setNextFrame()
 
   if( d->iCurrFrameNum + 1 < (long)( d->handler->m_uiTotalNumberFrames ) )
   {
-    d->frameBuffer->setNextFrame();
+    if( d->reader && !d->bNextPending )
+    {
+      if( !d->reader->waitNext() )
+        throw CalypFailure( "CalypStream", "Cannot read frame from stream" );
+      d->reader->advance();
+    }
+    else
+    {
+      d->frameBuffer->setNextFrame();
+    }
     d->iCurrFrameNum++;
+    if( d->preloader )
+      d->preloader->setCenter( d->iCurrFrameNum );
+    d->cache.put( d->iCurrFrameNum, d->frameBuffer->current() );
   }
   else
   {
@@ -561,6 +1201,31 @@ bool CalypStream::setNextFrame()
 
 void CalypStream::readNextFrame()
 {
+  if( d->bNextPending )
+  {
+    unsigned long nextFrameNum = d->iCurrFrameNum + 1;
+    if( nextFrameNum >= d->handler->m_uiTotalNumberFrames || d->fetchFrame( nextFrameNum, d->frameBuffer->next() ) )
+      return;
+    // Continue from the stream
+    if( d->handler->m_uiCurrFrameFileIdx != nextFrameNum && !d->handler->seek( nextFrameNum ) )
+      throw CalypFailure( "CalypStream", "Cannot seek file into desired position" );
+    if( d->preloader )
+    {
+      // Not loaded yet, the preloader replaces the stream reader
+      readFrame( d->frameBuffer->next() );
+      return;
+    }
+    d->bNextPending = false;
+    if( d->reader )
+      d->reader->start();
+  }
+  if( d->reader )
+  {
+    // The reader loads it, only wait for it (if there is one)
+    if( !d->reader->waitNext() && d->reader->failed() )
+      throw CalypFailure( "CalypStream", "Cannot read frame from stream" );
+    return;
+  }
   readFrame( d->frameBuffer->next() );
 }
 
@@ -594,7 +1259,7 @@ bool CalypStream::seekInputRelative( bool bIsFoward )
   if( bIsFoward )
   {
     bRet = !setNextFrame();
-    readFrame( d->frameBuffer->next() );
+    readNextFrame();
   }
   else
   {
@@ -611,20 +1276,34 @@ bool CalypStream::seekInput( unsigned long new_frame_num )
 
   d->iCurrFrameNum = new_frame_num;
 
-  if( d->bLoadAll )
+  if( d->reader )
+    d->reader->stop();
+  if( d->preloader )
+    d->preloader->setCenter( d->iCurrFrameNum );
+
+  d->frameBuffer->setIndex( 0 );
+  d->bNextPending = false;
+  bool bFetched = d->fetchFrame( d->iCurrFrameNum, d->frameBuffer->current() );
+  if( !bFetched )
   {
-    d->frameBuffer->setIndex( d->iCurrFrameNum );
-    return true;
+    if( !d->handler->seek( d->iCurrFrameNum ) )
+    {
+      throw CalypFailure( "CalypStream", "Cannot seek file into desired position" );
+    }
+    readFrame( d->frameBuffer->current() );
+    d->cache.put( d->iCurrFrameNum, d->frameBuffer->current() );
   }
-
-  if( !d->handler->seek( d->iCurrFrameNum ) )
+  if( bFetched || d->preloader )
   {
-    throw CalypFailure( "CalypStream", "Cannot seek file into desired position" );
+    // Leave the handler untouched while the following frames are in memory
+    d->bNextPending = true;
+    readNextFrame();
+    return true;
   }
 
-  d->frameBuffer->setIndex( 0 );
-  readFrame( d->frameBuffer->current() );
-  if( d->handler->m_uiTotalNumberFrames > 1 )
+  if( d->reader )
+    d->reader->start();
+  else if( d->handler->m_uiTotalNumberFrames > 1 )
     readFrame( d->frameBuffer->next() );
 
   return true;
@@ -42,6 +42,30 @@ typedef struct
   CreateStreamHandlerFn formatFct;
 } CalypStreamFormat;
 
+/**
+ * Usage counters of the decoded frames cache of a stream
+ */
+struct CalypStreamCacheStats
+{
+  unsigned long long ullHits;       //!< Frames served from memory
+  unsigned long long ullMisses;     //!< Frames read from the stream
+  unsigned long long ullEvictions;  //!< Frames dropped to fit the budget
+  std::size_t uiBytesCached;        //!< Bytes of the cached frames
+  unsigned int uiFrames;            //!< Number of cached frames
+};
+
+/**
+ * Progress of the preload of a stream
+ */
+struct CalypStreamPreloadStatus
+{
+  std::size_t uiBudget;         //!< Memory budget (0 when not preloading)
+  unsigned int uiWindowFirst;   //!< First frame of the window around the current one
+  unsigned int uiWindowFrames;  //!< Frames of the window (as many as fit the budget)
+  unsigned int uiLoadedFrames;  //!< Frames of the window already loaded
+  bool bFailed;                 //!< Preloading stopped on a read or allocation error
+};
+
 typedef struct
 {
   ClpString shortName;
@@ -88,6 +112,50 @@ public:
   void getFormat( unsigned int& rWidth, unsigned int& rHeight, int& rInputFormat, unsigned int& rBitsPerPel, int& rEndianness,
                   unsigned int& rFrameRate );
 
+  /**
+   * Set the matrix and range used to display the YUV frames of this stream
+   * (use CalypColorMatrix and CalypColorRange enums)
+   */
+  void setColorMatrix( int colorMatrix, int colorRange );
+  int getColorMatrix() const;
+  int getColorRange() const;
+
+  /**
+   * Number of frames loaded by a background reader ahead of the current
+   * one (0, the default, reads the next frame in readNextFrame). The
+   * reader is paused while seeking and replaced by the preloader
+   */
+  void setReadAhead( unsigned int frames );
+  unsigned int getReadAhead() const;
+
+  /**
+   * Memory budget of the cache of decoded frames (0, the default,
+   * disables it). Frames that become current are kept by frame number
+   * and seeks to a cached frame, including backward steps, do not read
+   * from the stream
+   */
+  void setCacheBudget( std::size_t bytes );
+  std::size_t getCacheBudget() const;
+  CalypStreamCacheStats getCacheStats() const;
+  void resetCacheStats();
+
+  /**
+   * Load in background the frames around the current one that fit in a
+   * memory budget: a quarter of the window behind it and the rest ahead.
+   * The window follows the current frame and frames leaving it are freed
+   * (0 stops preloading)
+   */
+  void preload( std::size_t bytes );
+  CalypStreamPreloadStatus getPreloadStatus() const;
+
+  /**
+   * Loaded frames as ranges [first, last] of consecutive frame numbers
+   */
+  std::vector<std::pair<unsigned int, unsigned int>> getPreloadedRanges() const;
+
+  /**
+   * Preload the whole stream
+   */
   void loadAll();
 
   void writeFrame();
@@ -98,6 +166,14 @@ public:
 
   CalypFrame* getCurrFrame( CalypFrame* );
 
+  /**
+   * Reads of the next frames started by any stream until endReadBatch()
+   * are handed to the system together. Use it around the frame advance of
+   * streams read in lockstep (only raw streams read with io_uring batch)
+   */
+  static void beginReadBatch();
+  static void endReadBatch();
+
   // continuous read control
   bool setNextFrame();
   void readNextFrame();
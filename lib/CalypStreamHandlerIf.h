@@ -65,6 +65,8 @@ public:                                                          \
 class CalypStreamHandlerIf
 {
   friend class CalypStream;
+  friend class CalypStreamReaderPrivate;
+  friend class CalypStreamPreloadPrivate;
 
 public:
   CalypStreamHandlerIf()
@@ -0,0 +1,295 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     ColorMatrix.cpp
+ * \brief    YUV/RGB conversion matrices (BT.601, BT.709 and BT.2020)
+ */
+
+#include "ColorMatrix.h"
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+
+/**
+ * Luma weights of the red and blue components
+ */
+static void getLumaWeights( int colorMatrix, double& dKr, double& dKb )
+{
+  switch( colorMatrix )
+  {
+  case CLP_MATRIX_BT709:
+    dKr = 0.2126;
+    dKb = 0.0722;
+    break;
+  case CLP_MATRIX_BT2020:
+    dKr = 0.2627;
+    dKb = 0.0593;
+    break;
+  case CLP_MATRIX_BT601:
+  default:
+    dKr = 0.299;
+    dKb = 0.114;
+    break;
+  }
+}
+
+/**
+ * Offset and scale that map samples into [0, 1] for luma
+ * and [-0.5, 0.5] for chroma
+ */
+static void getRangeScaling( int colorRange, unsigned int bitsPel, double& dOffY, double& dScaleY, double& dOffC, double& dScaleC )
+{
+  double dRangeShift = double( 1 << ( bitsPel - 8 ) );
+  dOffC = double( 1 << ( bitsPel - 1 ) );
+  if( colorRange == CLP_RANGE_LIMITED )
+  {
+    dOffY = 16 * dRangeShift;
+    dScaleY = 219 * dRangeShift;
+    dScaleC = 224 * dRangeShift;
+  }
+  else
+  {
+    dOffY = 0;
+    dScaleY = double( ( 1 << bitsPel ) - 1 );
+    dScaleC = dScaleY;
+  }
+}
+
+static inline int clipSample( int value, int maxValue )
+{
+  return value < 0 ? 0 : value > maxValue ? maxValue : value;
+}
+
+static CalypYuvToRgbLut* buildYuvToRgbLut( int colorMatrix, int colorRange, unsigned int bitsPel )
+{
+  double dKr, dKb, dOffY, dScaleY, dOffC, dScaleC;
+  getLumaWeights( colorMatrix, dKr, dKb );
+  getRangeScaling( colorRange, bitsPel, dOffY, dScaleY, dOffC, dScaleC );
+  double dKg = 1.0 - dKr - dKb;
+
+  double dOutScale = 255.0 * double( 1 << CLP_COLOR_LUT_SHIFT );
+  double dCoeffRV = 2.0 * ( 1.0 - dKr );
+  double dCoeffGU = 2.0 * dKb * ( 1.0 - dKb ) / dKg;
+  double dCoeffGV = 2.0 * dKr * ( 1.0 - dKr ) / dKg;
+  double dCoeffBU = 2.0 * ( 1.0 - dKb );
+
+  CalypYuvToRgbLut* lut = new CalypYuvToRgbLut;
+  unsigned int size = 1 << bitsPel;
+  lut->uiMaxIndex = size - 1;
+  lut->aiY.resize( size );
+  lut->aiRV.resize( size );
+  lut->aiGU.resize( size );
+  lut->aiGV.resize( size );
+  lut->aiBU.resize( size );
+  for( unsigned int i = 0; i < size; i++ )
+  {
+    double dY = ( double( i ) - dOffY ) / dScaleY;
+    double dC = ( double( i ) - dOffC ) / dScaleC;
+    lut->aiY[i] = int( std::lround( dY * dOutScale ) ) + ( 1 << ( CLP_COLOR_LUT_SHIFT - 1 ) );
+    lut->aiRV[i] = int( std::lround( dCoeffRV * dC * dOutScale ) );
+    lut->aiGU[i] = -int( std::lround( dCoeffGU * dC * dOutScale ) );
+    lut->aiGV[i] = -int( std::lround( dCoeffGV * dC * dOutScale ) );
+    lut->aiBU[i] = int( std::lround( dCoeffBU * dC * dOutScale ) );
+  }
+  return lut;
+}
+
+const CalypYuvToRgbLut* getYuvToRgbLut( int colorMatrix, int colorRange, unsigned int bitsPel )
+{
+  static std::mutex s_cMutex;
+  static std::map<int, std::unique_ptr<CalypYuvToRgbLut>> s_cLuts;
+
+  int key = ( colorMatrix * 2 + colorRange ) * 32 + bitsPel;
+  std::lock_guard<std::mutex> lock( s_cMutex );
+  std::unique_ptr<CalypYuvToRgbLut>& lut = s_cLuts[key];
+  if( !lut )
+    lut.reset( buildYuvToRgbLut( colorMatrix, colorRange, bitsPel ) );
+  return lut.get();
+}
+
+template <typename T>
+static void yuvToArgbRowLutImpl( const CalypYuvToRgbLut* lut, const T* pY, const T* pU, const T* pV, unsigned int* pARGB,
+                                 unsigned int width, unsigned int log2ChromaWidth )
+{
+  const int* piY = lut->aiY.data();
+  const int* piRV = lut->aiRV.data();
+  const int* piGU = lut->aiGU.data();
+  const int* piGV = lut->aiGV.data();
+  const int* piBU = lut->aiBU.data();
+  unsigned int maxIdx = lut->uiMaxIndex;
+
+  for( unsigned int x = 0; x < width; x++ )
+  {
+    unsigned int xChroma = x >> log2ChromaWidth;
+    int iY = piY[std::min<unsigned int>( pY[x], maxIdx )];
+    unsigned int iU = std::min<unsigned int>( pU[xChroma], maxIdx );
+    unsigned int iV = std::min<unsigned int>( pV[xChroma], maxIdx );
+    int iR = clipSample( ( iY + piRV[iV] ) >> CLP_COLOR_LUT_SHIFT, 255 );
+    int iG = clipSample( ( iY + piGU[iU] + piGV[iV] ) >> CLP_COLOR_LUT_SHIFT, 255 );
+    int iB = clipSample( ( iY + piBU[iU] ) >> CLP_COLOR_LUT_SHIFT, 255 );
+    pARGB[x] = 0xff000000u | ( iR << 16 ) | ( iG << 8 ) | iB;
+  }
+}
+
+void yuvToArgbRowLut( const CalypYuvToRgbLut* lut, const ClpPel* pY, const ClpPel* pU, const ClpPel* pV, unsigned int* pARGB,
+                      unsigned int width, unsigned int log2ChromaWidth )
+{
+  yuvToArgbRowLutImpl( lut, pY, pU, pV, pARGB, width, log2ChromaWidth );
+}
+
+void yuvToArgbRowLut( const CalypYuvToRgbLut* lut, const ClpByte* pY, const ClpByte* pU, const ClpByte* pV, unsigned int* pARGB,
+                      unsigned int width, unsigned int log2ChromaWidth )
+{
+  yuvToArgbRowLutImpl( lut, pY, pU, pV, pARGB, width, log2ChromaWidth );
+}
+
+void yuvToRgbMatrix( int colorMatrix, int colorRange, unsigned int bitsPel, int iY, int iU, int iV, int& iR, int& iG, int& iB )
+{
+  double dKr, dKb, dOffY, dScaleY, dOffC, dScaleC;
+  getLumaWeights( colorMatrix, dKr, dKb );
+  getRangeScaling( colorRange, bitsPel, dOffY, dScaleY, dOffC, dScaleC );
+  double dKg = 1.0 - dKr - dKb;
+  int maxValue = ( 1 << bitsPel ) - 1;
+
+  double dY = ( iY - dOffY ) / dScaleY;
+  double dU = ( iU - dOffC ) / dScaleC;
+  double dV = ( iV - dOffC ) / dScaleC;
+  double dR = dY + 2.0 * ( 1.0 - dKr ) * dV;
+  double dG = dY - ( 2.0 * dKb * ( 1.0 - dKb ) * dU + 2.0 * dKr * ( 1.0 - dKr ) * dV ) / dKg;
+  double dB = dY + 2.0 * ( 1.0 - dKb ) * dU;
+  iR = clipSample( int( std::lround( dR * maxValue ) ), maxValue );
+  iG = clipSample( int( std::lround( dG * maxValue ) ), maxValue );
+  iB = clipSample( int( std::lround( dB * maxValue ) ), maxValue );
+}
+
+void rgbToYuvMatrix( int colorMatrix, int colorRange, unsigned int bitsPel, int iR, int iG, int iB, int& iY, int& iU, int& iV )
+{
+  double dKr, dKb, dOffY, dScaleY, dOffC, dScaleC;
+  getLumaWeights( colorMatrix, dKr, dKb );
+  getRangeScaling( colorRange, bitsPel, dOffY, dScaleY, dOffC, dScaleC );
+  double dKg = 1.0 - dKr - dKb;
+  int maxValue = ( 1 << bitsPel ) - 1;
+
+  double dR = double( iR ) / maxValue;
+  double dG = double( iG ) / maxValue;
+  double dB = double( iB ) / maxValue;
+  double dY = dKr * dR + dKg * dG + dKb * dB;
+  double dU = ( dB - dY ) / ( 2.0 * ( 1.0 - dKb ) );
+  double dV = ( dR - dY ) / ( 2.0 * ( 1.0 - dKr ) );
+  iY = clipSample( int( std::lround( dY * dScaleY + dOffY ) ), maxValue );
+  iU = clipSample( int( std::lround( dU * dScaleC + dOffC ) ), maxValue );
+  iV = clipSample( int( std::lround( dV * dScaleC + dOffC ) ), maxValue );
+}
+
+/**
+ * Store a 3x3 matrix and the offsets of its output components, subtracting
+ * the input offsets (which are applied before the matrix)
+ */
+static void setTransform( const double adMatrix[3][3], const double* adInOffset, const double* adOutOffset, float* coeffs )
+{
+  for( int c = 0; c < 3; c++ )
+  {
+    double dOffset = adOutOffset[c];
+    for( int k = 0; k < 3; k++ )
+    {
+      coeffs[4 * c + k] = float( adMatrix[c][k] );
+      dOffset -= adMatrix[c][k] * adInOffset[k];
+    }
+    coeffs[4 * c + 3] = float( dOffset );
+  }
+}
+
+void getYuvToRgbTransform( int colorMatrix, int colorRange, unsigned int bitsPel, float* coeffs )
+{
+  double dKr, dKb, dOffY, dScaleY, dOffC, dScaleC;
+  getLumaWeights( colorMatrix, dKr, dKb );
+  getRangeScaling( colorRange, bitsPel, dOffY, dScaleY, dOffC, dScaleC );
+  double dKg = 1.0 - dKr - dKb;
+  double dMax = double( ( 1 << bitsPel ) - 1 );
+  double dY = dMax / dScaleY;
+  double dC = dMax / dScaleC;
+
+  const double adMatrix[3][3] = {
+    { dY, 0.0, 2.0 * ( 1.0 - dKr ) * dC },
+    { dY, -2.0 * dKb * ( 1.0 - dKb ) / dKg * dC, -2.0 * dKr * ( 1.0 - dKr ) / dKg * dC },
+    { dY, 2.0 * ( 1.0 - dKb ) * dC, 0.0 },
+  };
+  const double adInOffset[3] = { dOffY, dOffC, dOffC };
+  const double adOutOffset[3] = { 0.0, 0.0, 0.0 };
+  setTransform( adMatrix, adInOffset, adOutOffset, coeffs );
+}
+
+void getRgbToYuvTransform( int colorMatrix, int colorRange, unsigned int bitsPel, float* coeffs )
+{
+  double dKr, dKb, dOffY, dScaleY, dOffC, dScaleC;
+  getLumaWeights( colorMatrix, dKr, dKb );
+  getRangeScaling( colorRange, bitsPel, dOffY, dScaleY, dOffC, dScaleC );
+  double dKg = 1.0 - dKr - dKb;
+  double dMax = double( ( 1 << bitsPel ) - 1 );
+  double dY = dScaleY / dMax;
+  double dU = dScaleC / dMax / ( 2.0 * ( 1.0 - dKb ) );
+  double dV = dScaleC / dMax / ( 2.0 * ( 1.0 - dKr ) );
+
+  const double adMatrix[3][3] = {
+    { dKr * dY, dKg * dY, dKb * dY },
+    { -dKr * dU, -dKg * dU, ( 1.0 - dKb ) * dU },
+    { ( 1.0 - dKr ) * dV, -dKg * dV, -dKb * dV },
+  };
+  const double adInOffset[3] = { 0.0, 0.0, 0.0 };
+  const double adOutOffset[3] = { dOffY, dOffC, dOffC };
+  setTransform( adMatrix, adInOffset, adOutOffset, coeffs );
+}
+
+template <typename T>
+static void rgbToLumaRowMatrixImpl( int colorMatrix, int colorRange, unsigned int bitsPel, const T* pR, const T* pG, const T* pB,
+                                    T* pY, unsigned int width )
+{
+  // 14 fractional bits keep 16 bits samples inside 32-bit integers
+  const int iShift = 14;
+  double dKr, dKb, dOffY, dScaleY, dOffC, dScaleC;
+  getLumaWeights( colorMatrix, dKr, dKb );
+  getRangeScaling( colorRange, bitsPel, dOffY, dScaleY, dOffC, dScaleC );
+  int maxValue = ( 1 << bitsPel ) - 1;
+  double dScale = dScaleY / maxValue * double( 1 << iShift );
+  int iKr = int( std::lround( dKr * dScale ) );
+  int iKb = int( std::lround( dKb * dScale ) );
+  int iKg = int( std::lround( dScaleY / maxValue * double( 1 << iShift ) ) ) - iKr - iKb;
+  int iOffset = int( std::lround( dOffY * double( 1 << iShift ) ) ) + ( 1 << ( iShift - 1 ) );
+
+  for( unsigned int x = 0; x < width; x++ )
+  {
+    int iY = ( iKr * pR[x] + iKg * pG[x] + iKb * pB[x] + iOffset ) >> iShift;
+    pY[x] = clipSample( iY, maxValue );
+  }
+}
+
+void rgbToLumaRowMatrix( int colorMatrix, int colorRange, unsigned int bitsPel, const ClpPel* pR, const ClpPel* pG,
+                         const ClpPel* pB, ClpPel* pY, unsigned int width )
+{
+  rgbToLumaRowMatrixImpl( colorMatrix, colorRange, bitsPel, pR, pG, pB, pY, width );
+}
+
+void rgbToLumaRowMatrix( int colorMatrix, int colorRange, unsigned int bitsPel, const ClpByte* pR, const ClpByte* pG,
+                         const ClpByte* pB, ClpByte* pY, unsigned int width )
+{
+  rgbToLumaRowMatrixImpl( colorMatrix, colorRange, bitsPel, pR, pG, pB, pY, width );
+}
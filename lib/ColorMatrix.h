@@ -0,0 +1,104 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     ColorMatrix.h
+ * \ingroup  CalypFrameGrp
+ * \brief    YUV/RGB conversion matrices (BT.601, BT.709 and BT.2020)
+ */
+
+#ifndef __COLORMATRIX_H__
+#define __COLORMATRIX_H__
+
+#include "CalypDefs.h"
+
+#include <vector>
+
+/**
+ * Lookup tables to convert YUV samples of a given bit depth into 8 bits RGB
+ *
+ * Each table holds the contribution of one sample to one RGB component
+ * in fixed point (CLP_COLOR_LUT_SHIFT fractional bits). The rounding
+ * offset is folded into the luma table
+ */
+struct CalypYuvToRgbLut
+{
+  unsigned int uiMaxIndex;  //!< Samples above this value use the last entry
+  std::vector<int> aiY;     //!< Luma contribution (common to R, G and B)
+  std::vector<int> aiRV;    //!< V contribution to R
+  std::vector<int> aiGU;    //!< U contribution to G
+  std::vector<int> aiGV;    //!< V contribution to G
+  std::vector<int> aiBU;    //!< U contribution to B
+};
+
+#define CLP_COLOR_LUT_SHIFT 16
+
+/**
+ * Get the lookup tables of a matrix, range and bit depth combination
+ * Tables are built on first use and shared until the program exits
+ * @param colorMatrix conversion matrix (use CalypColorMatrix enum, not CLP_MATRIX_DEFAULT)
+ * @param colorRange sample range (use CalypColorRange enum)
+ * @param bitsPel bits per sample
+ */
+const CalypYuvToRgbLut* getYuvToRgbLut( int colorMatrix, int colorRange, unsigned int bitsPel );
+
+/**
+ * Convert one row of YUV samples into ARGB32 pixels using lookup tables
+ * @param lut tables returned by getYuvToRgbLut
+ * @param pY luma row
+ * @param pU chroma U row
+ * @param pV chroma V row
+ * @param pARGB output row
+ * @param width number of pixels in the row
+ * @param log2ChromaWidth horizontal chroma subsampling
+ */
+void yuvToArgbRowLut( const CalypYuvToRgbLut* lut, const ClpPel* pY, const ClpPel* pU, const ClpPel* pV, unsigned int* pARGB,
+                      unsigned int width, unsigned int log2ChromaWidth );
+void yuvToArgbRowLut( const CalypYuvToRgbLut* lut, const ClpByte* pY, const ClpByte* pU, const ClpByte* pV, unsigned int* pARGB,
+                      unsigned int width, unsigned int log2ChromaWidth );
+
+/**
+ * Convert a single YUV sample into RGB with the same bit depth
+ * (RGB is always full range)
+ */
+void yuvToRgbMatrix( int colorMatrix, int colorRange, unsigned int bitsPel, int iY, int iU, int iV, int& iR, int& iG, int& iB );
+
+/**
+ * Convert a single RGB sample into YUV with the same bit depth
+ * (RGB is always full range)
+ */
+void rgbToYuvMatrix( int colorMatrix, int colorRange, unsigned int bitsPel, int iR, int iG, int iB, int& iY, int& iU, int& iV );
+
+/**
+ * Coefficients of yuvToRgbMatrix and rgbToYuvMatrix for colorTransformRow
+ * (see FrameKernels.h): 3 rows of 4 floats, the output components in the
+ * order of the planes
+ */
+void getYuvToRgbTransform( int colorMatrix, int colorRange, unsigned int bitsPel, float* coeffs );
+void getRgbToYuvTransform( int colorMatrix, int colorRange, unsigned int bitsPel, float* coeffs );
+
+/**
+ * Compute the luma of one row of RGB samples (fixed point version of rgbToYuvMatrix)
+ */
+void rgbToLumaRowMatrix( int colorMatrix, int colorRange, unsigned int bitsPel, const ClpPel* pR, const ClpPel* pG,
+                         const ClpPel* pB, ClpPel* pY, unsigned int width );
+void rgbToLumaRowMatrix( int colorMatrix, int colorRange, unsigned int bitsPel, const ClpByte* pR, const ClpByte* pG,
+                         const ClpByte* pB, ClpByte* pY, unsigned int width );
+
+#endif  // __COLORMATRIX_H__
@@ -0,0 +1,90 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CpuFeatures.cpp
+ * \brief    Runtime detection of the SIMD instruction sets used by the kernels
+ */
+
+#include "CpuFeatures.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static const char* const s_apchSimdLevelNames[] = {
+    "none",
+    "sse2",
+    "sse4.1",
+    "avx2",
+    "avx512",
+};
+
+int detectSimdLevel()
+{
+  int level = CLP_SIMD_NONE;
+#ifdef CLP_SIMD_X86
+  // Also checks that the OS saves the wider registers
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports( "sse2" ) )
+    level = CLP_SIMD_SSE2;
+  if( level == CLP_SIMD_SSE2 && __builtin_cpu_supports( "sse4.1" ) )
+    level = CLP_SIMD_SSE41;
+  if( level == CLP_SIMD_SSE41 && __builtin_cpu_supports( "avx2" ) )
+    level = CLP_SIMD_AVX2;
+  if( level == CLP_SIMD_AVX2 && __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" ) )
+    level = CLP_SIMD_AVX512;
+#endif
+  return level;
+}
+
+static int selectSimdLevel()
+{
+  int level = detectSimdLevel();
+  const char* pchForced = getenv( "CALYP_SIMD" );
+  if( pchForced )
+  {
+    int forced = findSimdLevel( pchForced );
+    if( forced >= 0 && forced < level )
+      level = forced;
+  }
+  return level;
+}
+
+int getSimdLevel()
+{
+  static const int s_iLevel = selectSimdLevel();
+  return s_iLevel;
+}
+
+const char* getSimdLevelName( int level )
+{
+  if( level < CLP_SIMD_NONE || level > CLP_SIMD_MAX_LEVEL )
+    return "";
+  return s_apchSimdLevelNames[level];
+}
+
+int findSimdLevel( const char* name )
+{
+  for( int level = CLP_SIMD_NONE; level <= CLP_SIMD_MAX_LEVEL; level++ )
+  {
+    if( !strcmp( name, s_apchSimdLevelNames[level] ) )
+      return level;
+  }
+  return -1;
+}
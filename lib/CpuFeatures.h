@@ -0,0 +1,75 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CpuFeatures.h
+ * \ingroup  CalypLibGrp
+ * \brief    Runtime detection of the SIMD instruction sets used by the kernels
+ */
+
+#ifndef __CPUFEATURES_H__
+#define __CPUFEATURES_H__
+
+#include "config.h"
+
+/**
+ * SIMD kernels are built for x86 with USE_SSE and selected at runtime,
+ * so one binary runs on any host
+ */
+#if defined( USE_SSE ) && defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define CLP_SIMD_X86 1
+#endif
+
+/**
+ * Instruction set levels, each one includes the previous ones
+ */
+enum CalypSimdLevels
+{
+  CLP_SIMD_NONE = 0,  //!< Reference C++ kernels
+  CLP_SIMD_SSE2,
+  CLP_SIMD_SSE41,
+  CLP_SIMD_AVX2,
+  CLP_SIMD_AVX512,  //!< AVX-512 F and BW
+  CLP_SIMD_MAX_LEVEL = CLP_SIMD_AVX512,
+};
+
+/**
+ * Highest level supported by the host (CLP_SIMD_NONE in builds without USE_SSE)
+ */
+int detectSimdLevel();
+
+/**
+ * Level the kernels use: detected once and lowered by the CALYP_SIMD
+ * environment variable (none, sse2, sse4.1, avx2 or avx512) to force
+ * a given path; levels the host does not support are never selected
+ */
+int getSimdLevel();
+
+/**
+ * Name of a level (as accepted by CALYP_SIMD)
+ */
+const char* getSimdLevelName( int level );
+
+/**
+ * Level of a name
+ * @return -1 if the name is unknown
+ */
+int findSimdLevel( const char* name );
+
+#endif  // __CPUFEATURES_H__
@@ -0,0 +1,2177 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FrameKernels.cpp
+ * \brief    Optimized kernels for frame samples handling
+ */
+
+#include "FrameKernels.h"
+
+#include "CpuFeatures.h"
+#include "PixelFormats.h"
+#include "config.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+
+#ifdef CLP_SIMD_X86
+#include <immintrin.h>
+#define CLP_TARGET_SSE2 __attribute__( ( target( "sse2" ) ) )
+#define CLP_TARGET_SSE41 __attribute__( ( target( "sse4.1" ) ) )
+#define CLP_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#define CLP_TARGET_AVX512 __attribute__( ( target( "avx512f,avx512bw" ) ) )
+#endif
+
+typedef void ( *Unpack8Fn )( const ClpByte*, ClpPel*, unsigned long );
+typedef void ( *Unpack16Fn )( const ClpByte*, ClpPel*, unsigned long, int );
+typedef void ( *Pack8Fn )( const ClpPel*, ClpByte*, unsigned long );
+typedef void ( *Pack16Fn )( const ClpPel*, ClpByte*, unsigned long );
+typedef void ( *CopyByteFn )( const ClpByte*, ClpByte*, unsigned long );
+typedef void ( *NarrowFn )( const ClpPel*, ClpByte*, unsigned long );
+typedef void ( *YuvToArgbFn )( const ClpPel*, const ClpPel*, const ClpPel*, unsigned int*, unsigned int, unsigned int );
+typedef void ( *YuvToArgbByteFn )( const ClpByte*, const ClpByte*, const ClpByte*, unsigned int*, unsigned int, unsigned int );
+typedef void ( *RgbToLumaFn )( const ClpPel*, const ClpPel*, const ClpPel*, ClpPel*, unsigned int );
+typedef void ( *RgbToLumaByteFn )( const ClpByte*, const ClpByte*, const ClpByte*, ClpByte*, unsigned int );
+typedef void ( *ColorTransformFn )( const float*, int, const ClpPel*, const ClpPel*, const ClpPel*, ClpPel*, ClpPel*, ClpPel*,
+                                    unsigned int );
+typedef void ( *ColorTransformByteFn )( const float*, int, const ClpByte*, const ClpByte*, const ClpByte*, ClpByte*, ClpByte*,
+                                        ClpByte*, unsigned int );
+typedef unsigned long long ( *SsdFn )( const ClpPel*, const ClpPel*, unsigned long );
+typedef unsigned long long ( *SsdByteFn )( const ClpByte*, const ClpByte*, unsigned long );
+typedef void ( *AbsDiffFn )( const ClpPel*, const ClpPel*, ClpPel*, unsigned long );
+typedef void ( *InterleaveFn )( const ClpPel*, const ClpPel*, const ClpPel*, ClpPel*, unsigned long );
+typedef void ( *InterleaveByteFn )( const ClpByte*, const ClpByte*, const ClpByte*, ClpByte*, unsigned long );
+typedef void ( *DeinterleaveFn )( const ClpPel*, ClpPel*, ClpPel*, ClpPel*, unsigned long );
+typedef void ( *DeinterleaveByteFn )( const ClpByte*, ClpByte*, ClpByte*, ClpByte*, unsigned long );
+typedef void ( *ArgbToBgrFn )( const unsigned int*, ClpByte*, unsigned long );
+typedef void ( *AverageRowsFn )( const ClpPel*, const ClpPel*, ClpPel*, unsigned long );
+typedef void ( *AverageRowsByteFn )( const ClpByte*, const ClpByte*, ClpByte*, unsigned long );
+typedef void ( *ResampleRowFn )( const ClpPel*, ClpPel*, unsigned int, unsigned int );
+typedef void ( *ResampleRowByteFn )( const ClpByte*, ClpByte*, unsigned int, unsigned int );
+typedef void ( *ShiftFn )( const ClpPel*, ClpPel*, unsigned long, int, ClpPel );
+
+#define MAX_SPECIALIZED_STEP 4
+
+/*
+ **************************************************************
+ * Reference implementations
+ **************************************************************
+ */
+
+static void unpackSamplesGeneric( const ClpByte* in, ClpPel* out, unsigned long count, unsigned int bytesPixel,
+                                  unsigned int step, int endianness, int maxval )
+{
+  int startByte = 0;
+  int endByte = bytesPixel;
+  int incByte = 1;
+  if( endianness == CLP_BIG_ENDIAN )
+  {
+    startByte = bytesPixel - 1;
+    endByte = -1;
+    incByte = -1;
+  }
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    *out = 0;
+    for( int b = startByte; b != endByte; b += incByte )
+    {
+      *out += *in << ( b * 8 );
+      in++;
+      // Check max value and bound it to "maxval" to prevent segfault when
+      // calculating histogram
+      if( *out > maxval )
+        *out = 0;
+    }
+    out++;
+    in += step;
+  }
+}
+
+/**
+ * Reference kernels are templated on the sample type T of the frame
+ * planes: ClpPel or ClpByte (native 8 bits samples)
+ */
+template <unsigned int STEP, typename T = ClpPel>
+static void unpack8_c( const ClpByte* in, T* out, unsigned long count )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    out[i] = *in;
+    in += STEP + 1;
+  }
+}
+
+/**
+ * A big endian sample above maxval keeps its least significant byte,
+ * a little endian one is set to zero (see unpackSamplesGeneric)
+ */
+template <bool IS_BIG_ENDIAN>
+static inline ClpPel unpackSample16( const ClpByte* in, int maxval )
+{
+  int lsb = IS_BIG_ENDIAN ? in[1] : in[0];
+  int value = IS_BIG_ENDIAN ? ( in[0] << 8 ) | in[1] : ( in[1] << 8 ) | in[0];
+  if( value > maxval )
+    value = IS_BIG_ENDIAN ? lsb : 0;
+  return value;
+}
+
+template <bool IS_BIG_ENDIAN>
+static void unpack16_c( const ClpByte* in, ClpPel* out, unsigned long count, int maxval )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    out[i] = unpackSample16<IS_BIG_ENDIAN>( in, maxval );
+    in += 2;
+  }
+}
+
+static void packSamplesGeneric( const ClpPel* in, ClpByte* out, unsigned long count, unsigned int bytesPixel,
+                                unsigned int step, int endianness )
+{
+  int startByte = 0;
+  int endByte = bytesPixel;
+  int incByte = 1;
+  if( endianness == CLP_BIG_ENDIAN )
+  {
+    startByte = bytesPixel - 1;
+    endByte = -1;
+    incByte = -1;
+  }
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    for( int b = startByte; b != endByte; b += incByte )
+    {
+      *out = *in >> ( 8 * b );
+      out++;
+    }
+    in++;
+    out += step;
+  }
+}
+
+template <unsigned int STEP, typename T = ClpPel>
+static void pack8_c( const T* in, ClpByte* out, unsigned long count )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    *out = in[i];
+    out += STEP + 1;
+  }
+}
+
+template <bool IS_BIG_ENDIAN>
+static void pack16_c( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    out[IS_BIG_ENDIAN ? 1 : 0] = in[i];
+    out[IS_BIG_ENDIAN ? 0 : 1] = in[i] >> 8;
+    out += 2;
+  }
+}
+
+static void copyBytes_c( const ClpByte* in, ClpByte* out, unsigned long count )
+{
+  memcpy( out, in, count );
+}
+
+static void narrow_c( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    out[i] = std::min<ClpPel>( in[i], 255 );
+  }
+}
+
+#define PEL_ARGB( a, r, g, b ) ( ( a & 0xff ) << 24 ) | ( ( r & 0xff ) << 16 ) | ( ( g & 0xff ) << 8 ) | ( b & 0xff )
+#define PEL_RGB( r, g, b ) PEL_ARGB( 0xffu, r, g, b )
+#define CLAMP_YUV2RGB( X ) X = X < 0 ? 0 : X > 255 ? 255 : X;
+#define YUV2RGB( iY, iU, iV, iR, iG, iB )                          \
+  iR = iY + ( ( 1436 * ( iV - 128 ) ) >> 10 );                     \
+  iG = iY - ( ( 352 * ( iU - 128 ) + 731 * ( iV - 128 ) ) >> 10 ); \
+  iB = iY + ( ( 1812 * ( iU - 128 ) ) >> 10 );                     \
+  CLAMP_YUV2RGB( iR )                                              \
+  CLAMP_YUV2RGB( iG )                                              \
+  CLAMP_YUV2RGB( iB )
+
+template <unsigned int LOG2_CHROMA_WIDTH, typename T = ClpPel>
+static void yuvToArgbRow_c( const T* pY, const T* pU, const T* pV, unsigned int* pARGB, unsigned int width, unsigned int shiftBits )
+{
+  int iY, iU, iV, iR, iG, iB;
+  for( unsigned int x = 0; x < width; x++ )
+  {
+    iY = pY[x] >> shiftBits;
+    iU = pU[x >> LOG2_CHROMA_WIDTH] >> shiftBits;
+    iV = pV[x >> LOG2_CHROMA_WIDTH] >> shiftBits;
+    YUV2RGB( iY, iU, iV, iR, iG, iB );
+    pARGB[x] = PEL_RGB( iR, iG, iB );
+  }
+}
+
+/**
+ * Same integer weights as the RGB to YUV conversion of CalypPixel
+ */
+template <typename T>
+static void rgbToLumaRow_c( const T* pR, const T* pG, const T* pB, T* pY, unsigned int width )
+{
+  for( unsigned int x = 0; x < width; x++ )
+  {
+    pY[x] = ( 299 * int( pR[x] ) + 587 * int( pG[x] ) + 114 * int( pB[x] ) + 500 ) / 1000;
+  }
+}
+
+/**
+ * The SIMD versions evaluate the same float expression in the same order,
+ * so every version gives the same samples
+ */
+template <typename T>
+static void colorTransformRow_c( const float* coeffs, int maxValue, const T* p0, const T* p1, const T* p2, T* o0, T* o1, T* o2,
+                                 unsigned int width )
+{
+  T* apOut[3] = { o0, o1, o2 };
+  float fMax = float( maxValue );
+  for( unsigned int x = 0; x < width; x++ )
+  {
+    float f0 = p0[x];
+    float f1 = p1[x];
+    float f2 = p2[x];
+    for( int c = 0; c < 3; c++ )
+    {
+      const float* m = coeffs + 4 * c;
+      float v = m[0] * f0 + m[1] * f1 + m[2] * f2 + m[3];
+      v = std::min( std::max( v, 0.0f ), fMax );
+      apOut[c][x] = T( int( v + 0.5f ) );
+    }
+  }
+}
+
+template <typename T>
+static unsigned long long ssd_c( const T* pA, const T* pB, unsigned long count )
+{
+  unsigned long long ssd = 0;
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    unsigned long long diff = pA[i] > pB[i] ? pA[i] - pB[i] : pB[i] - pA[i];
+    ssd += diff * diff;
+  }
+  return ssd;
+}
+
+static void absDiff_c( const ClpPel* pA, const ClpPel* pB, ClpPel* pOut, unsigned long count )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    pOut[i] = pA[i] > pB[i] ? pA[i] - pB[i] : pB[i] - pA[i];
+  }
+}
+
+template <typename T>
+static void interleave3_c( const T* p0, const T* p1, const T* p2, T* out, unsigned long count )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    *out++ = p0[i];
+    *out++ = p1[i];
+    *out++ = p2[i];
+  }
+}
+
+template <typename T>
+static void deinterleave3_c( const T* in, T* p0, T* p1, T* p2, unsigned long count )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    p0[i] = *in++;
+    p1[i] = *in++;
+    p2[i] = *in++;
+  }
+}
+
+static void argbToBgr_c( const unsigned int* pARGB, ClpByte* out, unsigned long count )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    *out++ = pARGB[i];
+    *out++ = pARGB[i] >> 8;
+    *out++ = pARGB[i] >> 16;
+  }
+}
+
+/**
+ * Rounded average, the operation of pavgb/pavgw
+ */
+template <typename T>
+static inline T avgSample( T a, T b )
+{
+  return ( (unsigned int)a + b + 1 ) >> 1;
+}
+
+template <typename T>
+static void averageRows_c( const T* pA, const T* pB, T* pOut, unsigned long count )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    pOut[i] = avgSample( pA[i], pB[i] );
+  }
+}
+
+/**
+ * Output samples [x, outWidth) of downsampleRow (edges replicated)
+ */
+template <typename T>
+static void downsampleRow_c( const T* in, T* out, unsigned int x, unsigned int outWidth, unsigned int inWidth )
+{
+  for( ; x < outWidth; x++ )
+  {
+    unsigned int c = std::min( 2 * x, inWidth - 1 );
+    T left = in[c > 0 ? c - 1 : 0];
+    T right = in[std::min( c + 1, inWidth - 1 )];
+    out[x] = avgSample( in[c], avgSample( left, right ) );
+  }
+}
+
+template <typename T>
+static void downsampleRow_c( const T* in, T* out, unsigned int outWidth, unsigned int inWidth )
+{
+  downsampleRow_c( in, out, 0, outWidth, inWidth );
+}
+
+/**
+ * Input samples [x, inWidth) of upsampleRow (edges replicated)
+ */
+template <typename T>
+static void upsampleRow_c( const T* in, T* out, unsigned int x, unsigned int outWidth, unsigned int inWidth )
+{
+  for( ; x < inWidth && 2 * x < outWidth; x++ )
+  {
+    out[2 * x] = in[x];
+    if( 2 * x + 1 < outWidth )
+      out[2 * x + 1] = avgSample( in[x], in[std::min( x + 1, inWidth - 1 )] );
+  }
+}
+
+template <typename T>
+static void upsampleRow_c( const T* in, T* out, unsigned int outWidth, unsigned int inWidth )
+{
+  upsampleRow_c( in, out, 0, outWidth, inWidth );
+}
+
+static void shiftSamples_c( const ClpPel* in, ClpPel* out, unsigned long count, int shift, ClpPel maxval )
+{
+  if( shift >= 0 )
+  {
+    for( unsigned long i = 0; i < count; i++ )
+      out[i] = in[i] << shift;
+    return;
+  }
+  unsigned int round = 1 << ( -shift - 1 );
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    out[i] = std::min<unsigned int>( ( in[i] + round ) >> -shift, maxval );
+  }
+}
+
+/*
+ **************************************************************
+ * SSE2 implementations
+ **************************************************************
+ */
+
+#ifdef CLP_SIMD_X86
+
+CLP_TARGET_SSE2 static void unpack8_sse2( const ClpByte* in, ClpPel* out, unsigned long count )
+{
+  const __m128i zero = _mm_setzero_si128();
+  unsigned long i = 0;
+  for( ; i + 16 <= count; i += 16 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)( in + i ) );
+    _mm_storeu_si128( (__m128i*)( out + i ), _mm_unpacklo_epi8( v, zero ) );
+    _mm_storeu_si128( (__m128i*)( out + i + 8 ), _mm_unpackhi_epi8( v, zero ) );
+  }
+  unpack8_c<0>( in + i, out + i, count - i );
+}
+
+/**
+ * Strided loads read up to the last byte of the next sample, hence the vector
+ * loops only run while at least one more sample follows
+ */
+CLP_TARGET_SSE2 static void unpack8s1_sse2( const ClpByte* in, ClpPel* out, unsigned long count )
+{
+  const __m128i mask = _mm_set1_epi16( 0x00FF );
+  unsigned long i = 0;
+  for( ; i + 8 < count; i += 8 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)( in + 2 * i ) );
+    _mm_storeu_si128( (__m128i*)( out + i ), _mm_and_si128( v, mask ) );
+  }
+  unpack8_c<1>( in + 2 * i, out + i, count - i );
+}
+
+CLP_TARGET_SSE2 static void unpack8s3_sse2( const ClpByte* in, ClpPel* out, unsigned long count )
+{
+  const __m128i mask = _mm_set1_epi32( 0x000000FF );
+  unsigned long i = 0;
+  for( ; i + 8 < count; i += 8 )
+  {
+    __m128i v0 = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( in + 4 * i ) ), mask );
+    __m128i v1 = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( in + 4 * i + 16 ) ), mask );
+    _mm_storeu_si128( (__m128i*)( out + i ), _mm_packs_epi32( v0, v1 ) );
+  }
+  unpack8_c<3>( in + 4 * i, out + i, count - i );
+}
+
+template <bool IS_BIG_ENDIAN>
+CLP_TARGET_SSE2 static void unpack16_sse2( const ClpByte* in, ClpPel* out, unsigned long count, int maxval )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lsbMask = _mm_set1_epi16( 0x00FF );
+  const __m128i maxv = _mm_set1_epi16( (short)maxval );
+  const bool bClip = maxval < 0xFFFF;
+  unsigned long i = 0;
+  for( ; i + 8 <= count; i += 8 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)( in + 2 * i ) );
+    if( IS_BIG_ENDIAN )
+      v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+    if( bClip )
+    {
+      __m128i inRange = _mm_cmpeq_epi16( _mm_subs_epu16( v, maxv ), zero );
+      if( IS_BIG_ENDIAN )
+        v = _mm_or_si128( _mm_and_si128( inRange, v ), _mm_andnot_si128( inRange, _mm_and_si128( v, lsbMask ) ) );
+      else
+        v = _mm_and_si128( inRange, v );
+    }
+    _mm_storeu_si128( (__m128i*)( out + i ), v );
+  }
+  unpack16_c<IS_BIG_ENDIAN>( in + 2 * i, out + i, count - i, maxval );
+}
+
+CLP_TARGET_SSE2 static void pack8_sse2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  const __m128i mask = _mm_set1_epi16( 0x00FF );
+  unsigned long i = 0;
+  for( ; i + 16 <= count; i += 16 )
+  {
+    __m128i v0 = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( in + i ) ), mask );
+    __m128i v1 = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( in + i + 8 ) ), mask );
+    _mm_storeu_si128( (__m128i*)( out + i ), _mm_packus_epi16( v0, v1 ) );
+  }
+  pack8_c<0>( in + i, out + i, count - i );
+}
+
+/**
+ * Strided stores merge the samples with the bytes already in the buffer
+ * so that the other interleaved components are preserved
+ */
+CLP_TARGET_SSE2 static void pack8s1_sse2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  const __m128i mask = _mm_set1_epi16( 0x00FF );
+  unsigned long i = 0;
+  for( ; i + 8 < count; i += 8 )
+  {
+    __m128i* pOut = (__m128i*)( out + 2 * i );
+    __m128i v = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( in + i ) ), mask );
+    __m128i keep = _mm_andnot_si128( mask, _mm_loadu_si128( pOut ) );
+    _mm_storeu_si128( pOut, _mm_or_si128( keep, v ) );
+  }
+  pack8_c<1>( in + i, out + 2 * i, count - i );
+}
+
+CLP_TARGET_SSE2 static void pack8s3_sse2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mask = _mm_set1_epi32( 0x000000FF );
+  unsigned long i = 0;
+  for( ; i + 8 < count; i += 8 )
+  {
+    __m128i* pOut = (__m128i*)( out + 4 * i );
+    __m128i v = _mm_loadu_si128( (const __m128i*)( in + i ) );
+    __m128i v0 = _mm_and_si128( _mm_unpacklo_epi16( v, zero ), mask );
+    __m128i v1 = _mm_and_si128( _mm_unpackhi_epi16( v, zero ), mask );
+    __m128i keep0 = _mm_andnot_si128( mask, _mm_loadu_si128( pOut ) );
+    __m128i keep1 = _mm_andnot_si128( mask, _mm_loadu_si128( pOut + 1 ) );
+    _mm_storeu_si128( pOut, _mm_or_si128( keep0, v0 ) );
+    _mm_storeu_si128( pOut + 1, _mm_or_si128( keep1, v1 ) );
+  }
+  pack8_c<3>( in + i, out + 4 * i, count - i );
+}
+
+template <bool IS_BIG_ENDIAN>
+CLP_TARGET_SSE2 static void pack16_sse2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  unsigned long i = 0;
+  for( ; i + 8 <= count; i += 8 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)( in + i ) );
+    if( IS_BIG_ENDIAN )
+      v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+    _mm_storeu_si128( (__m128i*)( out + 2 * i ), v );
+  }
+  pack16_c<IS_BIG_ENDIAN>( in + i, out + 2 * i, count - i );
+}
+
+CLP_TARGET_SSE2 static void unpack8s1Byte_sse2( const ClpByte* in, ClpByte* out, unsigned long count )
+{
+  const __m128i mask = _mm_set1_epi16( 0x00FF );
+  unsigned long i = 0;
+  for( ; i + 16 < count; i += 16 )
+  {
+    __m128i v0 = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( in + 2 * i ) ), mask );
+    __m128i v1 = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( in + 2 * i + 16 ) ), mask );
+    _mm_storeu_si128( (__m128i*)( out + i ), _mm_packus_epi16( v0, v1 ) );
+  }
+  unpack8_c<1>( in + 2 * i, out + i, count - i );
+}
+
+CLP_TARGET_SSE2 static void unpack8s3Byte_sse2( const ClpByte* in, ClpByte* out, unsigned long count )
+{
+  const __m128i mask = _mm_set1_epi32( 0x000000FF );
+  unsigned long i = 0;
+  for( ; i + 16 < count; i += 16 )
+  {
+    const __m128i* pIn = (const __m128i*)( in + 4 * i );
+    __m128i v0 = _mm_and_si128( _mm_loadu_si128( pIn ), mask );
+    __m128i v1 = _mm_and_si128( _mm_loadu_si128( pIn + 1 ), mask );
+    __m128i v2 = _mm_and_si128( _mm_loadu_si128( pIn + 2 ), mask );
+    __m128i v3 = _mm_and_si128( _mm_loadu_si128( pIn + 3 ), mask );
+    __m128i v = _mm_packus_epi16( _mm_packs_epi32( v0, v1 ), _mm_packs_epi32( v2, v3 ) );
+    _mm_storeu_si128( (__m128i*)( out + i ), v );
+  }
+  unpack8_c<3>( in + 4 * i, out + i, count - i );
+}
+
+CLP_TARGET_SSE2 static void pack8s1Byte_sse2( const ClpByte* in, ClpByte* out, unsigned long count )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mask = _mm_set1_epi16( 0x00FF );
+  unsigned long i = 0;
+  for( ; i + 16 < count; i += 16 )
+  {
+    __m128i* pOut = (__m128i*)( out + 2 * i );
+    __m128i v = _mm_loadu_si128( (const __m128i*)( in + i ) );
+    __m128i keep0 = _mm_andnot_si128( mask, _mm_loadu_si128( pOut ) );
+    __m128i keep1 = _mm_andnot_si128( mask, _mm_loadu_si128( pOut + 1 ) );
+    _mm_storeu_si128( pOut, _mm_or_si128( keep0, _mm_unpacklo_epi8( v, zero ) ) );
+    _mm_storeu_si128( pOut + 1, _mm_or_si128( keep1, _mm_unpackhi_epi8( v, zero ) ) );
+  }
+  pack8_c<1>( in + i, out + 2 * i, count - i );
+}
+
+CLP_TARGET_SSE2 static void pack8s3Byte_sse2( const ClpByte* in, ClpByte* out, unsigned long count )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mask = _mm_set1_epi32( 0x000000FF );
+  unsigned long i = 0;
+  for( ; i + 16 < count; i += 16 )
+  {
+    __m128i* pOut = (__m128i*)( out + 4 * i );
+    __m128i v = _mm_loadu_si128( (const __m128i*)( in + i ) );
+    __m128i lo = _mm_unpacklo_epi8( v, zero );
+    __m128i hi = _mm_unpackhi_epi8( v, zero );
+    __m128i w[4] = { _mm_unpacklo_epi16( lo, zero ), _mm_unpackhi_epi16( lo, zero ), _mm_unpacklo_epi16( hi, zero ),
+                     _mm_unpackhi_epi16( hi, zero ) };
+    for( int k = 0; k < 4; k++ )
+    {
+      __m128i keep = _mm_andnot_si128( mask, _mm_loadu_si128( pOut + k ) );
+      _mm_storeu_si128( pOut + k, _mm_or_si128( keep, w[k] ) );
+    }
+  }
+  pack8_c<3>( in + i, out + 4 * i, count - i );
+}
+
+/**
+ * Saturated narrowing: adding 0xFF00 with unsigned saturation and removing
+ * it again clamps every sample to 255 before the signed pack
+ */
+CLP_TARGET_SSE2 static void narrow_sse2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  const __m128i bias = _mm_set1_epi16( (short)0xFF00 );
+  unsigned long i = 0;
+  for( ; i + 16 <= count; i += 16 )
+  {
+    __m128i v0 = _mm_subs_epu16( _mm_adds_epu16( _mm_loadu_si128( (const __m128i*)( in + i ) ), bias ), bias );
+    __m128i v1 = _mm_subs_epu16( _mm_adds_epu16( _mm_loadu_si128( (const __m128i*)( in + i + 8 ) ), bias ), bias );
+    _mm_storeu_si128( (__m128i*)( out + i ), _mm_packus_epi16( v0, v1 ) );
+  }
+  narrow_c( in + i, out + i, count - i );
+}
+
+/**
+ * SSD of samples up to 8 bits: squares are summed in pairs by madd and
+ * kept in 32-bit lanes for blocks of SSD8_BLOCK vectors before widening
+ */
+#define SSD8_BLOCK 16384
+
+CLP_TARGET_SSE2 static unsigned long long ssd8_sse2( const ClpPel* pA, const ClpPel* pB, unsigned long count )
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc64 = zero;
+  unsigned long i = 0;
+  unsigned long vecEnd = count & ~7UL;
+  while( i < vecEnd )
+  {
+    unsigned long blockEnd = std::min( vecEnd, i + 8UL * SSD8_BLOCK );
+    __m128i acc32 = zero;
+    for( ; i < blockEnd; i += 8 )
+    {
+      __m128i diff = _mm_sub_epi16( _mm_loadu_si128( (const __m128i*)( pA + i ) ), _mm_loadu_si128( (const __m128i*)( pB + i ) ) );
+      acc32 = _mm_add_epi32( acc32, _mm_madd_epi16( diff, diff ) );
+    }
+    acc64 = _mm_add_epi64( acc64, _mm_unpacklo_epi32( acc32, zero ) );
+    acc64 = _mm_add_epi64( acc64, _mm_unpackhi_epi32( acc32, zero ) );
+  }
+  unsigned long long lanes[2];
+  _mm_storeu_si128( (__m128i*)lanes, acc64 );
+  return lanes[0] + lanes[1] + ssd_c( pA + i, pB + i, count - i );
+}
+
+/**
+ * Same as ssd8_sse2 on native 8 bits samples (16 samples per iteration,
+ * so a block still stays below 2^32 in each lane)
+ */
+CLP_TARGET_SSE2 static unsigned long long ssdByte_sse2( const ClpByte* pA, const ClpByte* pB, unsigned long count )
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc64 = zero;
+  unsigned long i = 0;
+  unsigned long vecEnd = count & ~15UL;
+  while( i < vecEnd )
+  {
+    unsigned long blockEnd = std::min( vecEnd, i + 16UL * SSD8_BLOCK );
+    __m128i acc32 = zero;
+    for( ; i < blockEnd; i += 16 )
+    {
+      __m128i a = _mm_loadu_si128( (const __m128i*)( pA + i ) );
+      __m128i b = _mm_loadu_si128( (const __m128i*)( pB + i ) );
+      __m128i diffLo = _mm_sub_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) );
+      __m128i diffHi = _mm_sub_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) );
+      acc32 = _mm_add_epi32( acc32, _mm_add_epi32( _mm_madd_epi16( diffLo, diffLo ), _mm_madd_epi16( diffHi, diffHi ) ) );
+    }
+    acc64 = _mm_add_epi64( acc64, _mm_unpacklo_epi32( acc32, zero ) );
+    acc64 = _mm_add_epi64( acc64, _mm_unpackhi_epi32( acc32, zero ) );
+  }
+  unsigned long long lanes[2];
+  _mm_storeu_si128( (__m128i*)lanes, acc64 );
+  return lanes[0] + lanes[1] + ssd_c( pA + i, pB + i, count - i );
+}
+
+/**
+ * SSD of any 16-bit samples: absolute differences are squared into
+ * 32-bit products and accumulated in 64-bit lanes
+ */
+CLP_TARGET_SSE2 static unsigned long long ssd16_sse2( const ClpPel* pA, const ClpPel* pB, unsigned long count )
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc64 = zero;
+  unsigned long i = 0;
+  for( ; i + 8 <= count; i += 8 )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( pA + i ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( pB + i ) );
+    __m128i diff = _mm_or_si128( _mm_subs_epu16( a, b ), _mm_subs_epu16( b, a ) );
+    __m128i sqLo = _mm_mullo_epi16( diff, diff );
+    __m128i sqHi = _mm_mulhi_epu16( diff, diff );
+    __m128i sq0 = _mm_unpacklo_epi16( sqLo, sqHi );
+    __m128i sq1 = _mm_unpackhi_epi16( sqLo, sqHi );
+    acc64 = _mm_add_epi64( acc64, _mm_add_epi64( _mm_unpacklo_epi32( sq0, zero ), _mm_unpackhi_epi32( sq0, zero ) ) );
+    acc64 = _mm_add_epi64( acc64, _mm_add_epi64( _mm_unpacklo_epi32( sq1, zero ), _mm_unpackhi_epi32( sq1, zero ) ) );
+  }
+  unsigned long long lanes[2];
+  _mm_storeu_si128( (__m128i*)lanes, acc64 );
+  return lanes[0] + lanes[1] + ssd_c( pA + i, pB + i, count - i );
+}
+
+CLP_TARGET_SSE2 static void absDiff_sse2( const ClpPel* pA, const ClpPel* pB, ClpPel* pOut, unsigned long count )
+{
+  unsigned long i = 0;
+  for( ; i + 8 <= count; i += 8 )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( pA + i ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( pB + i ) );
+    _mm_storeu_si128( (__m128i*)( pOut + i ), _mm_or_si128( _mm_subs_epu16( a, b ), _mm_subs_epu16( b, a ) ) );
+  }
+  absDiff_c( pA + i, pB + i, pOut + i, count - i );
+}
+
+template <typename T>
+CLP_TARGET_SSE2 static inline __m128i avgSamples_sse2( __m128i a, __m128i b )
+{
+  return sizeof( T ) == sizeof( ClpByte ) ? _mm_avg_epu8( a, b ) : _mm_avg_epu16( a, b );
+}
+
+template <typename T>
+CLP_TARGET_SSE2 static void averageRows_sse2( const T* pA, const T* pB, T* pOut, unsigned long count )
+{
+  const unsigned long n = 16 / sizeof( T );
+  unsigned long i = 0;
+  for( ; i + n <= count; i += n )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( pA + i ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( pB + i ) );
+    _mm_storeu_si128( (__m128i*)( pOut + i ), avgSamples_sse2<T>( a, b ) );
+  }
+  averageRows_c( pA + i, pB + i, pOut + i, count - i );
+}
+
+/*
+ **************************************************************
+ * SSE4.1 implementations
+ **************************************************************
+ */
+
+/**
+ * YUV to RGB conversion of 4 pixels in 32-bit lanes, exact for any input
+ * sample as the reference macro
+ */
+CLP_TARGET_SSE41 static inline __m128i yuvToArgb_sse41( __m128i y, __m128i u, __m128i v )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i maxRgb = _mm_set1_epi32( 255 );
+  u = _mm_sub_epi32( u, _mm_set1_epi32( 128 ) );
+  v = _mm_sub_epi32( v, _mm_set1_epi32( 128 ) );
+  __m128i r = _mm_add_epi32( y, _mm_srai_epi32( _mm_mullo_epi32( v, _mm_set1_epi32( 1436 ) ), 10 ) );
+  __m128i g = _mm_add_epi32( _mm_mullo_epi32( u, _mm_set1_epi32( 352 ) ), _mm_mullo_epi32( v, _mm_set1_epi32( 731 ) ) );
+  g = _mm_sub_epi32( y, _mm_srai_epi32( g, 10 ) );
+  __m128i b = _mm_add_epi32( y, _mm_srai_epi32( _mm_mullo_epi32( u, _mm_set1_epi32( 1812 ) ), 10 ) );
+  r = _mm_min_epi32( _mm_max_epi32( r, zero ), maxRgb );
+  g = _mm_min_epi32( _mm_max_epi32( g, zero ), maxRgb );
+  b = _mm_min_epi32( _mm_max_epi32( b, zero ), maxRgb );
+  __m128i argb = _mm_or_si128( _mm_slli_epi32( r, 16 ), _mm_slli_epi32( g, 8 ) );
+  return _mm_or_si128( _mm_or_si128( argb, b ), _mm_set1_epi32( (int)0xFF000000 ) );
+}
+
+/**
+ * Load 4 samples into 32-bit lanes
+ */
+CLP_TARGET_SSE41 static inline __m128i load4_sse41( const ClpPel* p )
+{
+  return _mm_cvtepu16_epi32( _mm_loadl_epi64( (const __m128i*)p ) );
+}
+
+CLP_TARGET_SSE41 static inline __m128i load4_sse41( const ClpByte* p )
+{
+  int i;
+  memcpy( &i, p, sizeof( int ) );
+  return _mm_cvtepu8_epi32( _mm_cvtsi32_si128( i ) );
+}
+
+/**
+ * Load 2 samples into 32-bit lanes, each one twice (subsampled chroma)
+ */
+CLP_TARGET_SSE41 static inline __m128i load2x2_sse41( const ClpPel* p )
+{
+  int i;
+  memcpy( &i, p, sizeof( int ) );
+  __m128i v = _mm_cvtsi32_si128( i );
+  return _mm_cvtepu16_epi32( _mm_unpacklo_epi16( v, v ) );
+}
+
+CLP_TARGET_SSE41 static inline __m128i load2x2_sse41( const ClpByte* p )
+{
+  unsigned short i;
+  memcpy( &i, p, sizeof( i ) );
+  __m128i v = _mm_cvtsi32_si128( i );
+  return _mm_cvtepu8_epi32( _mm_unpacklo_epi8( v, v ) );
+}
+
+template <unsigned int LOG2_CHROMA_WIDTH, typename T = ClpPel>
+CLP_TARGET_SSE41 static void yuvToArgbRow_sse41( const T* pY, const T* pU, const T* pV, unsigned int* pARGB, unsigned int width,
+                                                 unsigned int shiftBits )
+{
+  const __m128i shift = _mm_cvtsi32_si128( shiftBits );
+  unsigned int x = 0;
+  for( ; x + 4 <= width; x += 4 )
+  {
+    __m128i y = load4_sse41( pY + x );
+    __m128i u = LOG2_CHROMA_WIDTH ? load2x2_sse41( pU + ( x >> 1 ) ) : load4_sse41( pU + x );
+    __m128i v = LOG2_CHROMA_WIDTH ? load2x2_sse41( pV + ( x >> 1 ) ) : load4_sse41( pV + x );
+    y = _mm_srl_epi32( y, shift );
+    u = _mm_srl_epi32( u, shift );
+    v = _mm_srl_epi32( v, shift );
+    _mm_storeu_si128( (__m128i*)( pARGB + x ), yuvToArgb_sse41( y, u, v ) );
+  }
+  yuvToArgbRow_c<LOG2_CHROMA_WIDTH>( pY + x, pU + ( x >> LOG2_CHROMA_WIDTH ), pV + ( x >> LOG2_CHROMA_WIDTH ), pARGB + x,
+                                     width - x, shiftBits );
+}
+
+/**
+ * Unsigned division by 1000 (exact for any 32-bit value)
+ */
+CLP_TARGET_SSE41 static inline __m128i div1000_sse41( __m128i x )
+{
+  const __m128i magic = _mm_set1_epi32( 274877907 );
+  __m128i even = _mm_srli_epi64( _mm_mul_epu32( x, magic ), 38 );
+  __m128i odd = _mm_srli_epi64( _mm_mul_epu32( _mm_srli_epi64( x, 32 ), magic ), 38 );
+  return _mm_or_si128( even, _mm_slli_epi64( odd, 32 ) );
+}
+
+CLP_TARGET_SSE41 static inline __m128i rgbToLuma_sse41( __m128i r, __m128i g, __m128i b )
+{
+  __m128i sum = _mm_add_epi32( _mm_mullo_epi32( r, _mm_set1_epi32( 299 ) ), _mm_mullo_epi32( g, _mm_set1_epi32( 587 ) ) );
+  sum = _mm_add_epi32( sum, _mm_mullo_epi32( b, _mm_set1_epi32( 114 ) ) );
+  return div1000_sse41( _mm_add_epi32( sum, _mm_set1_epi32( 500 ) ) );
+}
+
+/**
+ * Load 8 samples into 16-bit lanes
+ */
+CLP_TARGET_SSE41 static inline __m128i load8_sse41( const ClpPel* p )
+{
+  return _mm_loadu_si128( (const __m128i*)p );
+}
+
+CLP_TARGET_SSE41 static inline __m128i load8_sse41( const ClpByte* p )
+{
+  return _mm_cvtepu8_epi16( _mm_loadl_epi64( (const __m128i*)p ) );
+}
+
+CLP_TARGET_SSE41 static inline void store8_sse41( ClpPel* p, __m128i v )
+{
+  _mm_storeu_si128( (__m128i*)p, v );
+}
+
+CLP_TARGET_SSE41 static inline void store8_sse41( ClpByte* p, __m128i v )
+{
+  _mm_storel_epi64( (__m128i*)p, _mm_packus_epi16( v, v ) );
+}
+
+template <typename T>
+CLP_TARGET_SSE41 static void rgbToLumaRow_sse41( const T* pR, const T* pG, const T* pB, T* pY, unsigned int width )
+{
+  unsigned int x = 0;
+  for( ; x + 8 <= width; x += 8 )
+  {
+    __m128i r = load8_sse41( pR + x );
+    __m128i g = load8_sse41( pG + x );
+    __m128i b = load8_sse41( pB + x );
+    __m128i lo = rgbToLuma_sse41( _mm_cvtepu16_epi32( r ), _mm_cvtepu16_epi32( g ), _mm_cvtepu16_epi32( b ) );
+    __m128i hi = rgbToLuma_sse41( _mm_cvtepu16_epi32( _mm_srli_si128( r, 8 ) ), _mm_cvtepu16_epi32( _mm_srli_si128( g, 8 ) ),
+                                  _mm_cvtepu16_epi32( _mm_srli_si128( b, 8 ) ) );
+    store8_sse41( pY + x, _mm_packus_epi32( lo, hi ) );
+  }
+  rgbToLumaRow_c( pR + x, pG + x, pB + x, pY + x, width - x );
+}
+
+CLP_TARGET_SSE41 static inline __m128i colorTransform_sse41( const __m128* m, const __m128* in, __m128 vMax )
+{
+  __m128 v = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( m[0], in[0] ), _mm_mul_ps( m[1], in[1] ) ), _mm_mul_ps( m[2], in[2] ) ),
+                         m[3] );
+  v = _mm_min_ps( _mm_max_ps( v, _mm_setzero_ps() ), vMax );
+  return _mm_cvttps_epi32( _mm_add_ps( v, _mm_set1_ps( 0.5f ) ) );
+}
+
+template <typename T>
+CLP_TARGET_SSE41 static void colorTransformRow_sse41( const float* coeffs, int maxValue, const T* p0, const T* p1, const T* p2, T* o0,
+                                                      T* o1, T* o2, unsigned int width )
+{
+  T* apOut[3] = { o0, o1, o2 };
+  __m128 m[12];
+  for( int i = 0; i < 12; i++ )
+    m[i] = _mm_set1_ps( coeffs[i] );
+  __m128 vMax = _mm_set1_ps( float( maxValue ) );
+  unsigned int x = 0;
+  for( ; x + 8 <= width; x += 8 )
+  {
+    __m128i a[3] = { load8_sse41( p0 + x ), load8_sse41( p1 + x ), load8_sse41( p2 + x ) };
+    __m128 lo[3];
+    __m128 hi[3];
+    for( int k = 0; k < 3; k++ )
+    {
+      lo[k] = _mm_cvtepi32_ps( _mm_cvtepu16_epi32( a[k] ) );
+      hi[k] = _mm_cvtepi32_ps( _mm_cvtepu16_epi32( _mm_srli_si128( a[k], 8 ) ) );
+    }
+    for( int c = 0; c < 3; c++ )
+      store8_sse41( apOut[c] + x, _mm_packus_epi32( colorTransform_sse41( m + 4 * c, lo, vMax ), colorTransform_sse41( m + 4 * c, hi, vMax ) ) );
+  }
+  colorTransformRow_c( coeffs, maxValue, p0 + x, p1 + x, p2 + x, o0 + x, o1 + x, o2 + x, width - x );
+}
+
+/**
+ * Byte shuffles between three planes and one interleaved row: entry
+ * [k][c] moves the samples of plane c into the output vector k
+ * (interleave) or the samples of input vector c into plane k
+ * (deinterleave). 0x80 clears the byte
+ */
+alignas( 16 ) static const ClpByte s_aaucInterleave8[3][3][16] = {
+    { { 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80, 0x05 },
+      { 0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80 },
+      { 0x80, 0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80 } },
+    { { 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A, 0x80 },
+      { 0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A },
+      { 0x80, 0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80 } },
+    { { 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80, 0x80 },
+      { 0x80, 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80 },
+      { 0x0A, 0x80, 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F } }
+};
+alignas( 16 ) static const ClpByte s_aaucInterleave16[3][3][16] = {
+    { { 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80 },
+      { 0x80, 0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x04, 0x05 },
+      { 0x80, 0x80, 0x80, 0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80 } },
+    { { 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80, 0x80, 0x80, 0x0A, 0x0B },
+      { 0x80, 0x80, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80, 0x80, 0x80 },
+      { 0x04, 0x05, 0x80, 0x80, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80 } },
+    { { 0x80, 0x80, 0x80, 0x80, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80 },
+      { 0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x0E, 0x0F, 0x80, 0x80 },
+      { 0x80, 0x80, 0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x0E, 0x0F } }
+};
+alignas( 16 ) static const ClpByte s_aaucDeinterleave8[3][3][16] = {
+    { { 0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0B, 0x0E, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x04, 0x07, 0x0A, 0x0D } },
+    { { 0x01, 0x04, 0x07, 0x0A, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0B, 0x0E } },
+    { { 0x02, 0x05, 0x08, 0x0B, 0x0E, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x04, 0x07, 0x0A, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F } }
+};
+alignas( 16 ) static const ClpByte s_aaucDeinterleave16[3][3][16] = {
+    { { 0x00, 0x01, 0x06, 0x07, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x08, 0x09, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x04, 0x05, 0x0A, 0x0B } },
+    { { 0x02, 0x03, 0x08, 0x09, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x04, 0x05, 0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x01, 0x06, 0x07, 0x0C, 0x0D } },
+    { { 0x04, 0x05, 0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x00, 0x01, 0x06, 0x07, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+      { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x08, 0x09, 0x0E, 0x0F } }
+};
+
+template <typename T>
+CLP_TARGET_SSE41 static void interleave3_sse41( const T* p0, const T* p1, const T* p2, T* out, unsigned long count )
+{
+  const ClpByte( *masks )[3][16] = sizeof( T ) == sizeof( ClpByte ) ? s_aaucInterleave8 : s_aaucInterleave16;
+  const unsigned long n = 16 / sizeof( T );
+  unsigned long i = 0;
+  for( ; i + n <= count; i += n )
+  {
+    __m128i v[3] = { _mm_loadu_si128( (const __m128i*)( p0 + i ) ), _mm_loadu_si128( (const __m128i*)( p1 + i ) ),
+                     _mm_loadu_si128( (const __m128i*)( p2 + i ) ) };
+    for( int k = 0; k < 3; k++ )
+    {
+      __m128i r = _mm_shuffle_epi8( v[0], _mm_load_si128( (const __m128i*)masks[k][0] ) );
+      r = _mm_or_si128( r, _mm_shuffle_epi8( v[1], _mm_load_si128( (const __m128i*)masks[k][1] ) ) );
+      r = _mm_or_si128( r, _mm_shuffle_epi8( v[2], _mm_load_si128( (const __m128i*)masks[k][2] ) ) );
+      _mm_storeu_si128( (__m128i*)( out + 3 * i + k * n ), r );
+    }
+  }
+  interleave3_c( p0 + i, p1 + i, p2 + i, out + 3 * i, count - i );
+}
+
+template <typename T>
+CLP_TARGET_SSE41 static void deinterleave3_sse41( const T* in, T* p0, T* p1, T* p2, unsigned long count )
+{
+  const ClpByte( *masks )[3][16] = sizeof( T ) == sizeof( ClpByte ) ? s_aaucDeinterleave8 : s_aaucDeinterleave16;
+  const unsigned long n = 16 / sizeof( T );
+  T* out[3] = { p0, p1, p2 };
+  unsigned long i = 0;
+  for( ; i + n <= count; i += n )
+  {
+    const __m128i* pIn = (const __m128i*)( in + 3 * i );
+    __m128i v[3] = { _mm_loadu_si128( pIn ), _mm_loadu_si128( pIn + 1 ), _mm_loadu_si128( pIn + 2 ) };
+    for( int k = 0; k < 3; k++ )
+    {
+      __m128i r = _mm_shuffle_epi8( v[0], _mm_load_si128( (const __m128i*)masks[k][0] ) );
+      r = _mm_or_si128( r, _mm_shuffle_epi8( v[1], _mm_load_si128( (const __m128i*)masks[k][1] ) ) );
+      r = _mm_or_si128( r, _mm_shuffle_epi8( v[2], _mm_load_si128( (const __m128i*)masks[k][2] ) ) );
+      _mm_storeu_si128( (__m128i*)( out[k] + i ), r );
+    }
+  }
+  deinterleave3_c( in + 3 * i, p0 + i, p1 + i, p2 + i, count - i );
+}
+
+/**
+ * Drops the alpha byte of 4 pixels at a time; each store writes 16 bytes
+ * for 12 bytes of output, so the loop stops 2 pixels before the end
+ */
+CLP_TARGET_SSE41 static void argbToBgr_sse41( const unsigned int* pARGB, ClpByte* out, unsigned long count )
+{
+  const __m128i mask = _mm_setr_epi8( 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -128, -128, -128, -128 );
+  unsigned long i = 0;
+  for( ; i + 6 <= count; i += 4 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)( pARGB + i ) );
+    _mm_storeu_si128( (__m128i*)( out + 3 * i ), _mm_shuffle_epi8( v, mask ) );
+  }
+  argbToBgr_c( pARGB + i, out + 3 * i, count - i );
+}
+
+/**
+ * Split the 2 * n samples at p into the even and odd positions
+ */
+CLP_TARGET_SSE41 static inline void loadEvenOdd_sse41( const ClpByte* p, __m128i& even, __m128i& odd )
+{
+  const __m128i mask = _mm_set1_epi16( 0x00FF );
+  __m128i a = _mm_loadu_si128( (const __m128i*)p );
+  __m128i b = _mm_loadu_si128( (const __m128i*)( p + 16 ) );
+  even = _mm_packus_epi16( _mm_and_si128( a, mask ), _mm_and_si128( b, mask ) );
+  odd = _mm_packus_epi16( _mm_srli_epi16( a, 8 ), _mm_srli_epi16( b, 8 ) );
+}
+
+CLP_TARGET_SSE41 static inline void loadEvenOdd_sse41( const ClpPel* p, __m128i& even, __m128i& odd )
+{
+  const __m128i mask = _mm_set1_epi32( 0x0000FFFF );
+  __m128i a = _mm_loadu_si128( (const __m128i*)p );
+  __m128i b = _mm_loadu_si128( (const __m128i*)( p + 8 ) );
+  even = _mm_packus_epi32( _mm_and_si128( a, mask ), _mm_and_si128( b, mask ) );
+  odd = _mm_packus_epi32( _mm_srli_epi32( a, 16 ), _mm_srli_epi32( b, 16 ) );
+}
+
+/**
+ * The vector loop covers the outputs whose three taps are inside the
+ * row; the first one and the right edge go through the C kernel
+ */
+template <typename T>
+CLP_TARGET_SSE41 static void downsampleRow_sse41( const T* in, T* out, unsigned int outWidth, unsigned int inWidth )
+{
+  const unsigned int n = 16 / sizeof( T );
+  unsigned int x = std::min( 1u, outWidth );
+  downsampleRow_c( in, out, 0, x, inWidth );
+  for( ; x + n <= outWidth && 2 * ( x + n ) < inWidth; x += n )
+  {
+    __m128i left, centre, right, odd;
+    loadEvenOdd_sse41( in + 2 * x - 1, left, centre );
+    loadEvenOdd_sse41( in + 2 * x + 1, right, odd );
+    _mm_storeu_si128( (__m128i*)( out + x ), avgSamples_sse2<T>( centre, avgSamples_sse2<T>( left, right ) ) );
+  }
+  downsampleRow_c( in, out, x, outWidth, inWidth );
+}
+
+template <typename T>
+CLP_TARGET_SSE41 static void upsampleRow_sse41( const T* in, T* out, unsigned int outWidth, unsigned int inWidth )
+{
+  const unsigned int n = 16 / sizeof( T );
+  unsigned int x = 0;
+  for( ; x + n < inWidth && 2 * ( x + n ) <= outWidth; x += n )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( in + x ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( in + x + 1 ) );
+    __m128i m = avgSamples_sse2<T>( a, b );
+    __m128i lo = sizeof( T ) == sizeof( ClpByte ) ? _mm_unpacklo_epi8( a, m ) : _mm_unpacklo_epi16( a, m );
+    __m128i hi = sizeof( T ) == sizeof( ClpByte ) ? _mm_unpackhi_epi8( a, m ) : _mm_unpackhi_epi16( a, m );
+    _mm_storeu_si128( (__m128i*)( out + 2 * x ), lo );
+    _mm_storeu_si128( (__m128i*)( out + 2 * x + n ), hi );
+  }
+  upsampleRow_c( in, out, x, outWidth, inWidth );
+}
+
+/**
+ * Rounding uses a saturated add: the sums that saturate give the
+ * maximum value after the shift, as the clamp of the C kernel
+ */
+CLP_TARGET_SSE41 static void shiftSamples_sse41( const ClpPel* in, ClpPel* out, unsigned long count, int shift, ClpPel maxval )
+{
+  unsigned long i = 0;
+  if( shift >= 0 )
+  {
+    const __m128i cnt = _mm_cvtsi32_si128( shift );
+    for( ; i + 8 <= count; i += 8 )
+      _mm_storeu_si128( (__m128i*)( out + i ), _mm_sll_epi16( _mm_loadu_si128( (const __m128i*)( in + i ) ), cnt ) );
+  }
+  else
+  {
+    const __m128i cnt = _mm_cvtsi32_si128( -shift );
+    const __m128i round = _mm_set1_epi16( short( 1 << ( -shift - 1 ) ) );
+    const __m128i maxv = _mm_set1_epi16( short( maxval ) );
+    for( ; i + 8 <= count; i += 8 )
+    {
+      __m128i v = _mm_adds_epu16( _mm_loadu_si128( (const __m128i*)( in + i ) ), round );
+      _mm_storeu_si128( (__m128i*)( out + i ), _mm_min_epu16( _mm_srl_epi16( v, cnt ), maxv ) );
+    }
+  }
+  shiftSamples_c( in + i, out + i, count - i, shift, maxval );
+}
+
+/*
+ **************************************************************
+ * AVX2 implementations
+ **************************************************************
+ */
+
+CLP_TARGET_AVX2 static void unpack8_avx2( const ClpByte* in, ClpPel* out, unsigned long count )
+{
+  unsigned long i = 0;
+  for( ; i + 32 <= count; i += 32 )
+  {
+    __m128i v0 = _mm_loadu_si128( (const __m128i*)( in + i ) );
+    __m128i v1 = _mm_loadu_si128( (const __m128i*)( in + i + 16 ) );
+    _mm256_storeu_si256( (__m256i*)( out + i ), _mm256_cvtepu8_epi16( v0 ) );
+    _mm256_storeu_si256( (__m256i*)( out + i + 16 ), _mm256_cvtepu8_epi16( v1 ) );
+  }
+  unpack8_c<0>( in + i, out + i, count - i );
+}
+
+CLP_TARGET_AVX2 static void unpack8s1_avx2( const ClpByte* in, ClpPel* out, unsigned long count )
+{
+  const __m256i mask = _mm256_set1_epi16( 0x00FF );
+  unsigned long i = 0;
+  for( ; i + 16 < count; i += 16 )
+  {
+    __m256i v = _mm256_loadu_si256( (const __m256i*)( in + 2 * i ) );
+    _mm256_storeu_si256( (__m256i*)( out + i ), _mm256_and_si256( v, mask ) );
+  }
+  unpack8_c<1>( in + 2 * i, out + i, count - i );
+}
+
+CLP_TARGET_AVX2 static void unpack8s3_avx2( const ClpByte* in, ClpPel* out, unsigned long count )
+{
+  const __m256i mask = _mm256_set1_epi32( 0x000000FF );
+  unsigned long i = 0;
+  for( ; i + 16 < count; i += 16 )
+  {
+    __m256i v0 = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( in + 4 * i ) ), mask );
+    __m256i v1 = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( in + 4 * i + 32 ) ), mask );
+    // packs works on 128-bit lanes, restore the sample order afterwards
+    __m256i v = _mm256_permute4x64_epi64( _mm256_packus_epi32( v0, v1 ), 0xD8 );
+    _mm256_storeu_si256( (__m256i*)( out + i ), v );
+  }
+  unpack8_c<3>( in + 4 * i, out + i, count - i );
+}
+
+template <bool IS_BIG_ENDIAN>
+CLP_TARGET_AVX2 static void unpack16_avx2( const ClpByte* in, ClpPel* out, unsigned long count, int maxval )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i lsbMask = _mm256_set1_epi16( 0x00FF );
+  const __m256i maxv = _mm256_set1_epi16( (short)maxval );
+  const bool bClip = maxval < 0xFFFF;
+  unsigned long i = 0;
+  for( ; i + 16 <= count; i += 16 )
+  {
+    __m256i v = _mm256_loadu_si256( (const __m256i*)( in + 2 * i ) );
+    if( IS_BIG_ENDIAN )
+      v = _mm256_or_si256( _mm256_slli_epi16( v, 8 ), _mm256_srli_epi16( v, 8 ) );
+    if( bClip )
+    {
+      __m256i inRange = _mm256_cmpeq_epi16( _mm256_subs_epu16( v, maxv ), zero );
+      if( IS_BIG_ENDIAN )
+        v = _mm256_blendv_epi8( _mm256_and_si256( v, lsbMask ), v, inRange );
+      else
+        v = _mm256_and_si256( inRange, v );
+    }
+    _mm256_storeu_si256( (__m256i*)( out + i ), v );
+  }
+  unpack16_c<IS_BIG_ENDIAN>( in + 2 * i, out + i, count - i, maxval );
+}
+
+CLP_TARGET_AVX2 static void pack8_avx2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  const __m256i mask = _mm256_set1_epi16( 0x00FF );
+  unsigned long i = 0;
+  for( ; i + 32 <= count; i += 32 )
+  {
+    __m256i v0 = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( in + i ) ), mask );
+    __m256i v1 = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( in + i + 16 ) ), mask );
+    __m256i v = _mm256_permute4x64_epi64( _mm256_packus_epi16( v0, v1 ), 0xD8 );
+    _mm256_storeu_si256( (__m256i*)( out + i ), v );
+  }
+  pack8_c<0>( in + i, out + i, count - i );
+}
+
+CLP_TARGET_AVX2 static void pack8s1_avx2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  const __m256i mask = _mm256_set1_epi16( 0x00FF );
+  unsigned long i = 0;
+  for( ; i + 16 < count; i += 16 )
+  {
+    __m256i* pOut = (__m256i*)( out + 2 * i );
+    __m256i v = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( in + i ) ), mask );
+    __m256i keep = _mm256_andnot_si256( mask, _mm256_loadu_si256( pOut ) );
+    _mm256_storeu_si256( pOut, _mm256_or_si256( keep, v ) );
+  }
+  pack8_c<1>( in + i, out + 2 * i, count - i );
+}
+
+CLP_TARGET_AVX2 static void pack8s3_avx2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  const __m256i mask = _mm256_set1_epi32( 0x000000FF );
+  unsigned long i = 0;
+  for( ; i + 16 < count; i += 16 )
+  {
+    __m256i* pOut = (__m256i*)( out + 4 * i );
+    __m256i v0 = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i*)( in + i ) ) );
+    __m256i v1 = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i*)( in + i + 8 ) ) );
+    __m256i keep0 = _mm256_andnot_si256( mask, _mm256_loadu_si256( pOut ) );
+    __m256i keep1 = _mm256_andnot_si256( mask, _mm256_loadu_si256( pOut + 1 ) );
+    _mm256_storeu_si256( pOut, _mm256_or_si256( keep0, _mm256_and_si256( v0, mask ) ) );
+    _mm256_storeu_si256( pOut + 1, _mm256_or_si256( keep1, _mm256_and_si256( v1, mask ) ) );
+  }
+  pack8_c<3>( in + i, out + 4 * i, count - i );
+}
+
+template <bool IS_BIG_ENDIAN>
+CLP_TARGET_AVX2 static void pack16_avx2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  unsigned long i = 0;
+  for( ; i + 16 <= count; i += 16 )
+  {
+    __m256i v = _mm256_loadu_si256( (const __m256i*)( in + i ) );
+    if( IS_BIG_ENDIAN )
+      v = _mm256_or_si256( _mm256_slli_epi16( v, 8 ), _mm256_srli_epi16( v, 8 ) );
+    _mm256_storeu_si256( (__m256i*)( out + 2 * i ), v );
+  }
+  pack16_c<IS_BIG_ENDIAN>( in + i, out + 2 * i, count - i );
+}
+
+CLP_TARGET_AVX2 static void narrow_avx2( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  const __m256i bias = _mm256_set1_epi16( (short)0xFF00 );
+  unsigned long i = 0;
+  for( ; i + 32 <= count; i += 32 )
+  {
+    __m256i v0 = _mm256_subs_epu16( _mm256_adds_epu16( _mm256_loadu_si256( (const __m256i*)( in + i ) ), bias ), bias );
+    __m256i v1 = _mm256_subs_epu16( _mm256_adds_epu16( _mm256_loadu_si256( (const __m256i*)( in + i + 16 ) ), bias ), bias );
+    _mm256_storeu_si256( (__m256i*)( out + i ), _mm256_permute4x64_epi64( _mm256_packus_epi16( v0, v1 ), 0xD8 ) );
+  }
+  narrow_c( in + i, out + i, count - i );
+}
+
+CLP_TARGET_AVX2 static inline __m256i yuvToArgb_avx2( __m256i y, __m256i u, __m256i v )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i maxRgb = _mm256_set1_epi32( 255 );
+  u = _mm256_sub_epi32( u, _mm256_set1_epi32( 128 ) );
+  v = _mm256_sub_epi32( v, _mm256_set1_epi32( 128 ) );
+  __m256i r = _mm256_add_epi32( y, _mm256_srai_epi32( _mm256_mullo_epi32( v, _mm256_set1_epi32( 1436 ) ), 10 ) );
+  __m256i g = _mm256_add_epi32( _mm256_mullo_epi32( u, _mm256_set1_epi32( 352 ) ), _mm256_mullo_epi32( v, _mm256_set1_epi32( 731 ) ) );
+  g = _mm256_sub_epi32( y, _mm256_srai_epi32( g, 10 ) );
+  __m256i b = _mm256_add_epi32( y, _mm256_srai_epi32( _mm256_mullo_epi32( u, _mm256_set1_epi32( 1812 ) ), 10 ) );
+  r = _mm256_min_epi32( _mm256_max_epi32( r, zero ), maxRgb );
+  g = _mm256_min_epi32( _mm256_max_epi32( g, zero ), maxRgb );
+  b = _mm256_min_epi32( _mm256_max_epi32( b, zero ), maxRgb );
+  __m256i argb = _mm256_or_si256( _mm256_slli_epi32( r, 16 ), _mm256_slli_epi32( g, 8 ) );
+  return _mm256_or_si256( _mm256_or_si256( argb, b ), _mm256_set1_epi32( (int)0xFF000000 ) );
+}
+
+/**
+ * Load 8 samples into 32-bit lanes
+ */
+CLP_TARGET_AVX2 static inline __m256i load8_avx2( const ClpPel* p )
+{
+  return _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i*)p ) );
+}
+
+CLP_TARGET_AVX2 static inline __m256i load8_avx2( const ClpByte* p )
+{
+  return _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)p ) );
+}
+
+/**
+ * Load 4 samples into 32-bit lanes, each one twice (subsampled chroma)
+ */
+CLP_TARGET_AVX2 static inline __m256i load4x2_avx2( const ClpPel* p )
+{
+  __m128i v = _mm_loadl_epi64( (const __m128i*)p );
+  return _mm256_cvtepu16_epi32( _mm_unpacklo_epi16( v, v ) );
+}
+
+CLP_TARGET_AVX2 static inline __m256i load4x2_avx2( const ClpByte* p )
+{
+  int i;
+  memcpy( &i, p, sizeof( int ) );
+  __m128i v = _mm_cvtsi32_si128( i );
+  return _mm256_cvtepu8_epi32( _mm_unpacklo_epi8( v, v ) );
+}
+
+template <unsigned int LOG2_CHROMA_WIDTH, typename T = ClpPel>
+CLP_TARGET_AVX2 static void yuvToArgbRow_avx2( const T* pY, const T* pU, const T* pV, unsigned int* pARGB, unsigned int width,
+                                               unsigned int shiftBits )
+{
+  const __m128i shift = _mm_cvtsi32_si128( shiftBits );
+  unsigned int x = 0;
+  for( ; x + 8 <= width; x += 8 )
+  {
+    __m256i y = _mm256_srl_epi32( load8_avx2( pY + x ), shift );
+    __m256i u = _mm256_srl_epi32( LOG2_CHROMA_WIDTH ? load4x2_avx2( pU + ( x >> 1 ) ) : load8_avx2( pU + x ), shift );
+    __m256i v = _mm256_srl_epi32( LOG2_CHROMA_WIDTH ? load4x2_avx2( pV + ( x >> 1 ) ) : load8_avx2( pV + x ), shift );
+    _mm256_storeu_si256( (__m256i*)( pARGB + x ), yuvToArgb_avx2( y, u, v ) );
+  }
+  yuvToArgbRow_c<LOG2_CHROMA_WIDTH>( pY + x, pU + ( x >> LOG2_CHROMA_WIDTH ), pV + ( x >> LOG2_CHROMA_WIDTH ), pARGB + x,
+                                     width - x, shiftBits );
+}
+
+CLP_TARGET_AVX2 static inline __m256i div1000_avx2( __m256i x )
+{
+  const __m256i magic = _mm256_set1_epi32( 274877907 );
+  __m256i even = _mm256_srli_epi64( _mm256_mul_epu32( x, magic ), 38 );
+  __m256i odd = _mm256_srli_epi64( _mm256_mul_epu32( _mm256_srli_epi64( x, 32 ), magic ), 38 );
+  return _mm256_or_si256( even, _mm256_slli_epi64( odd, 32 ) );
+}
+
+CLP_TARGET_AVX2 static inline __m256i rgbToLuma_avx2( __m256i r, __m256i g, __m256i b )
+{
+  __m256i sum =
+      _mm256_add_epi32( _mm256_mullo_epi32( r, _mm256_set1_epi32( 299 ) ), _mm256_mullo_epi32( g, _mm256_set1_epi32( 587 ) ) );
+  sum = _mm256_add_epi32( sum, _mm256_mullo_epi32( b, _mm256_set1_epi32( 114 ) ) );
+  return div1000_avx2( _mm256_add_epi32( sum, _mm256_set1_epi32( 500 ) ) );
+}
+
+/**
+ * Load 16 samples into 16-bit lanes
+ */
+CLP_TARGET_AVX2 static inline __m256i load16_avx2( const ClpPel* p )
+{
+  return _mm256_loadu_si256( (const __m256i*)p );
+}
+
+CLP_TARGET_AVX2 static inline __m256i load16_avx2( const ClpByte* p )
+{
+  return _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*)p ) );
+}
+
+CLP_TARGET_AVX2 static inline void store16_avx2( ClpPel* p, __m256i v )
+{
+  _mm256_storeu_si256( (__m256i*)p, v );
+}
+
+CLP_TARGET_AVX2 static inline void store16_avx2( ClpByte* p, __m256i v )
+{
+  _mm_storeu_si128( (__m128i*)p, _mm_packus_epi16( _mm256_castsi256_si128( v ), _mm256_extracti128_si256( v, 1 ) ) );
+}
+
+template <typename T>
+CLP_TARGET_AVX2 static void rgbToLumaRow_avx2( const T* pR, const T* pG, const T* pB, T* pY, unsigned int width )
+{
+  unsigned int x = 0;
+  for( ; x + 16 <= width; x += 16 )
+  {
+    __m256i r = load16_avx2( pR + x );
+    __m256i g = load16_avx2( pG + x );
+    __m256i b = load16_avx2( pB + x );
+    __m256i lo = rgbToLuma_avx2( _mm256_cvtepu16_epi32( _mm256_castsi256_si128( r ) ),
+                                 _mm256_cvtepu16_epi32( _mm256_castsi256_si128( g ) ),
+                                 _mm256_cvtepu16_epi32( _mm256_castsi256_si128( b ) ) );
+    __m256i hi = rgbToLuma_avx2( _mm256_cvtepu16_epi32( _mm256_extracti128_si256( r, 1 ) ),
+                                 _mm256_cvtepu16_epi32( _mm256_extracti128_si256( g, 1 ) ),
+                                 _mm256_cvtepu16_epi32( _mm256_extracti128_si256( b, 1 ) ) );
+    // packus works on 128-bit lanes, restore the pixel order
+    store16_avx2( pY + x, _mm256_permute4x64_epi64( _mm256_packus_epi32( lo, hi ), 0xD8 ) );
+  }
+  rgbToLumaRow_c( pR + x, pG + x, pB + x, pY + x, width - x );
+}
+
+CLP_TARGET_AVX2 static inline __m256i colorTransform_avx2( const __m256* m, const __m256* in, __m256 vMax )
+{
+  __m256 v = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( m[0], in[0] ), _mm256_mul_ps( m[1], in[1] ) ),
+                                           _mm256_mul_ps( m[2], in[2] ) ),
+                            m[3] );
+  v = _mm256_min_ps( _mm256_max_ps( v, _mm256_setzero_ps() ), vMax );
+  return _mm256_cvttps_epi32( _mm256_add_ps( v, _mm256_set1_ps( 0.5f ) ) );
+}
+
+template <typename T>
+CLP_TARGET_AVX2 static void colorTransformRow_avx2( const float* coeffs, int maxValue, const T* p0, const T* p1, const T* p2, T* o0,
+                                                    T* o1, T* o2, unsigned int width )
+{
+  T* apOut[3] = { o0, o1, o2 };
+  __m256 m[12];
+  for( int i = 0; i < 12; i++ )
+    m[i] = _mm256_set1_ps( coeffs[i] );
+  __m256 vMax = _mm256_set1_ps( float( maxValue ) );
+  unsigned int x = 0;
+  for( ; x + 16 <= width; x += 16 )
+  {
+    __m256i a[3] = { load16_avx2( p0 + x ), load16_avx2( p1 + x ), load16_avx2( p2 + x ) };
+    __m256 lo[3];
+    __m256 hi[3];
+    for( int k = 0; k < 3; k++ )
+    {
+      lo[k] = _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( _mm256_castsi256_si128( a[k] ) ) );
+      hi[k] = _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( _mm256_extracti128_si256( a[k], 1 ) ) );
+    }
+    for( int c = 0; c < 3; c++ )
+    {
+      __m256i v = _mm256_packus_epi32( colorTransform_avx2( m + 4 * c, lo, vMax ), colorTransform_avx2( m + 4 * c, hi, vMax ) );
+      // packus works on 128-bit lanes, restore the pixel order
+      store16_avx2( apOut[c] + x, _mm256_permute4x64_epi64( v, 0xD8 ) );
+    }
+  }
+  colorTransformRow_c( coeffs, maxValue, p0 + x, p1 + x, p2 + x, o0 + x, o1 + x, o2 + x, width - x );
+}
+
+CLP_TARGET_AVX2 static unsigned long long ssd8_avx2( const ClpPel* pA, const ClpPel* pB, unsigned long count )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc64 = zero;
+  unsigned long i = 0;
+  unsigned long vecEnd = count & ~15UL;
+  while( i < vecEnd )
+  {
+    unsigned long blockEnd = std::min( vecEnd, i + 16UL * SSD8_BLOCK );
+    __m256i acc32 = zero;
+    for( ; i < blockEnd; i += 16 )
+    {
+      __m256i diff =
+          _mm256_sub_epi16( _mm256_loadu_si256( (const __m256i*)( pA + i ) ), _mm256_loadu_si256( (const __m256i*)( pB + i ) ) );
+      acc32 = _mm256_add_epi32( acc32, _mm256_madd_epi16( diff, diff ) );
+    }
+    acc64 = _mm256_add_epi64( acc64, _mm256_unpacklo_epi32( acc32, zero ) );
+    acc64 = _mm256_add_epi64( acc64, _mm256_unpackhi_epi32( acc32, zero ) );
+  }
+  unsigned long long lanes[4];
+  _mm256_storeu_si256( (__m256i*)lanes, acc64 );
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ssd_c( pA + i, pB + i, count - i );
+}
+
+CLP_TARGET_AVX2 static unsigned long long ssdByte_avx2( const ClpByte* pA, const ClpByte* pB, unsigned long count )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc64 = zero;
+  unsigned long i = 0;
+  unsigned long vecEnd = count & ~31UL;
+  while( i < vecEnd )
+  {
+    unsigned long blockEnd = std::min( vecEnd, i + 32UL * SSD8_BLOCK );
+    __m256i acc32 = zero;
+    for( ; i < blockEnd; i += 32 )
+    {
+      __m256i a = _mm256_loadu_si256( (const __m256i*)( pA + i ) );
+      __m256i b = _mm256_loadu_si256( (const __m256i*)( pB + i ) );
+      // Lane order does not matter for the sum
+      __m256i diffLo = _mm256_sub_epi16( _mm256_unpacklo_epi8( a, zero ), _mm256_unpacklo_epi8( b, zero ) );
+      __m256i diffHi = _mm256_sub_epi16( _mm256_unpackhi_epi8( a, zero ), _mm256_unpackhi_epi8( b, zero ) );
+      acc32 = _mm256_add_epi32( acc32, _mm256_add_epi32( _mm256_madd_epi16( diffLo, diffLo ), _mm256_madd_epi16( diffHi, diffHi ) ) );
+    }
+    acc64 = _mm256_add_epi64( acc64, _mm256_unpacklo_epi32( acc32, zero ) );
+    acc64 = _mm256_add_epi64( acc64, _mm256_unpackhi_epi32( acc32, zero ) );
+  }
+  unsigned long long lanes[4];
+  _mm256_storeu_si256( (__m256i*)lanes, acc64 );
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ssd_c( pA + i, pB + i, count - i );
+}
+
+CLP_TARGET_AVX2 static unsigned long long ssd16_avx2( const ClpPel* pA, const ClpPel* pB, unsigned long count )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc64 = zero;
+  unsigned long i = 0;
+  for( ; i + 16 <= count; i += 16 )
+  {
+    __m256i a = _mm256_loadu_si256( (const __m256i*)( pA + i ) );
+    __m256i b = _mm256_loadu_si256( (const __m256i*)( pB + i ) );
+    __m256i diff = _mm256_or_si256( _mm256_subs_epu16( a, b ), _mm256_subs_epu16( b, a ) );
+    __m256i sqLo = _mm256_mullo_epi16( diff, diff );
+    __m256i sqHi = _mm256_mulhi_epu16( diff, diff );
+    __m256i sq0 = _mm256_unpacklo_epi16( sqLo, sqHi );
+    __m256i sq1 = _mm256_unpackhi_epi16( sqLo, sqHi );
+    acc64 = _mm256_add_epi64( acc64, _mm256_add_epi64( _mm256_unpacklo_epi32( sq0, zero ), _mm256_unpackhi_epi32( sq0, zero ) ) );
+    acc64 = _mm256_add_epi64( acc64, _mm256_add_epi64( _mm256_unpacklo_epi32( sq1, zero ), _mm256_unpackhi_epi32( sq1, zero ) ) );
+  }
+  unsigned long long lanes[4];
+  _mm256_storeu_si256( (__m256i*)lanes, acc64 );
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ssd_c( pA + i, pB + i, count - i );
+}
+
+CLP_TARGET_AVX2 static void absDiff_avx2( const ClpPel* pA, const ClpPel* pB, ClpPel* pOut, unsigned long count )
+{
+  unsigned long i = 0;
+  for( ; i + 16 <= count; i += 16 )
+  {
+    __m256i a = _mm256_loadu_si256( (const __m256i*)( pA + i ) );
+    __m256i b = _mm256_loadu_si256( (const __m256i*)( pB + i ) );
+    _mm256_storeu_si256( (__m256i*)( pOut + i ), _mm256_or_si256( _mm256_subs_epu16( a, b ), _mm256_subs_epu16( b, a ) ) );
+  }
+  absDiff_c( pA + i, pB + i, pOut + i, count - i );
+}
+
+/*
+ * AVX-512 kernels (F and BW)
+ *
+ * Masked conversions avoid the undefined passthrough operand of the
+ * unmasked intrinsics, which GCC reports as uninitialized
+ */
+
+static const __mmask32 allLanes = 0xFFFFFFFF;
+
+CLP_TARGET_AVX512 static void unpack8_avx512( const ClpByte* in, ClpPel* out, unsigned long count )
+{
+  unsigned long i = 0;
+  for( ; i + 64 <= count; i += 64 )
+  {
+    __m256i v0 = _mm256_loadu_si256( (const __m256i*)( in + i ) );
+    __m256i v1 = _mm256_loadu_si256( (const __m256i*)( in + i + 32 ) );
+    _mm512_storeu_si512( (void*)( out + i ), _mm512_cvtepu8_epi16( v0 ) );
+    _mm512_storeu_si512( (void*)( out + i + 32 ), _mm512_cvtepu8_epi16( v1 ) );
+  }
+  unpack8_c<0>( in + i, out + i, count - i );
+}
+
+CLP_TARGET_AVX512 static void pack8_avx512( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  unsigned long i = 0;
+  for( ; i + 32 <= count; i += 32 )
+  {
+    // Keeps the least significant byte as pack8_c
+    __m512i v = _mm512_loadu_si512( (const void*)( in + i ) );
+    _mm256_storeu_si256( (__m256i*)( out + i ), _mm512_maskz_cvtepi16_epi8( allLanes, v ) );
+  }
+  pack8_c<0>( in + i, out + i, count - i );
+}
+
+CLP_TARGET_AVX512 static void narrow_avx512( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  unsigned long i = 0;
+  for( ; i + 32 <= count; i += 32 )
+  {
+    __m512i v = _mm512_loadu_si512( (const void*)( in + i ) );
+    _mm256_storeu_si256( (__m256i*)( out + i ), _mm512_maskz_cvtusepi16_epi8( allLanes, v ) );
+  }
+  narrow_c( in + i, out + i, count - i );
+}
+
+CLP_TARGET_AVX512 static unsigned long long ssdByte_avx512( const ClpByte* pA, const ClpByte* pB, unsigned long count )
+{
+  __m512i acc64 = _mm512_setzero_si512();
+  unsigned long i = 0;
+  unsigned long vecEnd = count & ~31UL;
+  while( i < vecEnd )
+  {
+    // Each 32-bit lane gets two squares per vector, as in ssdByte_avx2
+    unsigned long blockEnd = std::min( vecEnd, i + 32UL * SSD8_BLOCK );
+    __m512i acc32 = _mm512_setzero_si512();
+    for( ; i < blockEnd; i += 32 )
+    {
+      __m512i a = _mm512_cvtepu8_epi16( _mm256_loadu_si256( (const __m256i*)( pA + i ) ) );
+      __m512i b = _mm512_cvtepu8_epi16( _mm256_loadu_si256( (const __m256i*)( pB + i ) ) );
+      __m512i diff = _mm512_sub_epi16( a, b );
+      acc32 = _mm512_add_epi32( acc32, _mm512_madd_epi16( diff, diff ) );
+    }
+    acc64 = _mm512_add_epi64( acc64, _mm512_maskz_cvtepu32_epi64( 0xFF, _mm512_maskz_extracti64x4_epi64( 0xFF, acc32, 0 ) ) );
+    acc64 = _mm512_add_epi64( acc64, _mm512_maskz_cvtepu32_epi64( 0xFF, _mm512_maskz_extracti64x4_epi64( 0xFF, acc32, 1 ) ) );
+  }
+  unsigned long long lanes[8];
+  _mm512_storeu_si512( (void*)lanes, acc64 );
+  unsigned long long sum = 0;
+  for( int l = 0; l < 8; l++ )
+    sum += lanes[l];
+  return sum + ssd_c( pA + i, pB + i, count - i );
+}
+
+#endif  // CLP_SIMD_X86
+
+/*
+ **************************************************************
+ * Kernels dispatch
+ **************************************************************
+ */
+
+struct FrameKernelsTable
+{
+  Unpack8Fn unpack8[MAX_SPECIALIZED_STEP];
+  Unpack16Fn unpack16[2];  //!< Indexed by CLP_Endianness
+  Pack8Fn pack8[MAX_SPECIALIZED_STEP];
+  Pack16Fn pack16[2];  //!< Indexed by CLP_Endianness
+  YuvToArgbFn yuvToArgb[2];  //!< Indexed by log2ChromaWidth
+  RgbToLumaFn rgbToLuma;
+  ColorTransformFn colorTransform;
+  SsdFn ssd8;  //!< Samples up to 8 bits
+  SsdFn ssd16;
+  AbsDiffFn absDiff;
+  InterleaveFn interleave3;
+  DeinterleaveFn deinterleave3;
+  ArgbToBgrFn argbToBgr;
+  AverageRowsFn averageRows;
+  ResampleRowFn downsampleRow;
+  ResampleRowFn upsampleRow;
+  ShiftFn shiftSamples;
+
+  /* Native 8 bits samples */
+  CopyByteFn unpackByte[MAX_SPECIALIZED_STEP];
+  CopyByteFn packByte[MAX_SPECIALIZED_STEP];
+  NarrowFn narrow;
+  YuvToArgbByteFn yuvToArgbByte[2];
+  RgbToLumaByteFn rgbToLumaByte;
+  ColorTransformByteFn colorTransformByte;
+  SsdByteFn ssdByte;
+  InterleaveByteFn interleave3Byte;
+  DeinterleaveByteFn deinterleave3Byte;
+  AverageRowsByteFn averageRowsByte;
+  ResampleRowByteFn downsampleRowByte;
+  ResampleRowByteFn upsampleRowByte;
+
+  FrameKernelsTable()
+  {
+    unpack8[0] = &unpack8_c<0>;
+    unpack8[1] = &unpack8_c<1>;
+    unpack8[2] = &unpack8_c<2>;
+    unpack8[3] = &unpack8_c<3>;
+    unpack16[CLP_BIG_ENDIAN] = &unpack16_c<true>;
+    unpack16[CLP_LITTLE_ENDIAN] = &unpack16_c<false>;
+    pack8[0] = &pack8_c<0>;
+    pack8[1] = &pack8_c<1>;
+    pack8[2] = &pack8_c<2>;
+    pack8[3] = &pack8_c<3>;
+    pack16[CLP_BIG_ENDIAN] = &pack16_c<true>;
+    pack16[CLP_LITTLE_ENDIAN] = &pack16_c<false>;
+    yuvToArgb[0] = &yuvToArgbRow_c<0>;
+    yuvToArgb[1] = &yuvToArgbRow_c<1>;
+    rgbToLuma = &rgbToLumaRow_c;
+    colorTransform = &colorTransformRow_c;
+    ssd8 = &ssd_c;
+    ssd16 = &ssd_c;
+    absDiff = &absDiff_c;
+    interleave3 = &interleave3_c;
+    deinterleave3 = &deinterleave3_c;
+    argbToBgr = &argbToBgr_c;
+    averageRows = &averageRows_c;
+    downsampleRow = &downsampleRow_c;
+    upsampleRow = &upsampleRow_c;
+    shiftSamples = &shiftSamples_c;
+    unpackByte[0] = &copyBytes_c;
+    unpackByte[1] = &unpack8_c<1, ClpByte>;
+    unpackByte[2] = &unpack8_c<2, ClpByte>;
+    unpackByte[3] = &unpack8_c<3, ClpByte>;
+    packByte[0] = &copyBytes_c;
+    packByte[1] = &pack8_c<1, ClpByte>;
+    packByte[2] = &pack8_c<2, ClpByte>;
+    packByte[3] = &pack8_c<3, ClpByte>;
+    narrow = &narrow_c;
+    yuvToArgbByte[0] = &yuvToArgbRow_c<0, ClpByte>;
+    yuvToArgbByte[1] = &yuvToArgbRow_c<1, ClpByte>;
+    rgbToLumaByte = &rgbToLumaRow_c;
+    colorTransformByte = &colorTransformRow_c;
+    ssdByte = &ssd_c;
+    interleave3Byte = &interleave3_c;
+    deinterleave3Byte = &deinterleave3_c;
+    averageRowsByte = &averageRows_c;
+    downsampleRowByte = &downsampleRow_c;
+    upsampleRowByte = &upsampleRow_c;
+
+#ifdef CLP_SIMD_X86
+    int level = getSimdLevel();
+    if( level >= CLP_SIMD_SSE2 )
+    {
+      unpack8[0] = &unpack8_sse2;
+      unpack8[1] = &unpack8s1_sse2;
+      unpack8[3] = &unpack8s3_sse2;
+      unpack16[CLP_BIG_ENDIAN] = &unpack16_sse2<true>;
+      unpack16[CLP_LITTLE_ENDIAN] = &unpack16_sse2<false>;
+      pack8[0] = &pack8_sse2;
+      pack8[1] = &pack8s1_sse2;
+      pack8[3] = &pack8s3_sse2;
+      pack16[CLP_BIG_ENDIAN] = &pack16_sse2<true>;
+      pack16[CLP_LITTLE_ENDIAN] = &pack16_sse2<false>;
+      ssd8 = &ssd8_sse2;
+      ssd16 = &ssd16_sse2;
+      absDiff = &absDiff_sse2;
+      unpackByte[1] = &unpack8s1Byte_sse2;
+      unpackByte[3] = &unpack8s3Byte_sse2;
+      packByte[1] = &pack8s1Byte_sse2;
+      packByte[3] = &pack8s3Byte_sse2;
+      narrow = &narrow_sse2;
+      ssdByte = &ssdByte_sse2;
+      averageRows = &averageRows_sse2;
+      averageRowsByte = &averageRows_sse2;
+    }
+    if( level >= CLP_SIMD_SSE41 )
+    {
+      yuvToArgb[0] = &yuvToArgbRow_sse41<0>;
+      yuvToArgb[1] = &yuvToArgbRow_sse41<1>;
+      rgbToLuma = &rgbToLumaRow_sse41;
+      yuvToArgbByte[0] = &yuvToArgbRow_sse41<0, ClpByte>;
+      yuvToArgbByte[1] = &yuvToArgbRow_sse41<1, ClpByte>;
+      rgbToLumaByte = &rgbToLumaRow_sse41;
+      colorTransform = &colorTransformRow_sse41;
+      colorTransformByte = &colorTransformRow_sse41;
+      interleave3 = &interleave3_sse41;
+      deinterleave3 = &deinterleave3_sse41;
+      argbToBgr = &argbToBgr_sse41;
+      interleave3Byte = &interleave3_sse41;
+      deinterleave3Byte = &deinterleave3_sse41;
+      downsampleRow = &downsampleRow_sse41;
+      upsampleRow = &upsampleRow_sse41;
+      shiftSamples = &shiftSamples_sse41;
+      downsampleRowByte = &downsampleRow_sse41;
+      upsampleRowByte = &upsampleRow_sse41;
+    }
+    if( level >= CLP_SIMD_AVX2 )
+    {
+      unpack8[0] = &unpack8_avx2;
+      unpack8[1] = &unpack8s1_avx2;
+      unpack8[3] = &unpack8s3_avx2;
+      unpack16[CLP_BIG_ENDIAN] = &unpack16_avx2<true>;
+      unpack16[CLP_LITTLE_ENDIAN] = &unpack16_avx2<false>;
+      pack8[0] = &pack8_avx2;
+      pack8[1] = &pack8s1_avx2;
+      pack8[3] = &pack8s3_avx2;
+      pack16[CLP_BIG_ENDIAN] = &pack16_avx2<true>;
+      pack16[CLP_LITTLE_ENDIAN] = &pack16_avx2<false>;
+      yuvToArgb[0] = &yuvToArgbRow_avx2<0>;
+      yuvToArgb[1] = &yuvToArgbRow_avx2<1>;
+      rgbToLuma = &rgbToLumaRow_avx2;
+      ssd8 = &ssd8_avx2;
+      ssd16 = &ssd16_avx2;
+      absDiff = &absDiff_avx2;
+      narrow = &narrow_avx2;
+      yuvToArgbByte[0] = &yuvToArgbRow_avx2<0, ClpByte>;
+      yuvToArgbByte[1] = &yuvToArgbRow_avx2<1, ClpByte>;
+      rgbToLumaByte = &rgbToLumaRow_avx2;
+      colorTransform = &colorTransformRow_avx2;
+      colorTransformByte = &colorTransformRow_avx2;
+      ssdByte = &ssdByte_avx2;
+    }
+    if( level >= CLP_SIMD_AVX512 )
+    {
+      unpack8[0] = &unpack8_avx512;
+      pack8[0] = &pack8_avx512;
+      narrow = &narrow_avx512;
+      ssdByte = &ssdByte_avx512;
+    }
+#endif
+  }
+};
+
+static const FrameKernelsTable& frameKernels()
+{
+  static const FrameKernelsTable table;
+  return table;
+}
+
+/*
+ * The dispatchers are inlined in the format kernels below, where the step
+ * is a compile time constant and the checks fold away
+ */
+static inline void unpackRun( const ClpByte* in, ClpPel* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                              int endianness, int maxval )
+{
+  const FrameKernelsTable& k = frameKernels();
+  if( bytesPixel == 1 && step < MAX_SPECIALIZED_STEP )
+  {
+    k.unpack8[step]( in, out, count );
+  }
+  else if( bytesPixel == 2 && step == 0 )
+  {
+    k.unpack16[endianness == CLP_BIG_ENDIAN ? CLP_BIG_ENDIAN : CLP_LITTLE_ENDIAN]( in, out, count, maxval );
+  }
+  else
+  {
+    unpackSamplesGeneric( in, out, count, bytesPixel, step, endianness, maxval );
+  }
+}
+
+static inline void unpackRun( const ClpByte* in, ClpByte* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                              int endianness, int maxval )
+{
+  assert( bytesPixel == 1 );
+  if( step < MAX_SPECIALIZED_STEP )
+  {
+    frameKernels().unpackByte[step]( in, out, count );
+    return;
+  }
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    out[i] = *in;
+    in += step + 1;
+  }
+}
+
+static inline void packRun( const ClpPel* in, ClpByte* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                            int endianness )
+{
+  const FrameKernelsTable& k = frameKernels();
+  if( bytesPixel == 1 && step < MAX_SPECIALIZED_STEP )
+  {
+    k.pack8[step]( in, out, count );
+  }
+  else if( bytesPixel == 2 && step == 0 )
+  {
+    k.pack16[endianness == CLP_BIG_ENDIAN ? CLP_BIG_ENDIAN : CLP_LITTLE_ENDIAN]( in, out, count );
+  }
+  else
+  {
+    packSamplesGeneric( in, out, count, bytesPixel, step, endianness );
+  }
+}
+
+static inline void packRun( const ClpByte* in, ClpByte* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                            int endianness )
+{
+  assert( bytesPixel == 1 );
+  if( step < MAX_SPECIALIZED_STEP )
+  {
+    frameKernels().packByte[step]( in, out, count );
+    return;
+  }
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    *out = in[i];
+    out += step + 1;
+  }
+}
+
+void unpackSamples( const ClpByte* in, ClpPel* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                    int endianness, int maxval )
+{
+  unpackRun( in, out, count, bytesPixel, step, endianness, maxval );
+}
+
+void unpackSamples( const ClpByte* in, ClpByte* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                    int endianness, int maxval )
+{
+  unpackRun( in, out, count, bytesPixel, step, endianness, maxval );
+}
+
+void packSamples( const ClpPel* in, ClpByte* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                  int endianness )
+{
+  packRun( in, out, count, bytesPixel, step, endianness );
+}
+
+void packSamples( const ClpByte* in, ClpByte* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                  int endianness )
+{
+  packRun( in, out, count, bytesPixel, step, endianness );
+}
+
+void widenSamples( const ClpByte* in, ClpPel* out, unsigned long count )
+{
+  frameKernels().unpack8[0]( in, out, count );
+}
+
+void narrowSamples( const ClpPel* in, ClpByte* out, unsigned long count )
+{
+  frameKernels().narrow( in, out, count );
+}
+
+template <typename T>
+static void yuvToArgbRowGeneric( const T* pY, const T* pU, const T* pV, unsigned int* pARGB, unsigned int width,
+                                 unsigned int log2ChromaWidth, unsigned int shiftBits )
+{
+  int iY, iU, iV, iR, iG, iB;
+  for( unsigned int x = 0; x < width; x++ )
+  {
+    iY = pY[x] >> shiftBits;
+    iU = pU[x >> log2ChromaWidth] >> shiftBits;
+    iV = pV[x >> log2ChromaWidth] >> shiftBits;
+    YUV2RGB( iY, iU, iV, iR, iG, iB );
+    pARGB[x] = PEL_RGB( iR, iG, iB );
+  }
+}
+
+void yuvToArgbRow( const ClpPel* pY, const ClpPel* pU, const ClpPel* pV, unsigned int* pARGB, unsigned int width,
+                   unsigned int log2ChromaWidth, unsigned int shiftBits )
+{
+  if( log2ChromaWidth > 1 )
+  {
+    yuvToArgbRowGeneric( pY, pU, pV, pARGB, width, log2ChromaWidth, shiftBits );
+    return;
+  }
+  frameKernels().yuvToArgb[log2ChromaWidth]( pY, pU, pV, pARGB, width, shiftBits );
+}
+
+void yuvToArgbRow( const ClpByte* pY, const ClpByte* pU, const ClpByte* pV, unsigned int* pARGB, unsigned int width,
+                   unsigned int log2ChromaWidth, unsigned int shiftBits )
+{
+  if( log2ChromaWidth > 1 )
+  {
+    yuvToArgbRowGeneric( pY, pU, pV, pARGB, width, log2ChromaWidth, shiftBits );
+    return;
+  }
+  frameKernels().yuvToArgbByte[log2ChromaWidth]( pY, pU, pV, pARGB, width, shiftBits );
+}
+
+void rgbToLumaRow( const ClpPel* pR, const ClpPel* pG, const ClpPel* pB, ClpPel* pY, unsigned int width )
+{
+  frameKernels().rgbToLuma( pR, pG, pB, pY, width );
+}
+
+void rgbToLumaRow( const ClpByte* pR, const ClpByte* pG, const ClpByte* pB, ClpByte* pY, unsigned int width )
+{
+  frameKernels().rgbToLumaByte( pR, pG, pB, pY, width );
+}
+
+void colorTransformRow( const float* coeffs, int maxValue, const ClpPel* p0, const ClpPel* p1, const ClpPel* p2, ClpPel* o0,
+                        ClpPel* o1, ClpPel* o2, unsigned int width )
+{
+  frameKernels().colorTransform( coeffs, maxValue, p0, p1, p2, o0, o1, o2, width );
+}
+
+void colorTransformRow( const float* coeffs, int maxValue, const ClpByte* p0, const ClpByte* p1, const ClpByte* p2, ClpByte* o0,
+                        ClpByte* o1, ClpByte* o2, unsigned int width )
+{
+  frameKernels().colorTransformByte( coeffs, maxValue, p0, p1, p2, o0, o1, o2, width );
+}
+
+template <typename T>
+static void accumulateHistogramRow( const T* in, unsigned long count, unsigned int* histogram, unsigned int maxBin )
+{
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    histogram[std::min<unsigned int>( in[i], maxBin )]++;
+  }
+}
+
+void accumulateHistogram( const ClpPel* in, unsigned long count, unsigned int* histogram, unsigned int maxBin )
+{
+  accumulateHistogramRow( in, count, histogram, maxBin );
+}
+
+void accumulateHistogram( const ClpByte* in, unsigned long count, unsigned int* histogram, unsigned int maxBin )
+{
+  if( maxBin >= 255 )
+  {
+    // Every byte has its own bin
+    for( unsigned long i = 0; i < count; i++ )
+      histogram[in[i]]++;
+    return;
+  }
+  accumulateHistogramRow( in, count, histogram, maxBin );
+}
+
+unsigned long long sumSquaredDiff( const ClpPel* pA, const ClpPel* pB, unsigned long count, unsigned int bitsPel )
+{
+  const FrameKernelsTable& k = frameKernels();
+  return bitsPel <= 8 ? k.ssd8( pA, pB, count ) : k.ssd16( pA, pB, count );
+}
+
+unsigned long long sumSquaredDiff( const ClpByte* pA, const ClpByte* pB, unsigned long count, unsigned int bitsPel )
+{
+  return frameKernels().ssdByte( pA, pB, count );
+}
+
+unsigned long long weightedSumSquaredDiff( const ClpPel* pA, const ClpPel* pB, const ClpPel* pWeights, unsigned long count,
+                                           unsigned long long& weightSum )
+{
+  unsigned long long ssd = 0;
+  unsigned long long sum = 0;
+  for( unsigned long i = 0; i < count; i++ )
+  {
+    unsigned long long diff = pA[i] > pB[i] ? pA[i] - pB[i] : pB[i] - pA[i];
+    ssd += pWeights[i] * diff * diff;
+    sum += pWeights[i];
+  }
+  weightSum = sum;
+  return ssd;
+}
+
+void absoluteDiff( const ClpPel* pA, const ClpPel* pB, ClpPel* pOut, unsigned long count )
+{
+  frameKernels().absDiff( pA, pB, pOut, count );
+}
+
+void interleaveSamples( const ClpPel* p0, const ClpPel* p1, const ClpPel* p2, ClpPel* out, unsigned long count )
+{
+  frameKernels().interleave3( p0, p1, p2, out, count );
+}
+
+void interleaveSamples( const ClpByte* p0, const ClpByte* p1, const ClpByte* p2, ClpByte* out, unsigned long count )
+{
+  frameKernels().interleave3Byte( p0, p1, p2, out, count );
+}
+
+void deinterleaveSamples( const ClpPel* in, ClpPel* p0, ClpPel* p1, ClpPel* p2, unsigned long count )
+{
+  frameKernels().deinterleave3( in, p0, p1, p2, count );
+}
+
+void deinterleaveSamples( const ClpByte* in, ClpByte* p0, ClpByte* p1, ClpByte* p2, unsigned long count )
+{
+  frameKernels().deinterleave3Byte( in, p0, p1, p2, count );
+}
+
+void argbToBgrRow( const unsigned int* pARGB, ClpByte* out, unsigned long count )
+{
+  frameKernels().argbToBgr( pARGB, out, count );
+}
+
+void averageRows( const ClpPel* pA, const ClpPel* pB, ClpPel* pOut, unsigned long count )
+{
+  frameKernels().averageRows( pA, pB, pOut, count );
+}
+
+void averageRows( const ClpByte* pA, const ClpByte* pB, ClpByte* pOut, unsigned long count )
+{
+  frameKernels().averageRowsByte( pA, pB, pOut, count );
+}
+
+void downsampleRow( const ClpPel* in, ClpPel* out, unsigned int outWidth, unsigned int inWidth )
+{
+  frameKernels().downsampleRow( in, out, outWidth, inWidth );
+}
+
+void downsampleRow( const ClpByte* in, ClpByte* out, unsigned int outWidth, unsigned int inWidth )
+{
+  frameKernels().downsampleRowByte( in, out, outWidth, inWidth );
+}
+
+void upsampleRow( const ClpPel* in, ClpPel* out, unsigned int outWidth, unsigned int inWidth )
+{
+  frameKernels().upsampleRow( in, out, outWidth, inWidth );
+}
+
+void upsampleRow( const ClpByte* in, ClpByte* out, unsigned int outWidth, unsigned int inWidth )
+{
+  frameKernels().upsampleRowByte( in, out, outWidth, inWidth );
+}
+
+void shiftSamples( const ClpPel* in, ClpPel* out, unsigned long count, int shift, ClpPel maxval )
+{
+  frameKernels().shiftSamples( in, out, count, shift, maxval );
+}
+
+/*
+ **************************************************************
+ * Pixel format kernels
+ **************************************************************
+ */
+
+/**
+ * First byte of each plane of a file buffer
+ */
+template <int FMT, typename B>
+static void filePlanes( B* in, unsigned int width, unsigned int height, unsigned int bytesPixel, B* apcPlane[MAX_NUMBER_PLANES] )
+{
+  constexpr const CalypPixelFormatDescriptor& fmt = g_CalypPixFmtDescriptors[FMT];
+  apcPlane[0] = in;
+  for( int i = 1; i < MAX_NUMBER_PLANES; i++ )
+  {
+    unsigned int ratioW = i > 1 ? fmt.log2ChromaWidth : 0;
+    unsigned int ratioH = i > 1 ? fmt.log2ChromaHeight : 0;
+    apcPlane[i] = apcPlane[i - 1] + CHROMASHIFT( height, ratioH ) * CHROMASHIFT( width, ratioW ) * bytesPixel;
+  }
+}
+
+template <int FMT, unsigned int CH, typename T>
+static inline void unpackChannel( const ClpByte* const* apcPlane, T** out, unsigned int width, unsigned int height,
+                                  unsigned int stride, unsigned int bytesPixel, int endianness, int maxval )
+{
+  constexpr const CalypPixelFormatDescriptor& fmt = g_CalypPixFmtDescriptors[FMT];
+  // The descriptor counts samples (bytes of 8 bits formats)
+  unsigned int step = fmt.comp[CH].step_minus1 * bytesPixel;
+  const ClpByte* pIn = apcPlane[fmt.comp[CH].plane] + ( fmt.comp[CH].offset_plus1 - 1 ) * bytesPixel;
+  unsigned int uiPlaneWidth = CHROMASHIFT( width, CH > 0 ? fmt.log2ChromaWidth : 0 );
+  unsigned int uiPlaneHeight = CHROMASHIFT( height, CH > 0 ? fmt.log2ChromaHeight : 0 );
+  if( stride == uiPlaneWidth )
+  {
+    unpackRun( pIn, out[0], (unsigned long)uiPlaneHeight * uiPlaneWidth, bytesPixel, step, endianness, maxval );
+    return;
+  }
+  unsigned long rowBytes = (unsigned long)uiPlaneWidth * ( bytesPixel + step );
+  for( unsigned int y = 0; y < uiPlaneHeight; y++ )
+    unpackRun( pIn + y * rowBytes, out[y], uiPlaneWidth, bytesPixel, step, endianness, maxval );
+}
+
+template <int FMT, unsigned int CH, typename T>
+static inline void packChannel( T** in, ClpByte* const* apcPlane, unsigned int width, unsigned int height, unsigned int stride,
+                                unsigned int bytesPixel, int endianness )
+{
+  constexpr const CalypPixelFormatDescriptor& fmt = g_CalypPixFmtDescriptors[FMT];
+  // The descriptor counts samples (bytes of 8 bits formats)
+  unsigned int step = fmt.comp[CH].step_minus1 * bytesPixel;
+  ClpByte* pOut = apcPlane[fmt.comp[CH].plane] + ( fmt.comp[CH].offset_plus1 - 1 ) * bytesPixel;
+  unsigned int uiPlaneWidth = CHROMASHIFT( width, CH > 0 ? fmt.log2ChromaWidth : 0 );
+  unsigned int uiPlaneHeight = CHROMASHIFT( height, CH > 0 ? fmt.log2ChromaHeight : 0 );
+  if( stride == uiPlaneWidth )
+  {
+    packRun( in[0], pOut, (unsigned long)uiPlaneHeight * uiPlaneWidth, bytesPixel, step, endianness );
+    return;
+  }
+  unsigned long rowBytes = (unsigned long)uiPlaneWidth * ( bytesPixel + step );
+  for( unsigned int y = 0; y < uiPlaneHeight; y++ )
+    packRun( in[y], pOut + y * rowBytes, uiPlaneWidth, bytesPixel, step, endianness );
+}
+
+// The channel loops are unrolled by expanding the channel index pack
+template <int FMT, typename T, unsigned int... CH>
+static void unpackFrame_t( const ClpByte* in, T*** out, unsigned int width, unsigned int height, const unsigned int* stride,
+                           unsigned int bytesPixel, int endianness, int maxval )
+{
+  const ClpByte* apcPlane[MAX_NUMBER_PLANES];
+  filePlanes<FMT>( in, width, height, bytesPixel, apcPlane );
+  (void)std::initializer_list<int>{
+      ( unpackChannel<FMT, CH>( apcPlane, out[CH], width, height, stride[CH], bytesPixel, endianness, maxval ), 0 )... };
+}
+
+template <int FMT, typename T, unsigned int... CH>
+static void packFrame_t( T*** in, ClpByte* out, unsigned int width, unsigned int height, const unsigned int* stride,
+                         unsigned int bytesPixel, int endianness )
+{
+  ClpByte* apcPlane[MAX_NUMBER_PLANES];
+  filePlanes<FMT>( out, width, height, bytesPixel, apcPlane );
+  (void)std::initializer_list<int>{ ( packChannel<FMT, CH>( in[CH], apcPlane, width, height, stride[CH], bytesPixel, endianness ), 0 )... };
+}
+
+template <int FMT, typename T>
+static void argbRows_t( T*** in, unsigned int* pARGB, unsigned int width, unsigned int startRow, unsigned int endRow,
+                        unsigned int shiftBits )
+{
+  constexpr const CalypPixelFormatDescriptor& fmt = g_CalypPixFmtDescriptors[FMT];
+  for( unsigned int y = startRow; y < endRow; y++ )
+  {
+    unsigned int* pARGBLine = pARGB + (unsigned long)y * width;
+    if( fmt.colorSpace == CLP_COLOR_GRAY )
+    {
+      const T* pY = in[CLP_LUMA][y];
+      for( unsigned int x = 0; x < width; x++ )
+        pARGBLine[x] = PEL_RGB( pY[x], pY[x], pY[x] );
+    }
+    else if( fmt.colorSpace == CLP_COLOR_RGB )
+    {
+      const T* pR = in[CLP_COLOR_R][y];
+      const T* pG = in[CLP_COLOR_G][y];
+      const T* pB = in[CLP_COLOR_B][y];
+      for( unsigned int x = 0; x < width; x++ )
+        pARGBLine[x] = PEL_RGB( pR[x] >> shiftBits, pG[x] >> shiftBits, pB[x] >> shiftBits );
+    }
+    else if( fmt.colorSpace == CLP_COLOR_RGBA )
+    {
+      const T* pR = in[CLP_COLOR_R][y];
+      const T* pG = in[CLP_COLOR_G][y];
+      const T* pB = in[CLP_COLOR_B][y];
+      const T* pA = in[CLP_COLOR_A][y];
+      for( unsigned int x = 0; x < width; x++ )
+        pARGBLine[x] = PEL_ARGB( pA[x] >> shiftBits, pR[x] >> shiftBits, pG[x] >> shiftBits, pB[x] >> shiftBits );
+    }
+    else if( fmt.colorSpace == CLP_COLOR_YUV )
+    {
+      unsigned int yChroma = y >> fmt.log2ChromaHeight;
+      yuvToArgbRow( in[CLP_LUMA][y], in[CLP_CHROMA_U][yChroma], in[CLP_CHROMA_V][yChroma], pARGBLine, width,
+                    fmt.log2ChromaWidth, shiftBits );
+    }
+  }
+}
+
+template <int FMT, typename T, unsigned int... CH>
+static constexpr CalypFormatKernels<T> formatKernels( std::integer_sequence<unsigned int, CH...> )
+{
+  return { &unpackFrame_t<FMT, T, CH...>, &packFrame_t<FMT, T, CH...>, &argbRows_t<FMT, T> };
+}
+
+template <typename T, int... FMT>
+static constexpr std::array<CalypFormatKernels<T>, sizeof...( FMT )> formatKernelsTable( std::integer_sequence<int, FMT...> )
+{
+  return { { formatKernels<FMT, T>( std::make_integer_sequence<unsigned int, g_CalypPixFmtDescriptors[FMT].numberChannels>() )... } };
+}
+
+template <typename T>
+const CalypFormatKernels<T>& getFormatKernels( int pelFormat )
+{
+  static constexpr std::array<CalypFormatKernels<T>, CLP_NUMBER_FORMATS> s_aKernels =
+      formatKernelsTable<T>( std::make_integer_sequence<int, CLP_NUMBER_FORMATS>() );
+  return s_aKernels.at( pelFormat );
+}
+
+template const CalypFormatKernels<ClpPel>& getFormatKernels<ClpPel>( int pelFormat );
+template const CalypFormatKernels<ClpByte>& getFormatKernels<ClpByte>( int pelFormat );
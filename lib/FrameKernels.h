@@ -0,0 +1,239 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FrameKernels.h
+ * \ingroup  CalypFrameGrp
+ * \brief    Optimized kernels for frame samples handling
+ */
+
+#ifndef __FRAMEKERNELS_H__
+#define __FRAMEKERNELS_H__
+
+#include "CalypDefs.h"
+
+/**
+ * Unpack samples stored in a byte buffer into a pel buffer
+ * @param in first byte of the first sample
+ * @param out output pel buffer
+ * @param count number of samples to unpack
+ * @param bytesPixel number of bytes of each sample (1 or 2)
+ * @param step number of bytes between two consecutive samples minus the sample size
+ * @param endianness endianness of the samples (use CLP_Endianness)
+ * @param maxval maximum value of a sample
+ *
+ * @note out of range samples are handled exactly as the original per-byte loop:
+ *       little endian samples are set to zero and big endian samples keep the
+ *       least significant byte
+ */
+void unpackSamples( const ClpByte* in, ClpPel* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                    int endianness, int maxval );
+
+/**
+ * Unpack 8 bits samples into a buffer of native 8 bits samples
+ * (same parameters, bytesPixel must be 1)
+ */
+void unpackSamples( const ClpByte* in, ClpByte* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                    int endianness, int maxval );
+
+/**
+ * Pack samples from a pel buffer into a byte buffer
+ * @param in input pel buffer
+ * @param out first byte of the first sample
+ * @param count number of samples to pack
+ * @param bytesPixel number of bytes of each sample (1 or 2)
+ * @param step number of bytes between two consecutive samples minus the sample size
+ * @param endianness endianness of the samples (use CLP_Endianness)
+ *
+ * @note bytes between samples (step > 0) are left untouched
+ */
+void packSamples( const ClpPel* in, ClpByte* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                  int endianness );
+void packSamples( const ClpByte* in, ClpByte* out, unsigned long count, unsigned int bytesPixel, unsigned int step,
+                  int endianness );
+
+/**
+ * Convert native 8 bits samples into pel samples
+ */
+void widenSamples( const ClpByte* in, ClpPel* out, unsigned long count );
+
+/**
+ * Convert pel samples into native 8 bits samples (saturated at 255)
+ */
+void narrowSamples( const ClpPel* in, ClpByte* out, unsigned long count );
+
+/**
+ * Convert one row of YUV samples into ARGB32 pixels using the
+ * integer YUV to RGB matrix of CalypFrame::fillRGBBuffer
+ * @param pY luma row
+ * @param pU chroma U row
+ * @param pV chroma V row
+ * @param pARGB output row
+ * @param width number of pixels in the row
+ * @param log2ChromaWidth horizontal chroma subsampling
+ * @param shiftBits number of bits to drop to get 8 bits samples
+ */
+void yuvToArgbRow( const ClpPel* pY, const ClpPel* pU, const ClpPel* pV, unsigned int* pARGB, unsigned int width,
+                   unsigned int log2ChromaWidth, unsigned int shiftBits );
+void yuvToArgbRow( const ClpByte* pY, const ClpByte* pU, const ClpByte* pV, unsigned int* pARGB, unsigned int width,
+                   unsigned int log2ChromaWidth, unsigned int shiftBits );
+
+/**
+ * Compute the luma of one row of RGB samples with the integer
+ * weights used by CalypPixel::convertPixel (CLP_MATRIX_DEFAULT)
+ * @param pR red row
+ * @param pG green row
+ * @param pB blue row
+ * @param pY output luma row
+ * @param width number of pixels in the row
+ */
+void rgbToLumaRow( const ClpPel* pR, const ClpPel* pG, const ClpPel* pB, ClpPel* pY, unsigned int width );
+void rgbToLumaRow( const ClpByte* pR, const ClpByte* pG, const ClpByte* pB, ClpByte* pY, unsigned int width );
+
+/**
+ * Affine transform of one row of three planes, e.g. YUV <-> RGB at the same
+ * bit depth: out[c] = m[c][0] * in[0] + m[c][1] * in[1] + m[c][2] * in[2] + m[c][3]
+ * in single precision, clipped to [0, maxValue] and rounded
+ * @param coeffs 3 rows of 4 coefficients (see getYuvToRgbTransform in ColorMatrix.h)
+ * @param maxValue largest output sample
+ * @param width number of pixels in the row
+ */
+void colorTransformRow( const float* coeffs, int maxValue, const ClpPel* p0, const ClpPel* p1, const ClpPel* p2, ClpPel* o0,
+                        ClpPel* o1, ClpPel* o2, unsigned int width );
+void colorTransformRow( const float* coeffs, int maxValue, const ClpByte* p0, const ClpByte* p1, const ClpByte* p2, ClpByte* o0,
+                        ClpByte* o1, ClpByte* o2, unsigned int width );
+
+/**
+ * Add samples to a histogram
+ * @param in input samples
+ * @param count number of samples
+ * @param histogram histogram bins
+ * @param maxBin last bin of the histogram (larger samples are counted in it)
+ */
+void accumulateHistogram( const ClpPel* in, unsigned long count, unsigned int* histogram, unsigned int maxBin );
+void accumulateHistogram( const ClpByte* in, unsigned long count, unsigned int* histogram, unsigned int maxBin );
+
+/**
+ * Sum of squared differences between two buffers of samples
+ * @param pA first buffer
+ * @param pB second buffer
+ * @param count number of samples
+ * @param bitsPel bits per sample (samples up to 8 bits use a faster kernel)
+ */
+unsigned long long sumSquaredDiff( const ClpPel* pA, const ClpPel* pB, unsigned long count, unsigned int bitsPel );
+unsigned long long sumSquaredDiff( const ClpByte* pA, const ClpByte* pB, unsigned long count, unsigned int bitsPel );
+
+/**
+ * Sum of squared differences where each sample is multiplied by a weight
+ * @param weightSum returns the sum of the weights
+ */
+unsigned long long weightedSumSquaredDiff( const ClpPel* pA, const ClpPel* pB, const ClpPel* pWeights, unsigned long count,
+                                           unsigned long long& weightSum );
+
+/**
+ * Absolute difference between two buffers of samples
+ */
+void absoluteDiff( const ClpPel* pA, const ClpPel* pB, ClpPel* pOut, unsigned long count );
+
+/**
+ * Interleave three planes into one row of 3 samples pixels
+ * (p0, p1, p2 order, e.g. the BGR rows of OpenCV)
+ * @param count number of pixels
+ */
+void interleaveSamples( const ClpPel* p0, const ClpPel* p1, const ClpPel* p2, ClpPel* out, unsigned long count );
+void interleaveSamples( const ClpByte* p0, const ClpByte* p1, const ClpByte* p2, ClpByte* out, unsigned long count );
+
+/**
+ * Split one row of 3 samples pixels into three planes (inverse of interleaveSamples)
+ */
+void deinterleaveSamples( const ClpPel* in, ClpPel* p0, ClpPel* p1, ClpPel* p2, unsigned long count );
+void deinterleaveSamples( const ClpByte* in, ClpByte* p0, ClpByte* p1, ClpByte* p2, unsigned long count );
+
+/**
+ * Convert ARGB32 pixels into BGR24 pixels (alpha is dropped)
+ */
+void argbToBgrRow( const unsigned int* pARGB, ClpByte* out, unsigned long count );
+
+/**
+ * Rounded average of two rows, (a + b + 1) >> 1
+ */
+void averageRows( const ClpPel* pA, const ClpPel* pB, ClpPel* pOut, unsigned long count );
+void averageRows( const ClpByte* pA, const ClpByte* pB, ClpByte* pOut, unsigned long count );
+
+/**
+ * Halve a row with the co-sited [1 2 1] filter, computed as
+ * avg( in[2x], avg( in[2x-1], in[2x+1] ) ) with the rounding of averageRows
+ * @param outWidth output samples (inWidth / 2 rounded up)
+ * @param inWidth input samples (edges are replicated)
+ */
+void downsampleRow( const ClpPel* in, ClpPel* out, unsigned int outWidth, unsigned int inWidth );
+void downsampleRow( const ClpByte* in, ClpByte* out, unsigned int outWidth, unsigned int inWidth );
+
+/**
+ * Double a row by linear interpolation: out[2x] = in[x] and
+ * out[2x+1] = avg( in[x], in[x+1] ) (parameters as in downsampleRow)
+ */
+void upsampleRow( const ClpPel* in, ClpPel* out, unsigned int outWidth, unsigned int inWidth );
+void upsampleRow( const ClpByte* in, ClpByte* out, unsigned int outWidth, unsigned int inWidth );
+
+/**
+ * Change the bit depth of samples
+ * @param shift bits to add (positive) or to remove with rounding (negative)
+ * @param maxval maximum output value (bounds the rounding of negative shifts)
+ */
+void shiftSamples( const ClpPel* in, ClpPel* out, unsigned long count, int shift, ClpPel maxval );
+
+/**
+ * Frame kernels instantiated for each pixel format from the constexpr
+ * descriptor table, so planes, steps and subsampling are compile time
+ * constants. Frames look up the table of their format once
+ * @tparam T sample type of the planes (ClpPel or ClpByte)
+ */
+template <typename T>
+struct CalypFormatKernels
+{
+  /**
+   * Unpack a frame stored in a file buffer
+   * @param stride row stride of each channel in samples
+   * (other parameters as in unpackSamples)
+   */
+  void ( *unpackFrame )( const ClpByte* in, T*** out, unsigned int width, unsigned int height, const unsigned int* stride,
+                         unsigned int bytesPixel, int endianness, int maxval );
+
+  /**
+   * Pack a frame into a file buffer (parameters as in unpackFrame)
+   */
+  void ( *packFrame )( T*** in, ClpByte* out, unsigned int width, unsigned int height, const unsigned int* stride,
+                       unsigned int bytesPixel, int endianness );
+
+  /**
+   * Convert the rows [startRow, endRow) into ARGB32 pixels with the
+   * integer matrix of yuvToArgbRow (pARGB points to the first row of the frame)
+   */
+  void ( *argbRows )( T*** in, unsigned int* pARGB, unsigned int width, unsigned int startRow, unsigned int endRow,
+                      unsigned int shiftBits );
+};
+
+/**
+ * Get the kernels of a pixel format (follows CalypPixelFormats enum)
+ */
+template <typename T>
+const CalypFormatKernels<T>& getFormatKernels( int pelFormat );
+
+#endif  // __FRAMEKERNELS_H__
@@ -0,0 +1,164 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FramePool.cpp
+ * \brief    Pool of frame buffers recycled between CalypFrame instances
+ */
+
+#include "FramePool.h"
+
+#include "LibMemory.h"
+
+#include <algorithm>
+#include <tuple>
+
+#define FRAME_POOL_DEFAULT_CACHE ( std::size_t( 512 ) << 20 )
+
+bool CalypFramePool::Key::operator<( const Key& other ) const
+{
+  return std::tie( iKind, uiWidth, uiHeight, iPelFormat, uiVariant, uiBytes ) <
+         std::tie( other.iKind, other.uiWidth, other.uiHeight, other.iPelFormat, other.uiVariant, other.uiBytes );
+}
+
+CalypFramePool* CalypFramePool::global()
+{
+  // Never destroyed: frames held by other static objects may be
+  // released after the end of main
+  static CalypFramePool* pool = new CalypFramePool;
+  return pool;
+}
+
+CalypFramePool::CalypFramePool()
+    : m_uiMaxCachedBytes( FRAME_POOL_DEFAULT_CACHE )
+{
+  memset( &m_sStats, 0, sizeof( m_sStats ) );
+}
+
+CalypFramePool::~CalypFramePool()
+{
+  clear();
+}
+
+void* CalypFramePool::acquire( int kind, unsigned int width, unsigned int height, int pelFormat, unsigned int variant,
+                               std::size_t bytes )
+{
+  Key key = { kind, width, height, pelFormat, variant, bytes };
+  void* buffer = NULL;
+  {
+    std::lock_guard<std::mutex> lock( m_cMutex );
+    std::map<Key, std::vector<void*>>::iterator it = m_cFreeBuffers.find( key );
+    if( it != m_cFreeBuffers.end() && !it->second.empty() )
+    {
+      buffer = it->second.back();
+      it->second.pop_back();
+      m_sStats.uiBytesCached -= bytes;
+      m_sStats.ullReuses++;
+    }
+    else
+    {
+      m_sStats.ullAllocations++;
+    }
+    m_sStats.uiBytesInUse += bytes;
+    m_sStats.uiPeakBytesInUse = std::max( m_sStats.uiPeakBytesInUse, m_sStats.uiBytesInUse );
+  }
+  if( !buffer )
+  {
+    buffer = xMallocMem( bytes );
+    if( !buffer )
+    {
+      std::lock_guard<std::mutex> lock( m_cMutex );
+      m_sStats.uiBytesInUse -= bytes;
+    }
+  }
+  return buffer;
+}
+
+void CalypFramePool::release( void* buffer, int kind, unsigned int width, unsigned int height, int pelFormat,
+                              unsigned int variant, std::size_t bytes )
+{
+  if( !buffer )
+    return;
+
+  Key key = { kind, width, height, pelFormat, variant, bytes };
+  {
+    std::lock_guard<std::mutex> lock( m_cMutex );
+    m_sStats.ullReleases++;
+    m_sStats.uiBytesInUse -= bytes;
+    if( m_sStats.uiBytesCached + bytes <= m_uiMaxCachedBytes )
+    {
+      m_cFreeBuffers[key].push_back( buffer );
+      m_sStats.uiBytesCached += bytes;
+      return;
+    }
+  }
+  xFreeMem( buffer );
+}
+
+void CalypFramePool::setMaxCachedBytes( std::size_t bytes )
+{
+  std::lock_guard<std::mutex> lock( m_cMutex );
+  m_uiMaxCachedBytes = bytes;
+  trim( bytes );
+}
+
+std::size_t CalypFramePool::getMaxCachedBytes()
+{
+  std::lock_guard<std::mutex> lock( m_cMutex );
+  return m_uiMaxCachedBytes;
+}
+
+void CalypFramePool::clear()
+{
+  std::lock_guard<std::mutex> lock( m_cMutex );
+  trim( 0 );
+}
+
+void CalypFramePool::trim( std::size_t maxBytes )
+{
+  std::map<Key, std::vector<void*>>::iterator it = m_cFreeBuffers.begin();
+  while( it != m_cFreeBuffers.end() && m_sStats.uiBytesCached > maxBytes )
+  {
+    while( !it->second.empty() && m_sStats.uiBytesCached > maxBytes )
+    {
+      xFreeMem( it->second.back() );
+      it->second.pop_back();
+      m_sStats.uiBytesCached -= it->first.uiBytes;
+    }
+    if( it->second.empty() )
+      it = m_cFreeBuffers.erase( it );
+    else
+      ++it;
+  }
+}
+
+CalypFramePoolStats CalypFramePool::getStats()
+{
+  std::lock_guard<std::mutex> lock( m_cMutex );
+  return m_sStats;
+}
+
+void CalypFramePool::resetStats()
+{
+  std::lock_guard<std::mutex> lock( m_cMutex );
+  m_sStats.ullAllocations = 0;
+  m_sStats.ullReuses = 0;
+  m_sStats.ullReleases = 0;
+  m_sStats.uiPeakBytesInUse = m_sStats.uiBytesInUse;
+}
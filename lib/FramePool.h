@@ -0,0 +1,124 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FramePool.h
+ * \ingroup  CalypLibGrp
+ * \brief    Pool of frame buffers recycled between CalypFrame instances
+ */
+
+#ifndef __FRAMEPOOL_H__
+#define __FRAMEPOOL_H__
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * Usage counters of a frame pool
+ */
+struct CalypFramePoolStats
+{
+  unsigned long long ullAllocations;  //!< Buffers allocated from the system
+  unsigned long long ullReuses;       //!< Requests served with a recycled buffer
+  unsigned long long ullReleases;     //!< Buffers given back to the pool
+  std::size_t uiBytesInUse;           //!< Bytes held by live frames
+  std::size_t uiPeakBytesInUse;       //!< Maximum of uiBytesInUse
+  std::size_t uiBytesCached;          //!< Bytes kept idle for reuse
+};
+
+/**
+ * \class    CalypFramePool
+ * \ingroup  CalypLibGrp
+ * \brief    Recycles the buffers of CalypFrame
+ *
+ * Buffers are keyed by their kind and frame format (resolution, pixel
+ * format and planes layout), so a released buffer is handed to the next
+ * frame of the same format without going through malloc. Idle buffers
+ * are kept up to a byte limit and freed beyond it.
+ */
+class CalypFramePool
+{
+public:
+  enum BufferKind
+  {
+    PLANES_BUFFER = 0,  //!< Planes and row pointers
+    ARGB_BUFFER,        //!< 4 bytes per pixel display buffer
+    HISTOGRAM_BUFFER,   //!< Histogram bins
+  };
+
+  /**
+   * Get the pool shared by the library
+   */
+  static CalypFramePool* global();
+
+  CalypFramePool();
+  ~CalypFramePool();
+
+  /**
+   * Get a buffer of a given kind and format
+   * Recycled buffers keep their previous content
+   * @param variant any other property that changes the buffer content layout
+   * @return buffer or NULL if the allocation failed
+   */
+  void* acquire( int kind, unsigned int width, unsigned int height, int pelFormat, unsigned int variant, std::size_t bytes );
+
+  /**
+   * Give a buffer obtained with acquire back to the pool
+   * (same kind, format and size)
+   */
+  void release( void* buffer, int kind, unsigned int width, unsigned int height, int pelFormat, unsigned int variant,
+                std::size_t bytes );
+
+  /**
+   * Maximum number of bytes kept idle (0 disables recycling)
+   */
+  void setMaxCachedBytes( std::size_t bytes );
+  std::size_t getMaxCachedBytes();
+
+  /**
+   * Free every idle buffer
+   */
+  void clear();
+
+  CalypFramePoolStats getStats();
+  void resetStats();
+
+private:
+  struct Key
+  {
+    int iKind;
+    unsigned int uiWidth;
+    unsigned int uiHeight;
+    int iPelFormat;
+    unsigned int uiVariant;
+    std::size_t uiBytes;
+    bool operator<( const Key& other ) const;
+  };
+
+  void trim( std::size_t maxBytes );
+
+  std::mutex m_cMutex;
+  std::map<Key, std::vector<void*>> m_cFreeBuffers;
+  std::size_t m_uiMaxCachedBytes;
+  CalypFramePoolStats m_sStats;
+};
+
+#endif  // __FRAMEPOOL_H__
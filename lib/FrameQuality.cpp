@@ -0,0 +1,318 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FrameQuality.cpp
+ * \brief    Quality metrics engines (SSIM)
+ */
+
+#include "FrameQuality.h"
+
+#include "FrameKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#define SSIM_GAUSSIAN_SIZE 11
+#define SSIM_GAUSSIAN_SIGMA 1.5
+
+/**
+ * Running sums of the samples, squares and cross product of each
+ * column over the rows of the current window
+ */
+struct SsimColumnSums
+{
+  std::vector<unsigned long long> aullRef, aullEnc, aullRefSq, aullEncSq, aullCross;
+
+  SsimColumnSums( int width )
+      : aullRef( width, 0 ), aullEnc( width, 0 ), aullRefSq( width, 0 ), aullEncSq( width, 0 ), aullCross( width, 0 )
+  {
+  }
+
+  void reset()
+  {
+    std::fill( aullRef.begin(), aullRef.end(), 0 );
+    std::fill( aullEnc.begin(), aullEnc.end(), 0 );
+    std::fill( aullRefSq.begin(), aullRefSq.end(), 0 );
+    std::fill( aullEncSq.begin(), aullEncSq.end(), 0 );
+    std::fill( aullCross.begin(), aullCross.end(), 0 );
+  }
+
+  template <bool ADD, typename T>
+  void update( const T* pRef, const T* pEnc, int width )
+  {
+    for( int x = 0; x < width; x++ )
+    {
+      unsigned long long r = pRef[x];
+      unsigned long long e = pEnc[x];
+      if( ADD )
+      {
+        aullRef[x] += r;
+        aullEnc[x] += e;
+        aullRefSq[x] += r * r;
+        aullEncSq[x] += e * e;
+        aullCross[x] += r * e;
+      }
+      else
+      {
+        aullRef[x] -= r;
+        aullEnc[x] -= e;
+        aullRefSq[x] -= r * r;
+        aullEncSq[x] -= e * e;
+        aullCross[x] -= r * e;
+      }
+    }
+  }
+};
+
+/**
+ * Block SSIM engine. When pSSD is given (only valid for non-overlapping
+ * windows) the rows entering each window also feed the SSD kernel
+ * (engines are templated on the sample type of the planes)
+ */
+template <typename T>
+static float ssimBlocks( T** refImg, T** encImg, int width, int height, int winWidth, int winHeight, int maxValue,
+                         int step, unsigned int bitsPel, std::atomic<unsigned long long>* pSSD )
+{
+  static const float K1 = 0.01f, K2 = 0.03f;
+  float max_pix_value_sqd = (float)maxValue * (float)maxValue;
+  float C1 = K1 * K1 * max_pix_value_sqd;
+  float C2 = K2 * K2 * max_pix_value_sqd;
+  float win_pixels = (float)( winWidth * winHeight );
+#ifdef UNBIASED_VARIANCE
+  float win_pixels_bias = win_pixels - 1;
+#else
+  float win_pixels_bias = win_pixels;
+#endif
+
+  int numWinX = width >= winWidth ? ( width - winWidth ) / step + 1 : 0;
+  int numWinY = height >= winHeight ? ( height - winHeight ) / step + 1 : 0;
+  std::vector<float> afSsimMap( numWinX * numWinY );
+
+  CalypThreadPool::global()->parallelFor( numWinY, std::max( 1, 64 / step ), [&]( unsigned int startRow, unsigned int endRow ) {
+    SsimColumnSums cSums( width );
+    unsigned long long ullBandSSD = 0;
+    int currTop = -1;
+    for( int wy = startRow; wy < (int)endRow; wy++ )
+    {
+      int top = wy * step;
+      if( currTop < 0 || top - currTop >= winHeight )
+      {
+        cSums.reset();
+        for( int n = top; n < top + winHeight; n++ )
+        {
+          cSums.update<true>( refImg[n], encImg[n], width );
+          if( pSSD )
+            ullBandSSD += sumSquaredDiff( refImg[n], encImg[n], width, bitsPel );
+        }
+      }
+      else
+      {
+        for( int n = currTop; n < top; n++ )
+          cSums.update<false>( refImg[n], encImg[n], width );
+        for( int n = currTop + winHeight; n < top + winHeight; n++ )
+          cSums.update<true>( refImg[n], encImg[n], width );
+      }
+      currTop = top;
+
+      for( int wx = 0; wx < numWinX; wx++ )
+      {
+        unsigned long long imeanOrg = 0, imeanEnc = 0, ivarOrg = 0, ivarEnc = 0, icovOrgEnc = 0;
+        for( int m = wx * step; m < wx * step + winWidth; m++ )
+        {
+          imeanOrg += cSums.aullRef[m];
+          imeanEnc += cSums.aullEnc[m];
+          ivarOrg += cSums.aullRefSq[m];
+          ivarEnc += cSums.aullEncSq[m];
+          icovOrgEnc += cSums.aullCross[m];
+        }
+
+        float meanOrg = (float)imeanOrg / win_pixels;
+        float meanEnc = (float)imeanEnc / win_pixels;
+
+        float varOrg = ( (float)ivarOrg - ( (float)imeanOrg ) * meanOrg ) / win_pixels_bias;
+        float varEnc = ( (float)ivarEnc - ( (float)imeanEnc ) * meanEnc ) / win_pixels_bias;
+        float covOrgEnc = ( (float)icovOrgEnc - ( (float)imeanOrg ) * meanEnc ) / win_pixels_bias;
+
+        float mb_ssim = (float)( ( 2.0 * meanOrg * meanEnc + C1 ) * ( 2.0 * covOrgEnc + C2 ) );
+        mb_ssim /= (float)( meanOrg * meanOrg + meanEnc * meanEnc + C1 ) * ( varOrg + varEnc + C2 );
+
+        afSsimMap[wy * numWinX + wx] = mb_ssim;
+      }
+    }
+    if( pSSD )
+      *pSSD += ullBandSSD;
+  } );
+
+  // Average in raster order to keep the result independent of the bands
+  float cur_distortion = 0.0;
+  for( unsigned int i = 0; i < afSsimMap.size(); i++ )
+    cur_distortion += afSsimMap[i];
+
+  cur_distortion /= (float)afSsimMap.size();
+
+  if( cur_distortion >= 1.0 && cur_distortion < 1.01 )  // avoid float accuracy problem at very low QP(e.g.2)
+    cur_distortion = 1.0;
+
+  return cur_distortion;
+}
+
+float computeSsimBlocks( ClpPel** refImg, ClpPel** encImg, int width, int height, int winWidth, int winHeight, int maxValue,
+                         int step )
+{
+  return ssimBlocks( refImg, encImg, width, height, winWidth, winHeight, maxValue, step, 16, NULL );
+}
+
+float computeSsimBlocks( ClpByte** refImg, ClpByte** encImg, int width, int height, int winWidth, int winHeight, int maxValue,
+                         int step )
+{
+  return ssimBlocks( refImg, encImg, width, height, winWidth, winHeight, maxValue, step, 8, NULL );
+}
+
+template <typename T>
+static void planeQuality( T** refImg, T** encImg, int width, int height, int winSize, int maxValue, unsigned int bitsPel,
+                          unsigned long long* pSSD, double* pSSIM )
+{
+  std::atomic<unsigned long long> ullSSD( 0 );
+  int firstRow = 0;
+  if( pSSIM )
+  {
+    *pSSIM = ssimBlocks( refImg, encImg, width, height, winSize, winSize, maxValue, winSize, bitsPel, pSSD ? &ullSSD : NULL );
+    // Rows below the last window row
+    firstRow = height >= winSize ? ( height / winSize ) * winSize : 0;
+  }
+  if( pSSD )
+  {
+    CalypThreadPool::global()->parallelFor( height - firstRow, 64, [&]( unsigned int start, unsigned int end ) {
+      unsigned long long ullBandSSD = 0;
+      for( unsigned int y = firstRow + start; y < firstRow + end; y++ )
+        ullBandSSD += sumSquaredDiff( refImg[y], encImg[y], width, bitsPel );
+      ullSSD += ullBandSSD;
+    } );
+    *pSSD = ullSSD;
+  }
+}
+
+void computePlaneQuality( ClpPel** refImg, ClpPel** encImg, int width, int height, int winSize, int maxValue,
+                          unsigned int bitsPel, unsigned long long* pSSD, double* pSSIM )
+{
+  planeQuality( refImg, encImg, width, height, winSize, maxValue, bitsPel, pSSD, pSSIM );
+}
+
+void computePlaneQuality( ClpByte** refImg, ClpByte** encImg, int width, int height, int winSize, int maxValue,
+                          unsigned int bitsPel, unsigned long long* pSSD, double* pSSIM )
+{
+  planeQuality( refImg, encImg, width, height, winSize, maxValue, bitsPel, pSSD, pSSIM );
+}
+
+template <typename T>
+static double ssimGaussian( T** refImg, T** encImg, int width, int height, int maxValue )
+{
+  const int N = SSIM_GAUSSIAN_SIZE;
+  if( width < N || height < N )
+  {
+    // Plane smaller than the window: a single window over the whole plane
+    return computeSsimBlocks( refImg, encImg, width, height, width, height, maxValue, 1 );
+  }
+
+  double adWeights[N];
+  double dWeightSum = 0;
+  for( int i = 0; i < N; i++ )
+  {
+    double dist = i - N / 2;
+    adWeights[i] = exp( -( dist * dist ) / ( 2.0 * SSIM_GAUSSIAN_SIGMA * SSIM_GAUSSIAN_SIGMA ) );
+    dWeightSum += adWeights[i];
+  }
+  for( int i = 0; i < N; i++ )
+    adWeights[i] /= dWeightSum;
+
+  const double C1 = ( 0.01 * maxValue ) * ( 0.01 * maxValue );
+  const double C2 = ( 0.03 * maxValue ) * ( 0.03 * maxValue );
+  int outWidth = width - N + 1;
+  int outHeight = height - N + 1;
+  std::vector<double> adRowSsim( outHeight );
+
+  CalypThreadPool::global()->parallelFor( outHeight, 8, [&]( unsigned int startRow, unsigned int endRow ) {
+    // Vertically filtered moments of the current row
+    std::vector<double> adRef( width ), adEnc( width ), adRefSq( width ), adEncSq( width ), adCross( width );
+    for( unsigned int y = startRow; y < endRow; y++ )
+    {
+      std::fill( adRef.begin(), adRef.end(), 0.0 );
+      std::fill( adEnc.begin(), adEnc.end(), 0.0 );
+      std::fill( adRefSq.begin(), adRefSq.end(), 0.0 );
+      std::fill( adEncSq.begin(), adEncSq.end(), 0.0 );
+      std::fill( adCross.begin(), adCross.end(), 0.0 );
+      for( int n = 0; n < N; n++ )
+      {
+        const T* pRef = refImg[y + n];
+        const T* pEnc = encImg[y + n];
+        double w = adWeights[n];
+        for( int x = 0; x < width; x++ )
+        {
+          double r = pRef[x];
+          double e = pEnc[x];
+          adRef[x] += w * r;
+          adEnc[x] += w * e;
+          adRefSq[x] += w * r * r;
+          adEncSq[x] += w * e * e;
+          adCross[x] += w * r * e;
+        }
+      }
+
+      double dRowSum = 0.0;
+      for( int x = 0; x < outWidth; x++ )
+      {
+        double muRef = 0, muEnc = 0, eRefSq = 0, eEncSq = 0, eCross = 0;
+        for( int m = 0; m < N; m++ )
+        {
+          double w = adWeights[m];
+          muRef += w * adRef[x + m];
+          muEnc += w * adEnc[x + m];
+          eRefSq += w * adRefSq[x + m];
+          eEncSq += w * adEncSq[x + m];
+          eCross += w * adCross[x + m];
+        }
+        double varRef = eRefSq - muRef * muRef;
+        double varEnc = eEncSq - muEnc * muEnc;
+        double cov = eCross - muRef * muEnc;
+        dRowSum += ( ( 2.0 * muRef * muEnc + C1 ) * ( 2.0 * cov + C2 ) ) /
+                   ( ( muRef * muRef + muEnc * muEnc + C1 ) * ( varRef + varEnc + C2 ) );
+      }
+      adRowSsim[y] = dRowSum;
+    }
+  } );
+
+  double dSsim = 0.0;
+  for( int y = 0; y < outHeight; y++ )
+    dSsim += adRowSsim[y];
+  return dSsim / ( double( outWidth ) * outHeight );
+}
+
+double computeSsimGaussian( ClpPel** refImg, ClpPel** encImg, int width, int height, int maxValue )
+{
+  return ssimGaussian( refImg, encImg, width, height, maxValue );
+}
+
+double computeSsimGaussian( ClpByte** refImg, ClpByte** encImg, int width, int height, int maxValue )
+{
+  return ssimGaussian( refImg, encImg, width, height, maxValue );
+}
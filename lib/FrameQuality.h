@@ -0,0 +1,77 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FrameQuality.h
+ * \ingroup  CalypFrameGrp
+ * \brief    Quality metrics engines (SSIM)
+ *
+ * Every engine takes either pel planes or native 8 bits planes
+ */
+
+#ifndef __FRAMEQUALITY_H__
+#define __FRAMEQUALITY_H__
+
+#include "CalypDefs.h"
+
+/**
+ * SSIM averaged over rectangular windows with uniform weights
+ *
+ * Window sums are kept as running column sums in 64-bit integers, so
+ * overlapping windows (step smaller than the window) cost O(1) each.
+ * Bands of window rows run on the worker pool and the per-window values
+ * are averaged in raster order, which gives exactly the same result as
+ * summing every window from scratch
+ *
+ * @param refImg first plane
+ * @param encImg second plane
+ * @param width plane width
+ * @param height plane height
+ * @param winWidth window width
+ * @param winHeight window height
+ * @param maxValue maximum sample value (sets C1 and C2)
+ * @param step distance between two consecutive windows
+ */
+float computeSsimBlocks( ClpPel** refImg, ClpPel** encImg, int width, int height, int winWidth, int winHeight, int maxValue,
+                         int step );
+float computeSsimBlocks( ClpByte** refImg, ClpByte** encImg, int width, int height, int winWidth, int winHeight, int maxValue,
+                         int step );
+
+/**
+ * SSD and block SSIM (non-overlapping winSize x winSize windows) of one
+ * plane computed in a single pass: rows are fed to the SSD kernel while
+ * they are loaded into the SSIM window sums
+ *
+ * @param bitsPel bits per sample of both planes
+ * @param pSSD output sum of squared differences (NULL to skip)
+ * @param pSSIM output SSIM, same value as computeSsimBlocks (NULL to skip)
+ */
+void computePlaneQuality( ClpPel** refImg, ClpPel** encImg, int width, int height, int winSize, int maxValue,
+                          unsigned int bitsPel, unsigned long long* pSSD, double* pSSIM );
+void computePlaneQuality( ClpByte** refImg, ClpByte** encImg, int width, int height, int winSize, int maxValue,
+                          unsigned int bitsPel, unsigned long long* pSSD, double* pSSIM );
+
+/**
+ * SSIM averaged over every position of an 11x11 Gaussian window (sigma 1.5)
+ * as proposed by Wang et al. Rows of the SSIM map run on the worker pool
+ */
+double computeSsimGaussian( ClpPel** refImg, ClpPel** encImg, int width, int height, int maxValue );
+double computeSsimGaussian( ClpByte** refImg, ClpByte** encImg, int width, int height, int maxValue );
+
+#endif  // __FRAMEQUALITY_H__
@@ -30,10 +30,21 @@
 #include <cstdlib>
 #include <cstring>
 
-#define DATA_ALIGN 1  ///< use 32-bit aligned malloc/free
+#define DATA_ALIGN 1        ///< use aligned malloc/free
+#define DATA_ALIGN_SIZE 64  ///< alignment of the allocated blocks (one cache line)
 #if DATA_ALIGN && _WIN32 && ( _MSC_VER > 1300 )
-#define xMalloc( len ) _aligned_malloc( len, 32 )
+#define xMalloc( len ) _aligned_malloc( len, DATA_ALIGN_SIZE )
 #define xFreeMem( ptr ) _aligned_free( ptr )
+#elif DATA_ALIGN && !defined( _WIN32 )
+static inline void* xAlignedMalloc( size_t len )
+{
+  void* d;
+  if( posix_memalign( &d, DATA_ALIGN_SIZE, len ) != 0 )
+    return NULL;
+  return d;
+}
+#define xMalloc( len ) xAlignedMalloc( len )
+#define xFreeMem( ptr ) free( ptr )
 #else
 #define xMalloc( len ) malloc( len )
 #define xFreeMem( ptr ) free( ptr )
@@ -43,12 +43,6 @@
  **************************************************************
  */
 
-#ifdef USE_FFMPEG
-#define ADD_FFMPEG_PEL_FMT( fmt ) fmt
-#else
-#define ADD_FFMPEG_PEL_FMT( fmt ) 0
-#endif
-
 #if 0
 void fillARGB32bufferYUV420p( Pel*** in, UChar* out, unsigned int width, unsigned int height, unsigned int depth )
 {
@@ -198,190 +192,9 @@ void fillARGB32bufferYUV420p( Pel*** in, UChar* out, unsigned int width, unsigne
 }
 #endif
 
-const std::map<int, CalypPixelFormatDescriptor> g_CalypPixFmtDescriptorsMap = {
-    {
-        CLP_YUV420P,
-        {
-            "YUV420p",
-            CLP_COLOR_YUV,
-            3,
-            3,
-            1,
-            1,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_YUV420P ),
-            {
-                {0, 0, 1}, /* Y */
-                {1, 0, 1}, /* U */
-                {2, 0, 1}, /* V */
-            },
-        },
-    },
-    {
-        CLP_YUV422P,
-        {
-            "YUV422p",
-            CLP_COLOR_YUV,
-            3,
-            3,
-            1,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_YUV422P ),
-            {
-                {0, 0, 1}, /* Y */
-                {1, 0, 1}, /* U */
-                {2, 0, 1}, /* V */
-            },
-        },
-    },
-    {
-        CLP_YUV444P,
-        {
-            "YUV444p",
-            CLP_COLOR_YUV,
-            3,
-            3,
-            0,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_YUV444P ),
-            {
-                {0, 0, 1}, /* Y */
-                {1, 0, 1}, /* U */
-                {2, 0, 1}, /* V */
-            },
-        },
-    },
-    {
-        CLP_YUYV422,
-        {
-            "YUYV422",
-            CLP_COLOR_YUV,
-            3,
-            1,
-            1,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_YUYV422 ),
-            {
-                {0, 1, 1}, /* Y */
-                {0, 3, 2}, /* U */
-                {0, 3, 4}, /* V */
-            },
-        },
-    },
-    {
-        CLP_GRAY,
-        {
-            "GRAY",
-            CLP_COLOR_GRAY,
-            1,
-            1,
-            0,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_GRAY8 ),
-            {{0, 0, 1}}, /* Y */
-        },
-    },
-    {
-        CLP_RGB24P,
-        {
-            "RGBp",
-            CLP_COLOR_RGB,
-            3,
-            3,
-            0,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_NONE ),
-            {
-                {0, 0, 1}, /* R */
-                {1, 0, 1}, /* G */
-                {2, 0, 1}, /* B */
-            },
-        },
-    },
-    {
-        CLP_RGB24,
-        {
-            "RGB",
-            CLP_COLOR_RGB,
-            3,
-            1,
-            0,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_RGB24 ),
-            {
-                {0, 2, 1}, /* R */
-                {0, 2, 2}, /* G */
-                {0, 2, 3}, /* B */
-            },
-        },
-    },
-    {
-        CLP_BGR24,
-        {
-            "BGR",
-            CLP_COLOR_RGB,
-            3,
-            1,
-            0,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_BGR24 ),
-            {
-                {0, 2, 3}, /* R */
-                {0, 2, 2}, /* G */
-                {0, 2, 1}, /* B */
-            },
-        },
-    },
-    {
-        CLP_BGR24,
-        {
-            "BGR",
-            CLP_COLOR_RGB,
-            3,
-            1,
-            0,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_BGR24 ),
-            {
-                {0, 2, 3}, /* R */
-                {0, 2, 2}, /* G */
-                {0, 2, 1}, /* B */
-            },
-        },
-    },
-    {
-        CLP_RGBA32,
-        {
-            "RGBA",
-            CLP_COLOR_RGBA,
-            4,
-            1,
-            0,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_RGBA ),
-            {
-                {0, 3, 1}, /* R */
-                {0, 3, 2}, /* G */
-                {0, 3, 3}, /* B */
-                {0, 3, 4}, /* A */
-            },
-        },
-    },
-    {
-        CLP_BGRA32,
-        {
-            "BGRA",
-            CLP_COLOR_RGBA,
-            4,
-            1,
-            0,
-            0,
-            ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_BGRA ),
-            {
-                {0, 3, 3}, /* R */
-                {0, 3, 2}, /* G */
-                {0, 3, 1}, /* B */
-                {0, 3, 4}, /* A */
-            },
-        },
-    },
-};
+const CalypPixelFormatDescriptor& getPixFmtDescriptor( int pelFormat )
+{
+  if( pelFormat < 0 || pelFormat >= CLP_NUMBER_FORMATS )
+    throw std::out_of_range( "Invalid pixel format" );
+  return g_CalypPixFmtDescriptors[pelFormat];
+}
@@ -26,8 +26,18 @@
 #define __PIXELFORMATS_H__
 
 #include "CalypFrame.h"
+#include "config.h"
 
-#include <map>
+#include <stdexcept>
+
+#ifdef USE_FFMPEG
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+#define ADD_FFMPEG_PEL_FMT( fmt ) fmt
+#else
+#define ADD_FFMPEG_PEL_FMT( fmt ) 0
+#endif
 
 #define CHROMA_RESAMPLING( X ) ( ( ( X + 1 ) >> 1 ) << 1 )
 
@@ -42,13 +52,15 @@ typedef struct CalypComponentDescriptor
 
   /**
    * Number of elements between 2 horizontally consecutive pixels minus 1.
-   * Elements are bits for bitstream formats, bytes otherwise.
+   * Elements are bits for bitstream formats, samples otherwise
+   * (bytes for 8 bits samples).
    */
   unsigned short step_minus1;
 
   /**
    * Number of elements before the component of the first pixel plus 1.
-   * Elements are bits for bitstream formats, bytes otherwise.
+   * Elements are bits for bitstream formats, samples otherwise
+   * (bytes for 8 bits samples).
    */
   unsigned short offset_plus1;
 
@@ -107,6 +119,172 @@ typedef struct CalypPixelFormatDescriptor
 
 #define MAX_NUMBER_PLANES 3
 
-extern const std::map<int, CalypPixelFormatDescriptor> g_CalypPixFmtDescriptorsMap;
+#define CLP_NUMBER_FORMATS ( CLP_BGRA32 + 1 )
+
+/**
+ * Descriptors of the supported pixel formats, indexed by CalypPixelFormats
+ *
+ * The table is constexpr so that kernels can be instantiated for each
+ * format with its fields as compile time constants (see FrameKernels.h)
+ */
+constexpr CalypPixelFormatDescriptor g_CalypPixFmtDescriptors[] = {
+    // CLP_YUV420P
+    {
+        "YUV420p",
+        CLP_COLOR_YUV,
+        3,
+        3,
+        1,
+        1,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_YUV420P ),
+        {
+            {0, 0, 1}, /* Y */
+            {1, 0, 1}, /* U */
+            {2, 0, 1}, /* V */
+        },
+    },
+    // CLP_YUV422P
+    {
+        "YUV422p",
+        CLP_COLOR_YUV,
+        3,
+        3,
+        1,
+        0,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_YUV422P ),
+        {
+            {0, 0, 1}, /* Y */
+            {1, 0, 1}, /* U */
+            {2, 0, 1}, /* V */
+        },
+    },
+    // CLP_YUV444P
+    {
+        "YUV444p",
+        CLP_COLOR_YUV,
+        3,
+        3,
+        0,
+        0,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_YUV444P ),
+        {
+            {0, 0, 1}, /* Y */
+            {1, 0, 1}, /* U */
+            {2, 0, 1}, /* V */
+        },
+    },
+    // CLP_YUYV422
+    {
+        "YUYV422",
+        CLP_COLOR_YUV,
+        3,
+        1,
+        1,
+        0,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_YUYV422 ),
+        {
+            {0, 1, 1}, /* Y */
+            {0, 3, 2}, /* U */
+            {0, 3, 4}, /* V */
+        },
+    },
+    // CLP_GRAY
+    {
+        "GRAY",
+        CLP_COLOR_GRAY,
+        1,
+        1,
+        0,
+        0,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_GRAY8 ),
+        {{0, 0, 1}}, /* Y */
+    },
+    // CLP_RGB24P
+    {
+        "RGBp",
+        CLP_COLOR_RGB,
+        3,
+        3,
+        0,
+        0,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_NONE ),
+        {
+            {0, 0, 1}, /* R */
+            {1, 0, 1}, /* G */
+            {2, 0, 1}, /* B */
+        },
+    },
+    // CLP_RGB24
+    {
+        "RGB",
+        CLP_COLOR_RGB,
+        3,
+        1,
+        0,
+        0,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_RGB24 ),
+        {
+            {0, 2, 1}, /* R */
+            {0, 2, 2}, /* G */
+            {0, 2, 3}, /* B */
+        },
+    },
+    // CLP_BGR24
+    {
+        "BGR",
+        CLP_COLOR_RGB,
+        3,
+        1,
+        0,
+        0,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_BGR24 ),
+        {
+            {0, 2, 3}, /* R */
+            {0, 2, 2}, /* G */
+            {0, 2, 1}, /* B */
+        },
+    },
+    // CLP_RGBA32
+    {
+        "RGBA",
+        CLP_COLOR_RGBA,
+        4,
+        1,
+        0,
+        0,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_RGBA ),
+        {
+            {0, 3, 1}, /* R */
+            {0, 3, 2}, /* G */
+            {0, 3, 3}, /* B */
+            {0, 3, 4}, /* A */
+        },
+    },
+    // CLP_BGRA32
+    {
+        "BGRA",
+        CLP_COLOR_RGBA,
+        4,
+        1,
+        0,
+        0,
+        ADD_FFMPEG_PEL_FMT( AV_PIX_FMT_BGRA ),
+        {
+            {0, 3, 3}, /* R */
+            {0, 3, 2}, /* G */
+            {0, 3, 1}, /* B */
+            {0, 3, 4}, /* A */
+        },
+    },
+};
+
+static_assert( sizeof( g_CalypPixFmtDescriptors ) / sizeof( g_CalypPixFmtDescriptors[0] ) == CLP_NUMBER_FORMATS,
+               "Every pixel format needs a descriptor" );
+
+/**
+ * Descriptor of a pixel format
+ * @throw std::out_of_range for unknown formats
+ */
+const CalypPixelFormatDescriptor& getPixFmtDescriptor( int pelFormat );
 
 #endif  // __PIXELFORMATS_H__
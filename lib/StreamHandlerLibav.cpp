@@ -201,7 +201,7 @@ bool StreamHandlerLibav::openHandler( ClpString strFilename, bool bInput )
   m_iPixelFormat = CLP_INVALID_FMT;
   for( int i = 0; i < CalypFrame::numberOfFormats(); i++ )
   {
-    if( g_CalypPixFmtDescriptorsMap.at( i ).ffmpegPelFormat == auxPixFmt )
+    if( getPixFmtDescriptor( i ).ffmpegPelFormat == auxPixFmt )
     {
       m_iPixelFormat = i;
       break;
@@ -274,7 +274,7 @@ bool StreamHandlerLibav::openHandler( ClpString strFilename, bool bInput )
     }
     m_iPixelFormat = newPelFmt;
 
-    AVPixelFormat newAvFmt = AVPixelFormat( g_CalypPixFmtDescriptorsMap.at( m_iPixelFormat ).ffmpegPelFormat );
+    AVPixelFormat newAvFmt = AVPixelFormat( getPixFmtDescriptor( m_iPixelFormat ).ffmpegPelFormat );
 
     /* create scaling context */
     m_ScalerCtx = sws_getContext( m_uiWidth, m_uiHeight, AVPixelFormat( m_ffPixFmt ),
@@ -28,6 +28,462 @@
 #include "LibMemory.h"
 
 #include <cstdio>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if defined( HAVE_MMAP ) || defined( HAVE_PREAD )
+#include <cerrno>
+#include <unistd.h>
+#endif
+#ifdef USE_IOURING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#endif
+
+// Frames read after a seek before going back to read ahead advice
+#define RAW_SEQUENTIAL_READS 2
+
+/**
+ * 64-bit file offsets
+ */
+static int seekFile( FILE* pFile, unsigned long long offset, int whence )
+{
+#ifdef _WIN32
+  return _fseeki64( pFile, offset, whence );
+#else
+  return fseeko( pFile, offset, whence );
+#endif
+}
+
+static unsigned long long tellFile( FILE* pFile )
+{
+#ifdef _WIN32
+  return _ftelli64( pFile );
+#else
+  return ftello( pFile );
+#endif
+}
+
+/**
+ * Read bytes at an offset of the file
+ */
+static bool readFileAt( FILE* pFile, ClpByte* pBuffer, unsigned long long uiBytes, unsigned long long uiOffset )
+{
+#ifdef HAVE_PREAD
+  int iFd = fileno( pFile );
+  while( uiBytes > 0 )
+  {
+    ssize_t iRead = pread( iFd, pBuffer, uiBytes, uiOffset );
+    if( iRead < 0 && errno == EINTR )
+      continue;
+    if( iRead <= 0 )
+      return false;
+    pBuffer += iRead;
+    uiBytes -= iRead;
+    uiOffset += iRead;
+  }
+  return true;
+#else
+  if( seekFile( pFile, uiOffset, SEEK_SET ) != 0 )
+    return false;
+  return fread( pBuffer, sizeof( ClpByte ), uiBytes, pFile ) == uiBytes;
+#endif
+}
+
+#ifdef USE_IOURING
+
+// Entries of the shared submission queue
+#define RAW_RING_ENTRIES 64
+// Memory used by the frames read ahead of each stream (at least two frames)
+#define RAW_RING_BUDGET ( 64 << 20 )
+#define RAW_RING_MAX_DEPTH 4
+
+/**
+ * Read of a frame queued on the ring
+ */
+struct StreamHandlerRawRequest
+{
+  int iFd;
+  ClpByte* pBuffer;
+  unsigned long long uiBytes;
+  unsigned long long uiOffset;
+  long long iResult;  //!< Bytes read or negative error
+  bool bDone;
+};
+
+/**
+ * io_uring shared by all the raw streams, driven through the kernel
+ * interface. Reads are only prepared by queue(); submit() hands every
+ * prepared read (from any stream) to the kernel in one call and wait()
+ * sleeps until a read completes (submitting what is left first). While
+ * a batch is open submit() does nothing and the reads prepared by every
+ * stream go together when the batch ends. One waiting thread reaps the
+ * completions for all the others
+ */
+class StreamHandlerRawRing
+{
+public:
+  /**
+   * @return the ring or NULL if io_uring cannot be used
+   */
+  static StreamHandlerRawRing* global()
+  {
+    static StreamHandlerRawRing s_cRing;
+    return s_cRing.m_iRingFd >= 0 ? &s_cRing : NULL;
+  }
+
+  void queue( StreamHandlerRawRequest* pcRequest )
+  {
+    std::unique_lock<std::mutex> lock( m_mutex );
+    pcRequest->bDone = false;
+    // Never have more reads than completion entries
+    while( !m_bBroken && m_uiQueued + m_uiInFlight >= m_uiEntries )
+      waitCompletions( lock );
+    if( m_bBroken )
+    {
+      finish( pcRequest, -EIO );
+      return;
+    }
+    unsigned uiTail = *m_puiSqTail;
+    unsigned uiIdx = uiTail & *m_puiSqMask;
+    struct io_uring_sqe* pcSqe = &m_pcSqes[uiIdx];
+    memset( pcSqe, 0, sizeof( *pcSqe ) );
+    pcSqe->opcode = IORING_OP_READ;
+    pcSqe->fd = pcRequest->iFd;
+    pcSqe->addr = (unsigned long long)pcRequest->pBuffer;
+    pcSqe->len = pcRequest->uiBytes;
+    pcSqe->off = pcRequest->uiOffset;
+    pcSqe->user_data = (unsigned long long)pcRequest;
+    m_puiSqArray[uiIdx] = uiIdx;
+    __atomic_store_n( m_puiSqTail, uiTail + 1, __ATOMIC_RELEASE );
+    m_uiQueued++;
+  }
+
+  void submit()
+  {
+    std::unique_lock<std::mutex> lock( m_mutex );
+    if( m_uiBatches == 0 )
+      submitQueued();
+  }
+
+  void beginBatch()
+  {
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_uiBatches++;
+  }
+
+  void endBatch()
+  {
+    std::unique_lock<std::mutex> lock( m_mutex );
+    if( m_uiBatches > 0 && --m_uiBatches == 0 )
+      submitQueued();
+  }
+
+  void wait( StreamHandlerRawRequest* pcRequest )
+  {
+    std::unique_lock<std::mutex> lock( m_mutex );
+    while( !pcRequest->bDone )
+      waitCompletions( lock );
+  }
+
+private:
+  StreamHandlerRawRing()
+      : m_iRingFd( -1 )
+      , m_pSqRing( MAP_FAILED )
+      , m_pCqRing( MAP_FAILED )
+      , m_pcSqes( (struct io_uring_sqe*)MAP_FAILED )
+      , m_uiQueued( 0 )
+      , m_uiInFlight( 0 )
+      , m_uiBatches( 0 )
+      , m_bReaping( false )
+      , m_bBroken( false )
+  {
+    struct io_uring_params sParams;
+    memset( &sParams, 0, sizeof( sParams ) );
+    m_iRingFd = syscall( __NR_io_uring_setup, RAW_RING_ENTRIES, &sParams );
+    if( m_iRingFd < 0 )
+      return;
+    m_uiEntries = std::min( sParams.sq_entries, sParams.cq_entries );
+    m_uiSqRingBytes = sParams.sq_off.array + sParams.sq_entries * sizeof( unsigned );
+    m_uiCqRingBytes = sParams.cq_off.cqes + sParams.cq_entries * sizeof( struct io_uring_cqe );
+    if( sParams.features & IORING_FEAT_SINGLE_MMAP )
+      m_uiSqRingBytes = m_uiCqRingBytes = std::max( m_uiSqRingBytes, m_uiCqRingBytes );
+    m_uiSqesBytes = sParams.sq_entries * sizeof( struct io_uring_sqe );
+    m_pSqRing = mmap( NULL, m_uiSqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_iRingFd, IORING_OFF_SQ_RING );
+    if( sParams.features & IORING_FEAT_SINGLE_MMAP )
+      m_pCqRing = m_pSqRing;
+    else
+      m_pCqRing = mmap( NULL, m_uiCqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_iRingFd, IORING_OFF_CQ_RING );
+    m_pcSqes = (struct io_uring_sqe*)mmap( NULL, m_uiSqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_iRingFd, IORING_OFF_SQES );
+    if( m_pSqRing == MAP_FAILED || m_pCqRing == MAP_FAILED || m_pcSqes == MAP_FAILED )
+    {
+      release();
+      return;
+    }
+    ClpByte* pSq = (ClpByte*)m_pSqRing;
+    m_puiSqHead = (unsigned*)( pSq + sParams.sq_off.head );
+    m_puiSqTail = (unsigned*)( pSq + sParams.sq_off.tail );
+    m_puiSqMask = (unsigned*)( pSq + sParams.sq_off.ring_mask );
+    m_puiSqArray = (unsigned*)( pSq + sParams.sq_off.array );
+    ClpByte* pCq = (ClpByte*)m_pCqRing;
+    m_puiCqHead = (unsigned*)( pCq + sParams.cq_off.head );
+    m_puiCqTail = (unsigned*)( pCq + sParams.cq_off.tail );
+    m_puiCqMask = (unsigned*)( pCq + sParams.cq_off.ring_mask );
+    m_pcCqes = (struct io_uring_cqe*)( pCq + sParams.cq_off.cqes );
+  }
+
+  ~StreamHandlerRawRing() { release(); }
+
+  void release()
+  {
+    if( m_pcSqes != MAP_FAILED )
+      munmap( m_pcSqes, m_uiSqesBytes );
+    if( m_pCqRing != MAP_FAILED && m_pCqRing != m_pSqRing )
+      munmap( m_pCqRing, m_uiCqRingBytes );
+    if( m_pSqRing != MAP_FAILED )
+      munmap( m_pSqRing, m_uiSqRingBytes );
+    if( m_iRingFd >= 0 )
+      close( m_iRingFd );
+    m_iRingFd = -1;
+  }
+
+  void finish( StreamHandlerRawRequest* pcRequest, long long iResult )
+  {
+    pcRequest->iResult = iResult;
+    pcRequest->bDone = true;
+  }
+
+  /**
+   * Submit the prepared reads (lock held)
+   */
+  void submitQueued()
+  {
+    while( m_uiQueued > 0 && !m_bBroken )
+    {
+      int iSubmitted = syscall( __NR_io_uring_enter, m_iRingFd, m_uiQueued, 0, 0, NULL, 0 );
+      if( iSubmitted > 0 )
+      {
+        m_uiQueued -= iSubmitted;
+        m_uiInFlight += iSubmitted;
+        continue;
+      }
+      if( iSubmitted < 0 && errno == EINTR )
+        continue;
+      // Out of resources: retry once some reads complete
+      if( iSubmitted < 0 && ( errno == EAGAIN || errno == EBUSY ) && m_uiInFlight > 0 )
+        return;
+      // The kernel only takes entries inside io_uring_enter, so the reads
+      // still in the submission queue are never run
+      m_bBroken = true;
+      unsigned uiHead = __atomic_load_n( m_puiSqHead, __ATOMIC_ACQUIRE );
+      for( unsigned uiTail = *m_puiSqTail; uiHead != uiTail; uiHead++ )
+        finish( (StreamHandlerRawRequest*)m_pcSqes[m_puiSqArray[uiHead & *m_puiSqMask]].user_data, -EIO );
+      m_uiQueued = 0;
+    }
+  }
+
+  /**
+   * Submit the prepared reads and sleep until some read completes (lock held)
+   */
+  void waitCompletions( std::unique_lock<std::mutex>& lock )
+  {
+    submitQueued();
+    if( m_bReaping )
+    {
+      m_cond.wait( lock );
+      return;
+    }
+    if( m_uiInFlight == 0 )
+      return;
+    m_bReaping = true;
+    lock.unlock();
+    syscall( __NR_io_uring_enter, m_iRingFd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0 );
+    lock.lock();
+    m_bReaping = false;
+    unsigned uiHead = *m_puiCqHead;
+    unsigned uiTail = __atomic_load_n( m_puiCqTail, __ATOMIC_ACQUIRE );
+    for( ; uiHead != uiTail; uiHead++ )
+    {
+      struct io_uring_cqe* pcCqe = &m_pcCqes[uiHead & *m_puiCqMask];
+      finish( (StreamHandlerRawRequest*)pcCqe->user_data, pcCqe->res );
+      m_uiInFlight--;
+    }
+    __atomic_store_n( m_puiCqHead, uiHead, __ATOMIC_RELEASE );
+    m_cond.notify_all();
+  }
+
+  int m_iRingFd;
+  unsigned m_uiEntries;
+  void* m_pSqRing;
+  void* m_pCqRing;
+  struct io_uring_sqe* m_pcSqes;
+  std::size_t m_uiSqRingBytes;
+  std::size_t m_uiCqRingBytes;
+  std::size_t m_uiSqesBytes;
+  unsigned* m_puiSqHead;
+  unsigned* m_puiSqTail;
+  unsigned* m_puiSqMask;
+  unsigned* m_puiSqArray;
+  unsigned* m_puiCqHead;
+  unsigned* m_puiCqTail;
+  unsigned* m_puiCqMask;
+  struct io_uring_cqe* m_pcCqes;
+
+  unsigned m_uiQueued;    //!< Prepared reads not submitted yet
+  unsigned m_uiInFlight;  //!< Submitted reads not completed yet
+  unsigned m_uiBatches;   //!< Open batches, submit() waits for the last one
+  bool m_bReaping;
+  bool m_bBroken;  //!< Submission failed, reads complete with an error
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+};
+
+/**
+ * Frames of one stream read ahead through the ring: reading a frame
+ * queues the following ones in the free slots. Slots keep their frame
+ * after a seek so a short jump reuses them
+ */
+class StreamHandlerRawQueue
+{
+public:
+  StreamHandlerRawQueue( StreamHandlerRawRing* pcRing, FILE* pFile, unsigned long long uiFrameBytes )
+      : m_pcRing( pcRing ), m_pFile( pFile ), m_uiFrameBytes( uiFrameBytes )
+  {
+    unsigned long long uiDepth = RAW_RING_BUDGET / std::max( uiFrameBytes, 1ULL );
+    m_apcSlots.resize( std::max( 2ULL, std::min( uiDepth, (unsigned long long)RAW_RING_MAX_DEPTH ) ) );
+    for( std::size_t i = 0; i < m_apcSlots.size(); i++ )
+    {
+      m_apcSlots[i].uiFrame = -1;
+      m_apcSlots[i].bPending = false;
+      m_apcSlots[i].pBuffer = NULL;
+    }
+  }
+
+  ~StreamHandlerRawQueue()
+  {
+    for( std::size_t i = 0; i < m_apcSlots.size(); i++ )
+    {
+      if( m_apcSlots[i].bPending )
+        m_pcRing->wait( &m_apcSlots[i].cRequest );
+      if( m_apcSlots[i].pBuffer )
+        freeMem1D( m_apcSlots[i].pBuffer );
+    }
+  }
+
+  bool allocate()
+  {
+    for( std::size_t i = 0; i < m_apcSlots.size(); i++ )
+      if( !getMem1D<ClpByte>( &m_apcSlots[i].pBuffer, m_uiFrameBytes ) )
+        return false;
+    return true;
+  }
+
+  /**
+   * @return the buffer of a frame (valid until the next call) or NULL
+   */
+  ClpByte* read( unsigned long long uiFrame, unsigned long long uiTotalFrames )
+  {
+    unsigned long long uiEnd = std::min( uiFrame + m_apcSlots.size(), uiTotalFrames );
+    Slot* pcFrameSlot = NULL;
+    for( unsigned long long uiNext = uiFrame; uiNext < uiEnd; uiNext++ )
+    {
+      Slot* pcSlot = find( uiNext );
+      if( !pcSlot )
+      {
+        // One slot per frame of the window, so some slot is outside it
+        pcSlot = find( uiFrame, uiEnd );
+        if( pcSlot->bPending )
+          m_pcRing->wait( &pcSlot->cRequest );
+        pcSlot->uiFrame = uiNext;
+        pcSlot->bPending = true;
+        pcSlot->cRequest.iFd = fileno( m_pFile );
+        pcSlot->cRequest.pBuffer = pcSlot->pBuffer;
+        pcSlot->cRequest.uiBytes = m_uiFrameBytes;
+        pcSlot->cRequest.uiOffset = uiNext * m_uiFrameBytes;
+        m_pcRing->queue( &pcSlot->cRequest );
+      }
+      if( uiNext == uiFrame )
+        pcFrameSlot = pcSlot;
+    }
+    // Start the reads ahead even if the frame is already there (at the
+    // end of the batch if one is open)
+    m_pcRing->submit();
+    if( !pcFrameSlot )
+      return NULL;
+    if( pcFrameSlot->bPending )
+    {
+      m_pcRing->wait( &pcFrameSlot->cRequest );
+      pcFrameSlot->bPending = false;
+      // Short or failed reads are finished synchronously
+      unsigned long long uiRead = std::max( pcFrameSlot->cRequest.iResult, 0LL );
+      if( uiRead < m_uiFrameBytes &&
+          !readFileAt( m_pFile, pcFrameSlot->pBuffer + uiRead, m_uiFrameBytes - uiRead, uiFrame * m_uiFrameBytes + uiRead ) )
+      {
+        pcFrameSlot->uiFrame = -1;
+        return NULL;
+      }
+    }
+    return pcFrameSlot->pBuffer;
+  }
+
+private:
+  struct Slot
+  {
+    ClpByte* pBuffer;
+    unsigned long long uiFrame;
+    bool bPending;  //!< Read queued and not waited for
+    StreamHandlerRawRequest cRequest;
+  };
+
+  Slot* find( unsigned long long uiFrame )
+  {
+    for( std::size_t i = 0; i < m_apcSlots.size(); i++ )
+      if( m_apcSlots[i].uiFrame == uiFrame )
+        return &m_apcSlots[i];
+    return NULL;
+  }
+
+  /**
+   * Find a slot with a frame outside [uiFirst, uiEnd)
+   */
+  Slot* find( unsigned long long uiFirst, unsigned long long uiEnd )
+  {
+    for( std::size_t i = 0; i < m_apcSlots.size(); i++ )
+      if( m_apcSlots[i].uiFrame < uiFirst || m_apcSlots[i].uiFrame >= uiEnd )
+        return &m_apcSlots[i];
+    return NULL;
+  }
+
+  StreamHandlerRawRing* m_pcRing;
+  FILE* m_pFile;
+  unsigned long long m_uiFrameBytes;
+  std::vector<Slot> m_apcSlots;
+};
+#endif
+
+void StreamHandlerRaw::beginReadBatch()
+{
+#ifdef USE_IOURING
+  if( StreamHandlerRawRing::global() )
+    StreamHandlerRawRing::global()->beginBatch();
+#endif
+}
+
+void StreamHandlerRaw::endReadBatch()
+{
+#ifdef USE_IOURING
+  if( StreamHandlerRawRing::global() )
+    StreamHandlerRawRing::global()->endBatch();
+#endif
+}
 
 std::vector<CalypStreamFormat> StreamHandlerRaw::supportedReadFormats()
 {
@@ -54,6 +510,30 @@ bool StreamHandlerRaw::openHandler( ClpString strFilename, bool bInput )
   {
     return false;
   }
+#ifdef USE_IOURING
+  m_bUseRing = bInput && StreamHandlerRawRing::global();
+#endif
+#ifdef HAVE_MMAP
+  bool bMapFile = bInput;
+#ifdef USE_IOURING
+  // Reads through the ring replace the mapping
+  bMapFile = bMapFile && !m_bUseRing;
+#endif
+  m_pMappedFile = NULL;
+  m_uiMappedBytes = 0;
+  struct stat sFileStat;
+  if( bMapFile && fstat( fileno( m_pFile ), &sFileStat ) == 0 && sFileStat.st_size > 0 )
+  {
+    void* pMap = mmap( NULL, sFileStat.st_size, PROT_READ, MAP_PRIVATE, fileno( m_pFile ), 0 );
+    if( pMap != MAP_FAILED )
+    {
+      m_pMappedFile = (ClpByte*)pMap;
+      m_uiMappedBytes = sFileStat.st_size;
+      m_bSequential = false;
+      adviseAccess( true );
+    }
+  }
+#endif
   calculateFrameNumber();
   m_strFormatName = "YUV";
   m_strCodecName = "Raw Video";
@@ -62,14 +542,37 @@ bool StreamHandlerRaw::openHandler( ClpString strFilename, bool bInput )
 
 void StreamHandlerRaw::closeHandler()
 {
+#ifdef USE_IOURING
+  // Waits for the reads in flight
+  delete m_pcQueue;
+  m_pcQueue = NULL;
+#endif
+#ifdef HAVE_MMAP
+  if( m_pMappedFile )
+    unmapFile();
+#endif
   if( m_pFile )
     fclose( m_pFile );
+  m_pFile = NULL;
   if( m_pStreamBuffer )
     freeMem1D( m_pStreamBuffer );
 }
 
 bool StreamHandlerRaw::configureBuffer( CalypFrame* pcFrame )
 {
+#ifdef HAVE_MMAP
+  // Frames are unpacked from the mapped file
+  if( m_pMappedFile )
+    return true;
+#endif
+#ifdef USE_IOURING
+  if( m_bUseRing )
+  {
+    delete m_pcQueue;
+    m_pcQueue = new StreamHandlerRawQueue( StreamHandlerRawRing::global(), m_pFile, pcFrame->getBytesPerFrame() );
+    return m_pcQueue->allocate();
+  }
+#endif
   return getMem1D<ClpByte>( &m_pStreamBuffer, pcFrame->getBytesPerFrame() );
 }
 
@@ -77,30 +580,114 @@ void StreamHandlerRaw::calculateFrameNumber()
 {
   if( m_pFile && m_uiNBytesPerFrame > 0 )
   {
-    fseek( m_pFile, 0, SEEK_END );
-    unsigned long long int fileSize = ftell( m_pFile );
-    fseek( m_pFile, 0, SEEK_SET );
+#ifdef HAVE_MMAP
+    if( m_pMappedFile )
+    {
+      m_uiTotalNumberFrames = m_uiMappedBytes / m_uiNBytesPerFrame;
+      return;
+    }
+#endif
+    seekFile( m_pFile, 0, SEEK_END );
+    unsigned long long int fileSize = tellFile( m_pFile );
+    seekFile( m_pFile, 0, SEEK_SET );
     m_uiTotalNumberFrames = fileSize / m_uiNBytesPerFrame;
   }
 }
 
+#ifdef HAVE_MMAP
+void StreamHandlerRaw::adviseAccess( bool bSequential )
+{
+  if( bSequential == m_bSequential )
+    return;
+  m_bSequential = bSequential;
+  madvise( m_pMappedFile, m_uiMappedBytes, bSequential ? MADV_SEQUENTIAL : MADV_RANDOM );
+}
+
+void StreamHandlerRaw::unmapFile()
+{
+  munmap( m_pMappedFile, m_uiMappedBytes );
+  m_pMappedFile = NULL;
+  m_uiMappedBytes = 0;
+}
+#endif
+
 bool StreamHandlerRaw::seek( unsigned long long int iFrameNum )
 {
-  if( m_bIsInput && m_pFile )
+  if( !m_bIsInput || !m_pFile )
+    return false;
+#ifdef HAVE_MMAP
+  if( m_pMappedFile )
   {
-    fseek( m_pFile, iFrameNum >= 0 ? iFrameNum * m_uiNBytesPerFrame : 0, SEEK_SET );
+    // Touching the pages past the end of a file truncated while mapped
+    // raises SIGBUS: the size is checked here rather than on every read,
+    // so a truncation during sequential playback is only caught at the
+    // next seek or reload
+    struct stat sFileStat;
+    if( fstat( fileno( m_pFile ), &sFileStat ) != 0 || (unsigned long long)sFileStat.st_size < m_uiMappedBytes )
+    {
+      unmapFile();
+      calculateFrameNumber();
+      if( iFrameNum >= m_uiTotalNumberFrames )
+        return false;
+    }
+  }
+  if( m_pMappedFile )
+  {
+    if( iFrameNum != m_uiCurrFrameFileIdx )
+    {
+      m_uiSequentialReads = 0;
+      adviseAccess( false );
+    }
     m_uiCurrFrameFileIdx = iFrameNum;
     return true;
   }
-  return false;
+#endif
+  // Frames are read at their offset
+  m_uiCurrFrameFileIdx = iFrameNum;
+  return true;
 }
 
 bool StreamHandlerRaw::read( CalypFrame* pcFrame )
 {
-  if( !m_pFile || !m_pStreamBuffer || m_uiNBytesPerFrame == 0 )
+#ifdef HAVE_MMAP
+  if( m_pMappedFile )
+  {
+    if( m_uiNBytesPerFrame == 0 || m_uiCurrFrameFileIdx >= m_uiTotalNumberFrames )
+      return false;
+    unsigned long long offset = (unsigned long long)m_uiCurrFrameFileIdx * m_uiNBytesPerFrame;
+    if( ++m_uiSequentialReads >= RAW_SEQUENTIAL_READS )
+      adviseAccess( true );
+    if( !m_bSequential && m_uiCurrFrameFileIdx + 1 < m_uiTotalNumberFrames )
+    {
+      // Fetch the following frame while this one is unpacked
+      long pageSize = sysconf( _SC_PAGESIZE );
+      unsigned long long nextStart = ( offset + m_uiNBytesPerFrame ) / pageSize * pageSize;
+      madvise( m_pMappedFile + nextStart, offset + 2ULL * m_uiNBytesPerFrame - nextStart, MADV_WILLNEED );
+    }
+    m_uiCurrFrameFileIdx++;
+    pcFrame->frameFromBuffer( m_pMappedFile + offset, m_iEndianness );
+    return true;
+  }
+#endif
+#ifdef USE_IOURING
+  if( m_pcQueue )
+  {
+    if( m_uiNBytesPerFrame == 0 || m_uiCurrFrameFileIdx >= m_uiTotalNumberFrames )
+      return false;
+    ClpByte* pBuffer = m_pcQueue->read( m_uiCurrFrameFileIdx, m_uiTotalNumberFrames );
+    if( !pBuffer )
+      return false;
+    m_uiCurrFrameFileIdx++;
+    pcFrame->frameFromBuffer( pBuffer, m_iEndianness );
+    return true;
+  }
+#endif
+  if( !m_pFile || m_uiNBytesPerFrame == 0 )
     return false;
-  unsigned long long int processed_bytes = fread( m_pStreamBuffer, sizeof( ClpByte ), m_uiNBytesPerFrame, m_pFile );
-  if( processed_bytes != m_uiNBytesPerFrame )
+  // Files that were mapped get their buffer on the first read
+  if( !m_pStreamBuffer && !getMem1D<ClpByte>( &m_pStreamBuffer, m_uiNBytesPerFrame ) )
+    return false;
+  if( !readFileAt( m_pFile, m_pStreamBuffer, m_uiNBytesPerFrame, (unsigned long long)m_uiCurrFrameFileIdx * m_uiNBytesPerFrame ) )
     return false;
   m_uiCurrFrameFileIdx++;
   pcFrame->frameFromBuffer( m_pStreamBuffer, m_iEndianness );
@@ -27,10 +27,27 @@
 #define __STREAMHANDLERRAW_H__
 
 #include "CalypStreamHandlerIf.h"
+#include "config.h"
+
+#ifdef USE_IOURING
+class StreamHandlerRawQueue;
+#endif
 
 /**
  * \class StreamHandlerRaw
  * \brief    Class to handle raw video format
+ *
+ * Input files are memory mapped when possible: frames are unpacked
+ * straight from the mapped pages and seeking only moves the frame index.
+ * The kernel is told to read ahead while playing and to stop doing it
+ * after a seek. A file that shrinks while mapped is unmapped and read
+ * as any other. Otherwise frames are read with 64-bit file offsets
+ * (pread when available).
+ *
+ * With USE_IOURING input files are not mapped: the reads of the next
+ * frames are queued on an io_uring shared by every raw stream and are
+ * submitted together, keeping several reads in flight per stream. Each
+ * read submits the reads it queued unless a read batch is open
  */
 class StreamHandlerRaw : public CalypStreamHandlerIf
 {
@@ -38,9 +55,36 @@ class StreamHandlerRaw : public CalypStreamHandlerIf
 
 private:
   FILE* m_pFile; /**< The input file pointer >*/
+#ifdef HAVE_MMAP
+  ClpByte* m_pMappedFile;          //!< Mapped input file (NULL if not mapped)
+  unsigned long long m_uiMappedBytes;
+  bool m_bSequential;              //!< Read ahead advice is active
+  unsigned int m_uiSequentialReads;  //!< Consecutive frames read since the last seek
+
+  void adviseAccess( bool bSequential );
+  void unmapFile();
+#endif
+#ifdef USE_IOURING
+  bool m_bUseRing;                  //!< Input is read through io_uring
+  StreamHandlerRawQueue* m_pcQueue;  //!< Frames being read ahead
+#endif
 
 public:
-  StreamHandlerRaw() { m_pchHandlerName = "RawVideo"; }
+  StreamHandlerRaw()
+      : m_pFile( NULL )
+#ifdef HAVE_MMAP
+      , m_pMappedFile( NULL )
+      , m_uiMappedBytes( 0 )
+      , m_bSequential( true )
+      , m_uiSequentialReads( 0 )
+#endif
+#ifdef USE_IOURING
+      , m_bUseRing( false )
+      , m_pcQueue( NULL )
+#endif
+  {
+    m_pchHandlerName = "RawVideo";
+  }
   ~StreamHandlerRaw() {}
   bool openHandler( ClpString strFilename, bool bInput );
   void closeHandler();
@@ -49,6 +93,13 @@ public:
   bool seek( unsigned long long int iFrameNum );
   bool read( CalypFrame* pcFrame );
   bool write( CalypFrame* pcFrame );
+
+  /**
+   * The reads ahead queued by the raw streams until endReadBatch() are
+   * submitted in one system call (batches nest; nothing without USE_IOURING)
+   */
+  static void beginReadBatch();
+  static void endReadBatch();
 };
 
 #endif  // __STREAMHANDLERRAW_H__
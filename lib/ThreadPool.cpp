@@ -0,0 +1,130 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     ThreadPool.cpp
+ * \brief    Worker pool used to split frame processing in bands
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+static thread_local bool s_bIsPoolWorker = false;
+
+CalypThreadPool* CalypThreadPool::global()
+{
+  static CalypThreadPool pool( std::thread::hardware_concurrency() );
+  return &pool;
+}
+
+CalypThreadPool::CalypThreadPool( unsigned int numberThreads )
+    : m_bStop( false )
+    , m_uiGeneration( 0 )
+    , m_uiPendingWorkers( 0 )
+    , m_pcJob( NULL )
+    , m_uiCount( 0 )
+    , m_uiBandSize( 1 )
+    , m_uiNextBand( 0 )
+{
+  for( unsigned int i = 1; i < numberThreads; i++ )
+  {
+    m_apcWorkers.push_back( std::thread( &CalypThreadPool::workerLoop, this ) );
+  }
+}
+
+CalypThreadPool::~CalypThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock( m_cMutex );
+    m_bStop = true;
+  }
+  m_cWakeCond.notify_all();
+  for( unsigned int i = 0; i < m_apcWorkers.size(); i++ )
+  {
+    m_apcWorkers[i].join();
+  }
+}
+
+void CalypThreadPool::runBands()
+{
+  unsigned int band;
+  while( ( band = m_uiNextBand++ ) * m_uiBandSize < m_uiCount )
+  {
+    unsigned int begin = band * m_uiBandSize;
+    unsigned int end = std::min( begin + m_uiBandSize, m_uiCount );
+    ( *m_pcJob )( begin, end );
+  }
+}
+
+void CalypThreadPool::workerLoop()
+{
+  s_bIsPoolWorker = true;
+  unsigned long lastGeneration = 0;
+  while( true )
+  {
+    {
+      std::unique_lock<std::mutex> lock( m_cMutex );
+      m_cWakeCond.wait( lock, [&] { return m_bStop || m_uiGeneration != lastGeneration; } );
+      if( m_bStop )
+        return;
+      lastGeneration = m_uiGeneration;
+    }
+    runBands();
+    {
+      std::lock_guard<std::mutex> lock( m_cMutex );
+      m_uiPendingWorkers--;
+    }
+    m_cDoneCond.notify_one();
+  }
+}
+
+void CalypThreadPool::parallelFor( unsigned int count, unsigned int minBand, const BandFunction& fn )
+{
+  if( count == 0 )
+    return;
+  if( minBand == 0 )
+    minBand = 1;
+
+  std::unique_lock<std::mutex> jobLock( m_cJobMutex, std::defer_lock );
+  if( m_apcWorkers.empty() || count <= minBand || s_bIsPoolWorker || !jobLock.try_lock() )
+  {
+    fn( 0, count );
+    return;
+  }
+
+  // A few bands per thread to balance uneven rows
+  unsigned int bandSize = ( count + 4 * numberThreads() - 1 ) / ( 4 * numberThreads() );
+  {
+    std::lock_guard<std::mutex> lock( m_cMutex );
+    m_pcJob = &fn;
+    m_uiCount = count;
+    m_uiBandSize = std::max( bandSize, minBand );
+    m_uiNextBand = 0;
+    m_uiPendingWorkers = m_apcWorkers.size();
+    m_uiGeneration++;
+  }
+  m_cWakeCond.notify_all();
+
+  runBands();
+
+  std::unique_lock<std::mutex> lock( m_cMutex );
+  m_cDoneCond.wait( lock, [&] { return m_uiPendingWorkers == 0; } );
+  m_pcJob = NULL;
+}
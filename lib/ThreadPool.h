@@ -0,0 +1,88 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     ThreadPool.h
+ * \ingroup  CalypLibGrp
+ * \brief    Worker pool used to split frame processing in bands
+ */
+
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \class    CalypThreadPool
+ * \ingroup  CalypLibGrp
+ * \brief    Fixed size pool of workers shared by the frame kernels
+ *
+ * Only one job runs at a time. Calls issued while the pool is busy, or
+ * from inside a worker, run on the calling thread instead of waiting.
+ */
+class CalypThreadPool
+{
+public:
+  typedef std::function<void( unsigned int, unsigned int )> BandFunction;
+
+  /**
+   * Get the pool shared by the library
+   * (one worker per hardware thread, including the caller)
+   */
+  static CalypThreadPool* global();
+
+  CalypThreadPool( unsigned int numberThreads );
+  ~CalypThreadPool();
+
+  /**
+   * Number of threads that run a job, including the caller
+   */
+  unsigned int numberThreads() const { return m_apcWorkers.size() + 1; }
+
+  /**
+   * Split [0, count) in bands of at least minBand items and run fn( begin, end )
+   * for each band. The function returns when every band is processed
+   */
+  void parallelFor( unsigned int count, unsigned int minBand, const BandFunction& fn );
+
+private:
+  void workerLoop();
+  void runBands();
+
+  std::vector<std::thread> m_apcWorkers;
+  std::mutex m_cJobMutex;  //!< Held by the caller while a job is running
+  std::mutex m_cMutex;
+  std::condition_variable m_cWakeCond;
+  std::condition_variable m_cDoneCond;
+  bool m_bStop;
+  unsigned long m_uiGeneration;
+  unsigned int m_uiPendingWorkers;
+
+  const BandFunction* m_pcJob;
+  unsigned int m_uiCount;
+  unsigned int m_uiBandSize;
+  std::atomic<unsigned int> m_uiNextBand;
+};
+
+#endif  // __THREADPOOL_H__
@@ -37,7 +37,7 @@ AbsoluteFrameDifference::AbsoluteFrameDifference()
   m_pchModuleTooltip = "Measure the absolute difference "  // Description
                        "between two images (Y plane), e. g., abs( Y1 - Y2 )";
   m_uiNumberOfFrames = 2;                                   // Number of frames required
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW;  // Module requirements
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_USES_STRIDE;  // Module requirements
                                                             // (check
                                                             // CalypModulesIf.h).
   // Several requirements should be "or" between each others.
@@ -61,20 +61,15 @@ bool AbsoluteFrameDifference::create( std::vector<CalypFrame*> apcFrameList )
 
 CalypFrame* AbsoluteFrameDifference::process( std::vector<CalypFrame*> apcFrameList )
 {
-  CalypFrame* Input1 = apcFrameList[0];
-  CalypFrame* Input2 = apcFrameList[1];
-  ClpPel* pInput1PelYUV = Input1->getPelBufferYUV()[0][0];
-  ClpPel* pInput2PelYUV = Input2->getPelBufferYUV()[0][0];
-  ClpPel* pOutputPelYUV = m_pcFrameDifference->getPelBufferYUV()[0][0];
-  int aux_pel_1, aux_pel_2;
-
+  const CalypFrame* Input1 = apcFrameList[0];
+  const CalypFrame* Input2 = apcFrameList[1];
+  ClpPel** ppInput1Pel = Input1->getPelBufferYUV()[0];
+  ClpPel** ppInput2Pel = Input2->getPelBufferYUV()[0];
+  ClpPel** ppOutputPel = m_pcFrameDifference->getPelBufferYUV()[0];
   for( unsigned int y = 0; y < m_pcFrameDifference->getHeight(); y++ )
-    for( unsigned int x = 0; x < m_pcFrameDifference->getWidth(); x++ )
-    {
-      aux_pel_1 = *pInput1PelYUV++;
-      aux_pel_2 = *pInput2PelYUV++;
-      *pOutputPelYUV++ = abs( aux_pel_1 - aux_pel_2 );
-    }
+  {
+    CalypFrame::computeAbsDiff( ppInput1Pel[y], ppInput2Pel[y], ppOutputPel[y], m_pcFrameDifference->getWidth() );
+  }
   return m_pcFrameDifference;
 }
 
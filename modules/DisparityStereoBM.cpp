@@ -36,7 +36,7 @@ DisparityStereoBM::DisparityStereoBM()
   m_pchModuleTooltip = "Measure the disparity between two images using the "
                        "Stereo BM method (OpenCV)";
   m_uiNumberOfFrames = 2;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_SKIP_WHILE_PLAY | CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_SKIP_WHILE_PLAY | CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_STRIDE;
 
   m_cModuleOptions.addOptions() /**/
       ( "block_size", m_uiBlockSize, "Block Size (positive odd number) [9]" );
@@ -48,6 +48,12 @@ DisparityStereoBM::DisparityStereoBM()
 bool DisparityStereoBM::create( std::vector<CalypFrame*> apcFrameList )
 {
   _BASIC_MODULE_API_2_CHECK_
+
+  // toMat gives CV_16U samples above 8 bits
+  for( unsigned int i = 0; i < apcFrameList.size(); i++ )
+    if( apcFrameList[i]->getBitsPel() > 8 )
+      return false;
+
   m_pcDisparityFrame =
       new CalypFrame( apcFrameList[0]->getWidth(), apcFrameList[0]->getHeight(), CLP_GRAY );
   if( ( m_uiBlockSize % 2 ) == 0 )
@@ -86,7 +92,7 @@ CalypFrame* DisparityStereoBM::process( std::vector<CalypFrame*> apcFrameList )
   CalypFrame* InputRight = apcFrameList[1];
 
   cv::Mat leftImage, rightImage;
-  if( !InputLeft->toMat( leftImage, true ) || !InputRight->toMat( rightImage, true ) )
+  if( !InputLeft->toMat( leftImage, true, true ) || !InputRight->toMat( rightImage, true, true ) )
   {
     return m_pcDisparityFrame;
   }
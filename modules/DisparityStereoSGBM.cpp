@@ -36,7 +36,7 @@ DisparityStereoSGBM::DisparityStereoSGBM()
   m_pchModuleTooltip = "Measure the disparity between two images using the "
                        "Stereo SGBM method (OpenCV)";
   m_uiNumberOfFrames = 2;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_SKIP_WHILE_PLAY | CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_SKIP_WHILE_PLAY | CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_STRIDE;
 
   m_cModuleOptions.addOptions() /**/
       ( "block_size", m_uiBlockSize, "Block Size (positive odd number) [3]" )( "HHAlgorithm", m_bUseHH,
@@ -50,6 +50,12 @@ DisparityStereoSGBM::DisparityStereoSGBM()
 bool DisparityStereoSGBM::create( std::vector<CalypFrame*> apcFrameList )
 {
   _BASIC_MODULE_API_2_CHECK_
+
+  // toMat gives CV_16U samples above 8 bits
+  for( unsigned int i = 0; i < apcFrameList.size(); i++ )
+    if( apcFrameList[i]->getBitsPel() > 8 )
+      return false;
+
   m_pcDisparityFrame =
       new CalypFrame( apcFrameList[0]->getWidth(), apcFrameList[0]->getHeight(), CLP_GRAY );
   if( ( m_uiBlockSize % 2 ) == 0 )
@@ -94,7 +100,7 @@ CalypFrame* DisparityStereoSGBM::process( std::vector<CalypFrame*> apcFrameList
   CalypFrame* InputLeft = apcFrameList[0];
   CalypFrame* InputRight = apcFrameList[1];
   cv::Mat leftImage, rightImage;
-  if( !InputLeft->toMat( leftImage, true ) || !InputRight->toMat( rightImage, true ) )
+  if( !InputLeft->toMat( leftImage, true, true ) || !InputRight->toMat( rightImage, true, true ) )
   {
     return m_pcDisparityFrame;
   }
@@ -34,7 +34,7 @@ EightBitsSampling::EightBitsSampling()
   m_pchModuleLongName = "8 bit sub-sampling";
   m_pchModuleTooltip = "Sub-sampling frame to 8bpp";
   m_uiNumberOfFrames = 1;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NOTHING;
+  m_uiModuleRequirements = CLP_MODULE_USES_STRIDE;
 
   m_pcSubSampledFrame = NULL;
 }
@@ -53,23 +53,25 @@ bool EightBitsSampling::create( std::vector<CalypFrame*> apcFrameList )
 
 CalypFrame* EightBitsSampling::process( std::vector<CalypFrame*> apcFrameList )
 {
-  CalypFrame* pcFrame = apcFrameList[0];
+  const CalypFrame* pcFrame = apcFrameList[0];
   unsigned int uiShiftBits = pcFrame->getBitsPel() - 8;
-  ClpPel* pPelInput = pcFrame->getPelBufferYUV()[0][0];
-  ClpPel* pPelSubSampled = m_pcSubSampledFrame->getPelBufferYUV()[0][0];
   ClpPel pelValue;
 
-  for( unsigned int i = 0; i < pcFrame->getHeight() * pcFrame->getWidth(); i++ )
+  ClpPel*** pppInputPel = pcFrame->getPelBufferYUV();
+  ClpPel*** pppSubSampledPel = m_pcSubSampledFrame->getPelBufferYUV();
+  for( unsigned int ch = 0; ch < pcFrame->getNumberChannels(); ch++ )
   {
-    pelValue = *pPelInput++;
-    pelValue = pelValue >> uiShiftBits;
-    *pPelSubSampled++ = pelValue;
-  }
-  for( unsigned int i = 0; i < pcFrame->getChromaLength() * 2; i++ )
-  {
-    pelValue = *pPelInput++;
-    pelValue = pelValue >> uiShiftBits;
-    *pPelSubSampled++ = pelValue;
+    for( unsigned int y = 0; y < pcFrame->getHeight( ch ); y++ )
+    {
+      ClpPel* pPelInput = pppInputPel[ch][y];
+      ClpPel* pPelSubSampled = pppSubSampledPel[ch][y];
+      for( unsigned int x = 0; x < pcFrame->getWidth( ch ); x++ )
+      {
+        pelValue = *pPelInput++;
+        pelValue = pelValue >> uiShiftBits;
+        *pPelSubSampled++ = pelValue;
+      }
+    }
   }
   return m_pcSubSampledFrame;
 }
@@ -32,7 +32,7 @@ FilterComponentModule::FilterComponentModule()
   m_iModuleAPI = CLP_MODULE_API_2;
   m_iModuleType = CLP_FRAME_PROCESSING_MODULE;
   m_uiNumberOfFrames = 1;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NOTHING;
+  m_uiModuleRequirements = CLP_MODULE_USES_STRIDE;
   m_pchModuleCategory = "Filtering";
 
   m_pcFilteredFrame = NULL;
@@ -48,9 +48,11 @@ bool FilterComponentModule::createFilter( unsigned int uiWidth, unsigned int uiH
 CalypFrame* FilterComponentModule::filterComponent( CalypFrame* InputFrame, int Component )
 {
   ClpPel*** pppOutputPelYUV = m_pcFilteredFrame->getPelBufferYUV();
-  ClpPel*** pppInputPelYUV = InputFrame->getPelBufferYUV();
-  memcpy( pppOutputPelYUV[CLP_LUMA][0], pppInputPelYUV[Component][0],
-          m_pcFilteredFrame->getWidth() * m_pcFilteredFrame->getHeight() * sizeof( ClpPel ) );
+  ClpPel*** pppInputPelYUV = static_cast<const CalypFrame*>( InputFrame )->getPelBufferYUV();
+  for( unsigned int y = 0; y < m_pcFilteredFrame->getHeight(); y++ )
+  {
+    memcpy( pppOutputPelYUV[CLP_LUMA][y], pppInputPelYUV[Component][y], m_pcFilteredFrame->getWidth() * sizeof( ClpPel ) );
+  }
   return m_pcFilteredFrame;
 }
 
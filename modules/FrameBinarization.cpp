@@ -33,7 +33,7 @@ FrameBinarization::FrameBinarization()
   m_pchModuleName = "FrameBinarization";
   m_pchModuleTooltip = "Binarize frame";
   m_uiNumberOfFrames = 1;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_STRIDE;
 
   m_cModuleOptions.addOptions() /**/
       ( "threshold", m_uiThreshold, "Threshold level for binarization (0-255) [128]" );
@@ -50,13 +50,17 @@ void FrameBinarization::create( CalypFrame* frame )
 
 CalypFrame* FrameBinarization::process( CalypFrame* frame )
 {
-  ClpPel* pPelInput = frame->getPelBufferYUV()[0][0];
-  ClpPel* pPelBin = m_pcBinFrame->getPelBufferYUV()[0][0];
+  ClpPel** ppInputPel = static_cast<const CalypFrame*>( frame )->getPelBufferYUV()[0];
+  ClpPel** ppBinPel = m_pcBinFrame->getPelBufferYUV()[0];
   for( unsigned int y = 0; y < frame->getHeight(); y++ )
+  {
+    ClpPel* pPelInput = ppInputPel[y];
+    ClpPel* pPelBin = ppBinPel[y];
     for( unsigned int x = 0; x < frame->getWidth(); x++ )
     {
       *pPelBin++ = *pPelInput++ >= m_uiThreshold ? 255 : 0;
     }
+  }
   return m_pcBinFrame;
 }
 
@@ -33,7 +33,7 @@ FrameCrop::FrameCrop()
   m_pchModuleName = "FrameCrop";
   m_pchModuleTooltip = "Crop a region of a frame";
   m_uiNumberOfFrames = 1;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_STRIDE;
 
   m_cModuleOptions.addOptions()                                                                   /**/
       ( "xPosition", m_uiXPosition, "X cordinate of the left-top corner of the crop region [0]" ) /**/
@@ -41,6 +41,7 @@ FrameCrop::FrameCrop()
       ( "width", m_iXSize, "Width of the crop region [-1]" )                                      /**/
       ( "height", m_iYSize, "Height of the crop region [-1]" );
 
+  m_pcInputFrame = NULL;
   m_pcCropedFrame = NULL;
   m_uiXPosition = 0;
   m_uiYPosition = 0;
@@ -54,17 +55,21 @@ void FrameCrop::create( CalypFrame* frame )
   if( m_uiXPosition >= frame->getWidth() )
     m_uiXPosition = 0;
   if( m_uiYPosition >= frame->getHeight() )
-    m_uiXPosition = 0;
+    m_uiYPosition = 0;
   if( m_iXSize == -1 || ( m_uiXPosition + m_iXSize ) >= frame->getWidth() )
     m_iXSize = frame->getWidth() - m_uiXPosition;
   if( m_iYSize == -1 || ( m_uiYPosition + m_iYSize ) >= frame->getHeight() )
     m_iYSize = frame->getHeight() - m_uiYPosition;
-  m_pcCropedFrame = new CalypFrame( m_iXSize, m_iYSize, frame->getPelFormat(), frame->getBitsPel() );
+  m_pcInputFrame = new CalypFrame( frame );
+  m_pcCropedFrame = new CalypFrame( m_pcInputFrame, m_uiXPosition, m_uiYPosition, m_iXSize, m_iYSize, CalypFrame::REGION_VIEW );
 }
 
 CalypFrame* FrameCrop::process( CalypFrame* frame )
 {
-  m_pcCropedFrame->copyFrom( frame, m_uiXPosition, m_uiYPosition );
+  // The cropped frame is a view of our copy of the input, which shares its
+  // samples but stays valid after the input frame is reused or deleted
+  *m_pcInputFrame = *frame;
+  m_pcCropedFrame->setViewSource( m_pcInputFrame, m_uiXPosition, m_uiYPosition );
   return m_pcCropedFrame;
 }
 
@@ -73,4 +78,7 @@ void FrameCrop::destroy()
   if( m_pcCropedFrame )
     delete m_pcCropedFrame;
   m_pcCropedFrame = NULL;
+  if( m_pcInputFrame )
+    delete m_pcInputFrame;
+  m_pcInputFrame = NULL;
 }
@@ -33,6 +33,7 @@ class FrameCrop : public CalypModuleIf
   REGISTER_CLASS_FACTORY( FrameCrop )
 
 private:
+  CalypFrame* m_pcInputFrame;  //!< Copy of the input (copy-on-write) the cropped frame is a view of
   CalypFrame* m_pcCropedFrame;
   unsigned int m_uiXPosition;
   unsigned int m_uiYPosition;
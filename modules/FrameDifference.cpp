@@ -34,7 +34,7 @@ FrameDifference::FrameDifference()
   m_pchModuleName = "Difference";
   m_pchModuleTooltip = "Measure the difference between two images (Y plane),  "
                        "Y1 - Y2, with max absolute diff of 128";
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_STRIDE;
   m_uiNumberOfFrames = 2;
 
   m_cModuleOptions.addOptions() /**/
@@ -76,13 +76,19 @@ bool FrameDifference::create( std::vector<CalypFrame*> apcFrameList )
 
 CalypFrame* FrameDifference::process( std::vector<CalypFrame*> apcFrameList )
 {
-  ClpPel* pInput1PelYUV = apcFrameList[0]->getPelBufferYUV()[0][0];
-  ClpPel* pInput2PelYUV = apcFrameList[1]->getPelBufferYUV()[0][0];
-  ClpPel* pOutputPelYUV = m_pcFrameDifference->getPelBufferYUV()[0][0];
   int aux_pel_1, aux_pel_2;
   int diff = 0;
 
+  const CalypFrame* pcInput1 = apcFrameList[0];
+  const CalypFrame* pcInput2 = apcFrameList[1];
+  ClpPel** ppInput1Pel = pcInput1->getPelBufferYUV()[0];
+  ClpPel** ppInput2Pel = pcInput2->getPelBufferYUV()[0];
+  ClpPel** ppOutputPel = m_pcFrameDifference->getPelBufferYUV()[0];
   for( unsigned int y = 0; y < m_pcFrameDifference->getHeight(); y++ )
+  {
+    ClpPel* pInput1PelYUV = ppInput1Pel[y];
+    ClpPel* pInput2PelYUV = ppInput2Pel[y];
+    ClpPel* pOutputPelYUV = ppOutputPel[y];
     for( unsigned int x = 0; x < m_pcFrameDifference->getWidth(); x++ )
     {
       aux_pel_1 = *pInput1PelYUV++;
@@ -95,6 +101,7 @@ CalypFrame* FrameDifference::process( std::vector<CalypFrame*> apcFrameList )
       diff += m_iMaxDiffValue;
       *pOutputPelYUV++ = diff;
     }
+  }
   return m_pcFrameDifference;
 }
 
@@ -34,7 +34,7 @@ FrameMask::FrameMask()
   m_pchModuleName = "FrameMask";
   m_pchModuleTooltip = "Applies a mask to the selected image (first image)";
   m_uiNumberOfFrames = 2;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_KEYS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_KEYS | CLP_MODULE_USES_STRIDE;
 
   m_cModuleOptions.addOptions() /**/
       ( "MaskWeigth", m_iWeight, "Influence of the mask [60%]" );
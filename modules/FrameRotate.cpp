@@ -34,7 +34,7 @@ FrameRotate::FrameRotate()
   m_pchModuleName = "FrameRotate";
   m_pchModuleTooltip = "Rotates frame";
   m_uiNumberOfFrames = 1;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_STRIDE;
 
   m_cModuleOptions.addOptions() /**/
       ( "Angle", m_iAngle, "Angle to rotate (0, 90, 180, 270)" );
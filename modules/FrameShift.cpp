@@ -34,7 +34,7 @@ FrameShift::FrameShift()
   m_pchModuleName = "FrameShift";
   m_pchModuleTooltip = "Shift frame horizontal and vertical";
   m_uiNumberOfFrames = 1;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_KEYS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_KEYS | CLP_MODULE_USES_STRIDE;
 
   m_cModuleOptions.addOptions()                                                               /**/
       ( "ShiftHorizontal", m_iShiftHor, "Amount of pixels to shift in horizontal direction" ) /**/
@@ -59,6 +59,10 @@ CalypFrame* FrameShift::process( std::vector<CalypFrame*> apcFrameList )
 
   m_pcProcessedFrame->reset();
 
+  const CalypFrame* pcInput = apcFrameList[0];
+  ClpPel*** pppInputPel = pcInput->getPelBufferYUV();
+  ClpPel*** pppOutputPel = m_pcProcessedFrame->getPelBufferYUV();
+
   for( unsigned int ch = 0; ch < m_pcProcessedFrame->getNumberChannels(); ch++ )
   {
     unsigned int uiWidth = m_pcProcessedFrame->getWidth( ch );
@@ -78,8 +82,8 @@ CalypFrame* FrameShift::process( std::vector<CalypFrame*> apcFrameList )
 
     for( unsigned int y = yStartOut, yIn = yStartIn; y < yEndOut; y++, yIn++ )
     {
-      pPelInput = &( apcFrameList[0]->getPelBufferYUV()[ch][yIn][xStartIn] );
-      pPelOut = &( m_pcProcessedFrame->getPelBufferYUV()[ch][y][xStartOut] );
+      pPelInput = &( pppInputPel[ch][yIn][xStartIn] );
+      pPelOut = &( pppOutputPel[ch][y][xStartOut] );
       for( unsigned int x = xStartOut; x < xEndOut; x++ )
       {
         *pPelOut = *pPelInput;
@@ -26,6 +26,8 @@
 
 #include "lib/LibMemory.h"
 
+#include <vector>
+
 InterFrameVariance::InterFrameVariance()
 {
   /* Module Definition */
@@ -39,7 +41,7 @@ InterFrameVariance::InterFrameVariance()
   m_pchModuleTooltip = "Measure the variance across several frames";
   m_uiNumberOfFrames = 2;  // Number of Frames required (This module
                            // allows a variable number of inputs)
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULES_VARIABLE_NUM_FRAMES;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULES_VARIABLE_NUM_FRAMES | CLP_MODULE_USES_STRIDE;
   // Several requirements should be "or" between each others.
   m_pcFrameVariance = NULL;
 }
@@ -66,15 +68,19 @@ CalypFrame* InterFrameVariance::process( std::vector<CalypFrame*> apcFrameList )
   int numFrames = apcFrameList.size();
 
   ClpPel** pInput = new ClpPel*[numFrames];
-  ClpPel* pOutputPelYUV = m_pcFrameVariance->getPelBufferYUV()[0][0];
-
+  std::vector<ClpPel**> appInputPel( numFrames );
   for( int i = 0; i < numFrames; i++ )
   {
-    pInput[i] = apcFrameList[i]->getPelBufferYUV()[0][0];
+    appInputPel[i] = static_cast<const CalypFrame*>( apcFrameList[i] )->getPelBufferYUV()[0];
   }
 
   double maxVariance = 0;
   for( unsigned int y = 0; y < m_pcFrameVariance->getHeight(); y++ )
+  {
+    for( int i = 0; i < numFrames; i++ )
+    {
+      pInput[i] = appInputPel[i][y];
+    }
     for( unsigned int x = 0; x < m_pcFrameVariance->getWidth(); x++ )
     {
       int sum = 0;
@@ -93,12 +99,17 @@ CalypFrame* InterFrameVariance::process( std::vector<CalypFrame*> apcFrameList )
       if( m_pVariance[y][x] > maxVariance )
         maxVariance = m_pVariance[y][x];
     }
+  }
 
+  ClpPel** ppOutputPel = m_pcFrameVariance->getPelBufferYUV()[0];
   for( unsigned int y = 0; y < m_pcFrameVariance->getHeight(); y++ )
+  {
+    ClpPel* pOutputPelYUV = ppOutputPel[y];
     for( unsigned int x = 0; x < m_pcFrameVariance->getWidth(); x++ )
     {
       *pOutputPelYUV++ = m_pVariance[y][x] * 255 / maxVariance;
     }
+  }
   delete[] pInput;
   return m_pcFrameVariance;
 }
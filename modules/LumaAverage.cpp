@@ -37,7 +37,7 @@ LumaAverage::LumaAverage()
   m_uiNumberOfFrames = 1;                                        // Number of Frames required
                                                                  // (ONE_FRAME, TWO_FRAMES,
                                                                  // THREE_FRAMES)
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NOTHING;          // Module requirements
+  m_uiModuleRequirements = CLP_MODULE_USES_STRIDE;          // Module requirements
                                                                  // (check
                                                                  // CalypModulesIf.h).
   // Several requirements should be "or" between each others.
@@ -48,13 +48,16 @@ void LumaAverage::create( CalypFrame* frame ) {}
 double LumaAverage::measure( CalypFrame* frame )
 {
   double average = 0;
-  ClpPel* pPel = frame->getPelBufferYUV()[0][0];
+  ClpPel** ppPel = static_cast<const CalypFrame*>( frame )->getPelBufferYUV()[0];
   for( unsigned int y = 0; y < frame->getHeight(); y++ )
+  {
+    ClpPel* pPel = ppPel[y];
     for( unsigned int x = 0; x < frame->getWidth(); x++ )
     {
       average += *pPel;
       pPel++;
     }
+  }
   return average / double( frame->getHeight() * frame->getWidth() );
 }
 
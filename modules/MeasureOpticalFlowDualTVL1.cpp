@@ -41,7 +41,7 @@ MeasureOpticalFlowDualTVL1::MeasureOpticalFlowDualTVL1()
   m_pchModuleLongName = "Optical flow based on DualTVL1";
   m_pchModuleTooltip = "Measure optical flow";
   m_uiNumberOfFrames = 2;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_SKIP_WHILE_PLAY | CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_SKIP_WHILE_PLAY | CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_STRIDE;
 
   m_cModuleOptions.addOptions() /**/
       ( "Show reconstruction", m_bShowReconstruction, "Show reconstructed frame instead of MVs [false]" );
@@ -59,6 +59,8 @@ bool MeasureOpticalFlowDualTVL1::create( std::vector<CalypFrame*> apcFrameList )
                                                             CalypFrame::MATCH_RESOLUTION |
                                                             CalypFrame::MATCH_BITS ) )
       return false;
+  if( apcFrameList[0]->getBitsPel() > 8 )
+    return false;
 
   m_iStep = 16;
   m_cTvl1 = cv::createOptFlow_DualTVL1();
@@ -107,13 +109,15 @@ void MeasureOpticalFlowDualTVL1::drawFlow()
 
 void MeasureOpticalFlowDualTVL1::compensateFlow()
 {
+  const CalypFrame* pcFramePrev = m_pcFramePrev;
+  ClpPel*** pppPrevPel = pcFramePrev->getPelBufferYUV();
+  ClpPel*** pppOutputPel = m_pcOutputFrame->getPelBufferYUV();
   for( unsigned int c = 0; c < m_pcOutputFrame->getNumberChannels(); c++ )
   {
-    ClpPel** pPelPrev = m_pcFramePrev->getPelBufferYUV()[c];
-    ClpPel* pPelOut = m_pcOutputFrame->getPelBufferYUV()[c][0];
-
+    ClpPel** pPelPrev = pppPrevPel[c];
     for( unsigned int y = 0; y < m_pcOutputFrame->getHeight( c ); y++ )
     {
+      ClpPel* pPelOut = pppOutputPel[c][y];
       for( unsigned int x = 0; x < m_pcOutputFrame->getWidth( c ); x++ )
       {
         Point2f u = m_cvFlow( y, x );
@@ -131,7 +135,7 @@ CalypFrame* MeasureOpticalFlowDualTVL1::process( std::vector<CalypFrame*> apcFra
   m_pcFramePrev = apcFrameList[1];
 
   Mat cvMatPrev, cvMatAfter;
-  if( !m_pcFramePrev->toMat( cvMatPrev, true ) || !m_pcFrameAfter->toMat( cvMatAfter, true ) )
+  if( !m_pcFramePrev->toMat( cvMatPrev, true, true ) || !m_pcFrameAfter->toMat( cvMatAfter, true, true ) )
   {
     return m_pcOutputFrame;
   }
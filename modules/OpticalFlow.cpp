@@ -41,7 +41,7 @@ OpticalFlowModule::OpticalFlowModule()
   m_iModuleType = CLP_FRAME_PROCESSING_MODULE;
   m_pchModuleCategory = "OpticalFlow";
   m_uiNumberOfFrames = 2;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_SKIP_WHILE_PLAY | CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_SKIP_WHILE_PLAY | CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_STRIDE;
 
   m_cModuleOptions.addOptions() /**/
       ( "Show reconstruction", m_bShowReconstruction, "Show reconstructed frame instead of MVs [false]" );
@@ -59,6 +59,8 @@ bool OpticalFlowModule::commonCreate( std::vector<CalypFrame*> apcFrameList )
                                                             CalypFrame::MATCH_RESOLUTION |
                                                             CalypFrame::MATCH_BITS ) )
       return false;
+  if( apcFrameList[0]->getBitsPel() > 8 )
+    return false;
 
   m_iStep = 16;
   m_pcOutputFrame = new CalypFrame( apcFrameList[0]->getWidth(), apcFrameList[0]->getHeight(), CLP_GRAY );
@@ -106,13 +108,15 @@ void OpticalFlowModule::drawFlow()
 
 void OpticalFlowModule::compensateFlow()
 {
+  const CalypFrame* pcFramePrev = m_pcFramePrev;
+  ClpPel*** pppPrevPel = pcFramePrev->getPelBufferYUV();
+  ClpPel*** pppOutputPel = m_pcOutputFrame->getPelBufferYUV();
   for( unsigned int c = 0; c < m_pcOutputFrame->getNumberChannels(); c++ )
   {
-    ClpPel** pPelPrev = m_pcFramePrev->getPelBufferYUV()[c];
-    ClpPel* pPelOut = m_pcOutputFrame->getPelBufferYUV()[c][0];
-
+    ClpPel** pPelPrev = pppPrevPel[c];
     for( unsigned int y = 0; y < m_pcOutputFrame->getHeight( c ); y++ )
     {
+      ClpPel* pPelOut = pppOutputPel[c][y];
       for( unsigned int x = 0; x < m_pcOutputFrame->getWidth( c ); x++ )
       {
         Point2f u = m_cvFlow( y, x );
@@ -130,7 +134,7 @@ CalypFrame* OpticalFlowModule::process( std::vector<CalypFrame*> apcFrameList )
   m_pcFramePrev = apcFrameList[1];
 
   Mat cvMatPrev, cvMatAfter;
-  if( !m_pcFramePrev->toMat( cvMatPrev, true ) || !m_pcFrameAfter->toMat( cvMatAfter, true ) )
+  if( !m_pcFramePrev->toMat( cvMatPrev, true, true ) || !m_pcFrameAfter->toMat( cvMatAfter, true, true ) )
   {
     return m_pcOutputFrame;
   }
@@ -39,7 +39,7 @@ SaliencyDetectionModule::SaliencyDetectionModule()
   m_iModuleType = CLP_FRAME_PROCESSING_MODULE;
   m_pchModuleCategory = "Saliency";
   m_uiNumberOfFrames = 1;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NEW_WINDOW | CLP_MODULE_USES_STRIDE;
 
   m_pcSaliencyFrame = NULL;
 }
@@ -48,6 +48,10 @@ bool SaliencyDetectionModule::commonCreate( std::vector<CalypFrame*> apcFrameLis
 {
   _BASIC_MODULE_API_2_CHECK_
 
+  // toMat gives CV_16U samples above 8 bits
+  if( apcFrameList[0]->getBitsPel() > 8 )
+    return false;
+
   m_pcSaliencyFrame = new CalypFrame( apcFrameList[0]->getWidth(), apcFrameList[0]->getHeight(), CLP_GRAY );
 
   return true;
@@ -56,7 +60,7 @@ bool SaliencyDetectionModule::commonCreate( std::vector<CalypFrame*> apcFrameLis
 bool SaliencyDetectionModule::commonProcess( std::vector<CalypFrame*> apcFrameList )
 {
   Mat cvFrame;
-  if( !apcFrameList[0]->toMat( cvFrame, true ) )
+  if( !apcFrameList[0]->toMat( cvFrame, true, true ) )
   {
     return m_pcSaliencyFrame;
   }
@@ -24,6 +24,8 @@
 
 #include "SetChromaHalfScale.h"
 
+#include <cstring>
+
 SetChromaHalfScale::SetChromaHalfScale()
 {
   /* Module Definition */
@@ -33,7 +35,7 @@ SetChromaHalfScale::SetChromaHalfScale()
   m_pchModuleLongName = "Half scale chroma";
   m_pchModuleTooltip = "Copy frame only keeping luma component";
   m_uiNumberOfFrames = 1;
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_NOTHING;
+  m_uiModuleRequirements = CLP_MODULE_USES_STRIDE;
 
   m_pcProcessedFrame = NULL;
 }
@@ -47,17 +49,23 @@ void SetChromaHalfScale::create( CalypFrame* frame )
 
 CalypFrame* SetChromaHalfScale::process( CalypFrame* frame )
 {
-  ClpPel* pPelInput = frame->getPelBufferYUV()[CLP_LUMA][0];
-  ClpPel* pPelOut = m_pcProcessedFrame->getPelBufferYUV()[0][0];
   ClpPel halfScaleValue = 1 << ( frame->getBitsPel() - 1 );
-  for( unsigned int i = 0; i < frame->getHeight() * frame->getWidth(); i++ )
+  ClpPel*** pppInputPel = static_cast<const CalypFrame*>( frame )->getPelBufferYUV();
+  ClpPel*** pppOutputPel = m_pcProcessedFrame->getPelBufferYUV();
+  for( unsigned int y = 0; y < frame->getHeight(); y++ )
   {
-    *pPelOut++ = *pPelInput++;
+    memcpy( pppOutputPel[CLP_LUMA][y], pppInputPel[CLP_LUMA][y], frame->getWidth() * sizeof( ClpPel ) );
   }
-  pPelInput = frame->getPelBufferYUV()[CLP_CHROMA_U][0];
-  for( unsigned int i = 0; i < m_pcProcessedFrame->getChromaLength() * 2; i++ )
+  for( unsigned int ch = 1; ch < m_pcProcessedFrame->getNumberChannels(); ch++ )
   {
-    *pPelOut++ = halfScaleValue;
+    for( unsigned int y = 0; y < m_pcProcessedFrame->getHeight( ch ); y++ )
+    {
+      ClpPel* pPelOut = pppOutputPel[ch][y];
+      for( unsigned int x = 0; x < m_pcProcessedFrame->getWidth( ch ); x++ )
+      {
+        *pPelOut++ = halfScaleValue;
+      }
+    }
   }
   return m_pcProcessedFrame;
 }
@@ -25,6 +25,7 @@
 #include "WeightedPSNR.h"
 
 #include <cmath>
+#include <vector>
 
 WeightedPSNR::WeightedPSNR()
 {
@@ -35,7 +36,7 @@ WeightedPSNR::WeightedPSNR()
   m_pchModuleName = "WeightedPSNR";
   m_pchModuleLongName = "Weighted PSNR";
   m_pchModuleTooltip = "Measure the weighted PSNR between two images";
-  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS;
+  m_uiModuleRequirements = CLP_MODULE_REQUIRES_OPTIONS | CLP_MODULE_USES_STRIDE;
   m_uiNumberOfFrames = 3;
 
   m_cModuleOptions.addOptions() /**/
@@ -65,35 +66,36 @@ bool WeightedPSNR::create( std::vector<CalypFrame*> apcFrameList )
   return true;
 }
 
-double measureWMSE( int component, CalypFrame* Org, CalypFrame* Rec, CalypFrame* Mask )
+double measureWMSE( int component, const CalypFrame* Org, const CalypFrame* Rec, const CalypFrame* Mask )
 {
-  ClpPel* pMaskPelYUV = Mask->getPelBufferYUV()[0][0];
-  ClpPel* pRecPelYUV = Rec->getPelBufferYUV()[component][0];
-  ClpPel* pOrgPelYUV = Org->getPelBufferYUV()[component][0];
+  ClpPel** ppMaskPelYUV = Mask->getPelBufferYUV()[0];
+  ClpPel** ppRecPelYUV = Rec->getPelBufferYUV()[component];
+  ClpPel** ppOrgPelYUV = Org->getPelBufferYUV()[component];
 
-  double aux_pel_1, aux_pel_2, aux_pel_mask;
-  int diff = 0;
-  double ssd = 0;
-  unsigned int count = 0;
+  unsigned int uiWidth = Rec->getWidth( component );
+  unsigned int uiMaskWidth = Mask->getWidth();
+  // Sample i of the component (in raster order) is weighted by sample i of
+  // the mask, so the rows of a chroma component take the mask samples
+  // across its rows
+  std::vector<ClpPel> aMaskRow( uiWidth == uiMaskWidth ? 0 : uiWidth );
 
-  unsigned int numberOfPixels = 0;
-  if( component == CLP_LUMA )
-  {
-    numberOfPixels = Org->getHeight() * Org->getWidth();
-  }
-  else
-  {
-    numberOfPixels = Rec->getChromaLength();
-  }
-
-  for( unsigned int i = 0; i < numberOfPixels; i++ )
+  unsigned long long count = 0;
+  double ssd = 0;
+  for( unsigned int y = 0; y < Rec->getHeight( component ); y++ )
   {
-    aux_pel_mask = *pMaskPelYUV++;
-    aux_pel_1 = *pRecPelYUV++;
-    aux_pel_2 = *pOrgPelYUV++;
-    diff = aux_pel_1 - aux_pel_2;
-    ssd += ( aux_pel_mask * diff * diff );
-    count += aux_pel_mask;
+    const ClpPel* pMask = ppMaskPelYUV[y];
+    if( !aMaskRow.empty() )
+    {
+      for( unsigned int x = 0; x < uiWidth; x++ )
+      {
+        unsigned long i = (unsigned long)y * uiWidth + x;
+        aMaskRow[x] = ppMaskPelYUV[i / uiMaskWidth][i % uiMaskWidth];
+      }
+      pMask = aMaskRow.data();
+    }
+    unsigned long long rowCount = 0;
+    ssd += CalypFrame::computeWeightedSSD( ppRecPelYUV[y], ppOrgPelYUV[y], pMask, uiWidth, rowCount );
+    count += rowCount;
   }
   if( ssd == 0.0 )
   {
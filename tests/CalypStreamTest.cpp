@@ -0,0 +1,341 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypStreamTest.cpp
+ * \brief    Reading raw streams
+ */
+
+#include "lib/CalypFrame.h"
+#include "lib/CalypStream.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#define TEST_WIDTH 64
+#define TEST_HEIGHT 32
+#define TEST_FRAMES 24
+
+static ClpPel sampleValue( unsigned int frame, unsigned int ch, unsigned int x, unsigned int y )
+{
+  return ( frame * 11 + ch * 31 + y * 7 + x ) & 0xff;
+}
+
+/**
+ * Write a YUV 4:2:0 8 bits file whose samples tell their frame number
+ */
+static std::string createRawFile( const char* name, unsigned int base = 0 )
+{
+  std::string filename = ::testing::TempDir() + name;
+  FILE* pFile = fopen( filename.c_str(), "wb" );
+  if( !pFile )
+    return filename;
+  for( unsigned int f = 0; f < TEST_FRAMES; f++ )
+    for( unsigned int ch = 0; ch < 3; ch++ )
+    {
+      unsigned int uiWidth = ch > 0 ? TEST_WIDTH / 2 : TEST_WIDTH;
+      unsigned int uiHeight = ch > 0 ? TEST_HEIGHT / 2 : TEST_HEIGHT;
+      for( unsigned int y = 0; y < uiHeight; y++ )
+        for( unsigned int x = 0; x < uiWidth; x++ )
+          fputc( sampleValue( base + f, ch, x, y ), pFile );
+    }
+  fclose( pFile );
+  return filename;
+}
+
+static bool openRawFile( CalypStream& stream, const std::string& filename )
+{
+  return stream.open( filename, "64x32", "YUV420p", 8, 0, 1, true );
+}
+
+static void expectFrame( CalypFrame* pcFrame, unsigned int frame )
+{
+  ASSERT_NE( pcFrame, nullptr );
+  ClpPel*** pppPel = pcFrame->getPelBufferYUV();
+  for( unsigned int ch = 0; ch < pcFrame->getNumberChannels(); ch++ )
+    for( unsigned int y = 0; y < pcFrame->getHeight( ch ); y++ )
+      for( unsigned int x = 0; x < pcFrame->getWidth( ch ); x++ )
+        ASSERT_EQ( pppPel[ch][y][x], sampleValue( frame, ch, x, y ) ) << "frame " << frame << " ch " << ch << " x " << x << " y " << y;
+}
+
+TEST( CalypStreamTest, BatchedLockstepRead )
+{
+  std::string fileA = createRawFile( "calyp_batch_a.yuv" );
+  std::string fileB = createRawFile( "calyp_batch_b.yuv", 100 );
+  for( unsigned int uiReadAhead = 0; uiReadAhead <= 4; uiReadAhead += 4 )
+  {
+    CalypStream cStreamA, cStreamB;
+    cStreamA.setReadAhead( uiReadAhead );
+    cStreamB.setReadAhead( uiReadAhead );
+    ASSERT_TRUE( openRawFile( cStreamA, fileA ) );
+    ASSERT_TRUE( openRawFile( cStreamB, fileB ) );
+    for( unsigned int f = 0; f < TEST_FRAMES; f++ )
+    {
+      expectFrame( cStreamA.getCurrFrame(), f );
+      expectFrame( cStreamB.getCurrFrame(), 100 + f );
+      CalypStream::beginReadBatch();
+      bool bEndA = cStreamA.setNextFrame();
+      bool bEndB = cStreamB.setNextFrame();
+      if( !bEndA )
+        cStreamA.readNextFrame();
+      if( !bEndB )
+        cStreamB.readNextFrame();
+      CalypStream::endReadBatch();
+      EXPECT_EQ( bEndA, f + 1 == TEST_FRAMES );
+      EXPECT_EQ( bEndB, f + 1 == TEST_FRAMES );
+    }
+  }
+  remove( fileA.c_str() );
+  remove( fileB.c_str() );
+}
+
+/**
+ * Read a whole stream with setNextFrame/readNextFrame
+ */
+static void expectSequence( CalypStream& stream, unsigned int first, unsigned int base = 0 )
+{
+  for( unsigned int f = first; f < TEST_FRAMES; f++ )
+  {
+    ASSERT_EQ( stream.getCurrFrameNum(), int( f ) );
+    expectFrame( stream.getCurrFrame(), base + f );
+    if( !stream.setNextFrame() )
+      stream.readNextFrame();
+    else
+      ASSERT_EQ( f + 1, TEST_FRAMES );
+  }
+}
+
+TEST( CalypStreamTest, ReadAheadMatchesSyncRead )
+{
+  std::string filename = createRawFile( "calyp_read_ahead.yuv" );
+  unsigned int auiReadAhead[] = { 0, 1, 4, 8 };
+  for( unsigned int i = 0; i < sizeof( auiReadAhead ) / sizeof( auiReadAhead[0] ); i++ )
+  {
+    CalypStream cStream;
+    cStream.setReadAhead( auiReadAhead[i] );
+    ASSERT_TRUE( openRawFile( cStream, filename ) );
+    EXPECT_EQ( cStream.getReadAhead(), auiReadAhead[i] );
+    expectSequence( cStream, 0 );
+
+    // Seeking restarts the reader from the new frame
+    ASSERT_TRUE( cStream.seekInput( 5 ) );
+    expectSequence( cStream, 5 );
+    ASSERT_TRUE( cStream.seekInput( 2 ) );
+    expectSequence( cStream, 2 );
+  }
+
+  // Changing the ring size of an open stream keeps the position
+  CalypStream cStream;
+  ASSERT_TRUE( openRawFile( cStream, filename ) );
+  ASSERT_TRUE( cStream.seekInput( 7 ) );
+  cStream.setReadAhead( 4 );
+  expectSequence( cStream, 7 );
+  remove( filename.c_str() );
+}
+
+TEST( CalypStreamTest, ReloadDuringReadAhead )
+{
+  std::string filename = createRawFile( "calyp_reload.yuv" );
+  CalypStream cStream;
+  cStream.setReadAhead( 4 );
+  ASSERT_TRUE( openRawFile( cStream, filename ) );
+  for( unsigned int f = 0; f < 3; f++ )
+  {
+    ASSERT_FALSE( cStream.setNextFrame() );
+    cStream.readNextFrame();
+  }
+  expectFrame( cStream.getCurrFrame(), 3 );
+
+  // Replace the file while the reader fills the ring (the old one stays valid while open)
+  std::string newFilename = createRawFile( "calyp_reload_new.yuv", 50 );
+  ASSERT_EQ( rename( newFilename.c_str(), filename.c_str() ), 0 );
+  ASSERT_TRUE( cStream.reload() );
+  expectSequence( cStream, 3, 50 );
+  remove( filename.c_str() );
+}
+
+TEST( CalypStreamTest, CacheHitsOnSeekBack )
+{
+  std::string filename = createRawFile( "calyp_cache.yuv" );
+  std::size_t uiFrameBytes = CalypFrame::getBytesPerFrame( TEST_WIDTH, TEST_HEIGHT, CLP_YUV420P, 8 );
+  CalypStream cStream;
+  cStream.setCacheBudget( 8 * uiFrameBytes );
+  ASSERT_TRUE( openRawFile( cStream, filename ) );
+  for( unsigned int f = 0; f < 6; f++ )
+  {
+    ASSERT_FALSE( cStream.setNextFrame() );
+    cStream.readNextFrame();
+  }
+  expectFrame( cStream.getCurrFrame(), 6 );
+
+  CalypStreamCacheStats sStats = cStream.getCacheStats();
+  ASSERT_TRUE( cStream.seekInput( 3 ) );
+  expectFrame( cStream.getCurrFrame(), 3 );
+  CalypStreamCacheStats sAfterSeek = cStream.getCacheStats();
+  EXPECT_GT( sAfterSeek.ullHits, sStats.ullHits );
+  EXPECT_EQ( sAfterSeek.ullMisses, sStats.ullMisses );
+
+  // Stepping back is served from memory as well
+  ASSERT_TRUE( cStream.seekInputRelative( false ) );
+  expectFrame( cStream.getCurrFrame(), 2 );
+  EXPECT_GT( cStream.getCacheStats().ullHits, sAfterSeek.ullHits );
+  EXPECT_EQ( cStream.getCacheStats().ullMisses, sAfterSeek.ullMisses );
+
+  // A frame never shown is read from the stream
+  sStats = cStream.getCacheStats();
+  ASSERT_TRUE( cStream.seekInput( 20 ) );
+  expectFrame( cStream.getCurrFrame(), 20 );
+  EXPECT_GT( cStream.getCacheStats().ullMisses, sStats.ullMisses );
+  EXPECT_LE( cStream.getCacheStats().uiBytesCached, cStream.getCacheBudget() );
+
+  cStream.resetCacheStats();
+  EXPECT_EQ( cStream.getCacheStats().ullHits, 0u );
+  EXPECT_EQ( cStream.getCacheStats().ullMisses, 0u );
+  EXPECT_EQ( cStream.getCacheStats().ullEvictions, 0u );
+  remove( filename.c_str() );
+}
+
+TEST( CalypStreamTest, CacheStaysWithinBudget )
+{
+  std::string filename = createRawFile( "calyp_cache_budget.yuv" );
+  std::size_t uiFrameBytes = CalypFrame::getBytesPerFrame( TEST_WIDTH, TEST_HEIGHT, CLP_YUV420P, 8 );
+  for( unsigned int uiReadAhead = 0; uiReadAhead <= 4; uiReadAhead += 4 )
+  {
+    CalypStream cStream;
+    cStream.setReadAhead( uiReadAhead );
+    cStream.setCacheBudget( 4 * uiFrameBytes );
+    ASSERT_TRUE( openRawFile( cStream, filename ) );
+    expectSequence( cStream, 0 );
+    CalypStreamCacheStats sStats = cStream.getCacheStats();
+    EXPECT_EQ( sStats.uiFrames, 4u );
+    EXPECT_EQ( sStats.uiBytesCached, 4 * uiFrameBytes );
+    EXPECT_GT( sStats.ullEvictions, 0u );
+
+    // The most recent frames are kept, the first ones were evicted
+    ASSERT_TRUE( cStream.seekInput( TEST_FRAMES - 3 ) );
+    expectFrame( cStream.getCurrFrame(), TEST_FRAMES - 3 );
+    EXPECT_GT( cStream.getCacheStats().ullHits, sStats.ullHits );
+    sStats = cStream.getCacheStats();
+    ASSERT_TRUE( cStream.seekInput( 0 ) );
+    expectFrame( cStream.getCurrFrame(), 0 );
+    EXPECT_GT( cStream.getCacheStats().ullMisses, sStats.ullMisses );
+
+    // Shrinking the budget evicts at once
+    cStream.setCacheBudget( uiFrameBytes );
+    EXPECT_LE( cStream.getCacheStats().uiFrames, 1u );
+    EXPECT_LE( cStream.getCacheStats().uiBytesCached, uiFrameBytes );
+  }
+  remove( filename.c_str() );
+}
+
+/**
+ * Wait for the preloader to fill its window and free the frames outside it
+ */
+static bool waitPreload( CalypStream& stream )
+{
+  for( unsigned int i = 0; i < 1000; i++ )
+  {
+    CalypStreamPreloadStatus sStatus = stream.getPreloadStatus();
+    std::vector<std::pair<unsigned int, unsigned int>> ranges = stream.getPreloadedRanges();
+    unsigned int uiLoaded = 0;
+    for( std::size_t r = 0; r < ranges.size(); r++ )
+      uiLoaded += ranges[r].second - ranges[r].first + 1;
+    if( sStatus.bFailed )
+      return false;
+    if( sStatus.uiLoadedFrames == sStatus.uiWindowFrames && uiLoaded == sStatus.uiWindowFrames )
+      return true;
+    std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+  }
+  return false;
+}
+
+static void expectPreloaded( CalypStream& stream, unsigned int first, unsigned int frames )
+{
+  ASSERT_TRUE( waitPreload( stream ) );
+  CalypStreamPreloadStatus sStatus = stream.getPreloadStatus();
+  EXPECT_EQ( sStatus.uiWindowFirst, first );
+  EXPECT_EQ( sStatus.uiWindowFrames, frames );
+  std::size_t uiFrameBytes = CalypFrame::getBytesPerFrame( TEST_WIDTH, TEST_HEIGHT, CLP_YUV420P, 8 );
+  EXPECT_LE( frames * uiFrameBytes, sStatus.uiBudget );
+  std::vector<std::pair<unsigned int, unsigned int>> ranges = stream.getPreloadedRanges();
+  ASSERT_EQ( ranges.size(), 1u );
+  EXPECT_EQ( ranges[0].first, first );
+  EXPECT_EQ( ranges[0].second, first + frames - 1 );
+}
+
+TEST( CalypStreamTest, PreloadWindowFollowsSeek )
+{
+  std::string filename = createRawFile( "calyp_preload.yuv" );
+  std::size_t uiFrameBytes = CalypFrame::getBytesPerFrame( TEST_WIDTH, TEST_HEIGHT, CLP_YUV420P, 8 );
+  CalypStream cStream;
+  ASSERT_TRUE( openRawFile( cStream, filename ) );
+  EXPECT_EQ( cStream.getPreloadStatus().uiBudget, 0u );
+  EXPECT_TRUE( cStream.getPreloadedRanges().empty() );
+
+  // Eight frames fit, a quarter of them behind the current one
+  std::size_t uiBudget = 8 * uiFrameBytes + uiFrameBytes / 2;
+  cStream.preload( uiBudget );
+  EXPECT_EQ( cStream.getPreloadStatus().uiBudget, uiBudget );
+  expectPreloaded( cStream, 0, 8 );
+
+  ASSERT_TRUE( cStream.seekInput( 12 ) );
+  expectFrame( cStream.getCurrFrame(), 12 );
+  expectPreloaded( cStream, 10, 8 );
+
+  // Near the end the window keeps its size
+  ASSERT_TRUE( cStream.seekInput( TEST_FRAMES - 1 ) );
+  expectFrame( cStream.getCurrFrame(), TEST_FRAMES - 1 );
+  expectPreloaded( cStream, TEST_FRAMES - 8, 8 );
+
+  // Frames come from the window while playing through it
+  ASSERT_TRUE( cStream.seekInput( TEST_FRAMES - 8 ) );
+  expectSequence( cStream, TEST_FRAMES - 8 );
+
+  // Reloading keeps preloading with the same budget
+  ASSERT_TRUE( cStream.seekInput( 12 ) );
+  ASSERT_TRUE( cStream.reload() );
+  EXPECT_EQ( cStream.getPreloadStatus().uiBudget, uiBudget );
+  expectFrame( cStream.getCurrFrame(), 12 );
+  expectPreloaded( cStream, 10, 8 );
+
+  cStream.preload( 0 );
+  EXPECT_EQ( cStream.getPreloadStatus().uiBudget, 0u );
+  EXPECT_TRUE( cStream.getPreloadedRanges().empty() );
+  expectFrame( cStream.getCurrFrame(), 12 );
+  remove( filename.c_str() );
+}
+
+TEST( CalypStreamTest, PreloadAll )
+{
+  std::string filename = createRawFile( "calyp_preload_all.yuv" );
+  CalypStream cStream;
+  cStream.setReadAhead( 4 );
+  ASSERT_TRUE( openRawFile( cStream, filename ) );
+  ASSERT_TRUE( cStream.seekInput( 6 ) );
+  cStream.loadAll();
+  expectPreloaded( cStream, 0, TEST_FRAMES );
+  expectFrame( cStream.getCurrFrame(), 6 );
+  ASSERT_TRUE( cStream.seekInput( 1 ) );
+  expectSequence( cStream, 1 );
+  remove( filename.c_str() );
+}
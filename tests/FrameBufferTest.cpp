@@ -0,0 +1,79 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FrameBufferTest.cpp
+ * \brief    Round trip of frames through file buffers
+ */
+
+#include "lib/CalypFrame.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+static void fillFrame( CalypFrame& frame )
+{
+  ClpPel*** pppPel = frame.getPelBufferYUV();
+  ClpPel maxval = ( 1 << frame.getBitsPel() ) - 1;
+  for( unsigned int ch = 0; ch < frame.getNumberChannels(); ch++ )
+    for( unsigned int y = 0; y < frame.getHeight( ch ); y++ )
+      for( unsigned int x = 0; x < frame.getWidth( ch ); x++ )
+        pppPel[ch][y][x] = rand() % ( maxval + 1 );
+}
+
+class FrameBufferTest : public ::testing::TestWithParam<unsigned int>
+{
+};
+
+TEST_P( FrameBufferTest, PackUnpackRoundTrip )
+{
+  unsigned int bits = GetParam();
+  srand( bits );
+  for( int fmt = 0; fmt < CalypFrame::numberOfFormats(); fmt++ )
+  {
+    for( int endianness : { CLP_BIG_ENDIAN, CLP_LITTLE_ENDIAN } )
+    {
+      SCOPED_TRACE( CalypFrame::supportedPixelFormatListNames()[fmt] + " " + std::to_string( bits ) + " bits endianness " +
+                    std::to_string( endianness ) );
+      CalypFrame cFrame( 36, 20, fmt, bits );
+      fillFrame( cFrame );
+      unsigned long uiBytes = cFrame.getBytesPerFrame();
+
+      // Every byte of the buffer is written
+      std::vector<ClpByte> aBuffer( uiBytes, 0x00 );
+      std::vector<ClpByte> aCheck( uiBytes, 0xff );
+      cFrame.frameToBuffer( aBuffer.data(), endianness );
+      cFrame.frameToBuffer( aCheck.data(), endianness );
+      ASSERT_EQ( aBuffer, aCheck );
+
+      CalypFrame cRead( 36, 20, fmt, bits );
+      cRead.frameFromBuffer( aBuffer.data(), endianness );
+      ClpPel*** pppOriginal = static_cast<const CalypFrame&>( cFrame ).getPelBufferYUV();
+      ClpPel*** pppResult = static_cast<const CalypFrame&>( cRead ).getPelBufferYUV();
+      for( unsigned int ch = 0; ch < cFrame.getNumberChannels(); ch++ )
+        for( unsigned int y = 0; y < cFrame.getHeight( ch ); y++ )
+          for( unsigned int x = 0; x < cFrame.getWidth( ch ); x++ )
+            ASSERT_EQ( pppOriginal[ch][y][x], pppResult[ch][y][x] ) << "ch " << ch << " x " << x << " y " << y;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P( Bits, FrameBufferTest, ::testing::Values( 8u, 10u, 16u ) );
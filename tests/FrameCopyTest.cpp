@@ -0,0 +1,145 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FrameCopyTest.cpp
+ * \brief    Copy and move semantics of frames
+ */
+
+#include "lib/CalypFrame.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+static void fillFrame( CalypFrame& frame, ClpPel base )
+{
+  ClpPel*** pppPel = frame.getPelBufferYUV();
+  for( unsigned int ch = 0; ch < frame.getNumberChannels(); ch++ )
+    for( unsigned int y = 0; y < frame.getHeight( ch ); y++ )
+      for( unsigned int x = 0; x < frame.getWidth( ch ); x++ )
+        pppPel[ch][y][x] = ( base + ch * 31 + y * 7 + x ) & 0xff;
+}
+
+static void expectFrame( const CalypFrame& frame, ClpPel base, unsigned int offX = 0, unsigned int offY = 0 )
+{
+  ClpPel*** pppPel = frame.getPelBufferYUV();
+  for( unsigned int ch = 0; ch < frame.getNumberChannels(); ch++ )
+  {
+    unsigned int chX = ch > 0 ? offX >> frame.getChromaWidthRatio() : offX;
+    unsigned int chY = ch > 0 ? offY >> frame.getChromaHeightRatio() : offY;
+    for( unsigned int y = 0; y < frame.getHeight( ch ); y++ )
+      for( unsigned int x = 0; x < frame.getWidth( ch ); x++ )
+        ASSERT_EQ( pppPel[ch][y][x], ( base + ch * 31 + ( y + chY ) * 7 + x + chX ) & 0xff ) << "ch " << ch << " x " << x << " y " << y;
+  }
+}
+
+TEST( FrameCopyTest, CopyAssignToMovedFrom )
+{
+  CalypFrame cA( 32, 16, CLP_YUV420P, 8 );
+  CalypFrame cB( 32, 16, CLP_YUV420P, 8 );
+  fillFrame( cA, 1 );
+  fillFrame( cB, 100 );
+
+  CalypFrame cC( std::move( cA ) );
+  cA = cB;
+  expectFrame( cA, 100 );
+  expectFrame( cC, 1 );
+
+  // The copy does not write into the planes it shares with cB
+  fillFrame( cA, 50 );
+  expectFrame( cB, 100 );
+}
+
+TEST( FrameCopyTest, MoveAssignLiveFrames )
+{
+  CalypFrame cA( 32, 16, CLP_YUV420P, 8 );
+  CalypFrame cB( 32, 16, CLP_YUV420P, 8 );
+  fillFrame( cA, 1 );
+  fillFrame( cB, 100 );
+  CalypFrame cView( cA, 8, 4, 16, 8, CalypFrame::REGION_VIEW );
+  expectFrame( cView, 1, 8, 4 );
+
+  cA = std::move( cB );
+  expectFrame( cA, 100 );
+
+  // The views of the frame that was replaced now show the new samples
+  ASSERT_TRUE( cView.isView() );
+  expectFrame( cView, 100, 8, 4 );
+
+  // And the moved-from frame can be assigned again
+  CalypFrame cD( 32, 16, CLP_YUV420P, 8 );
+  fillFrame( cD, 7 );
+  cB = cD;
+  expectFrame( cB, 7 );
+  cB = std::move( cD );
+  expectFrame( cB, 7 );
+}
+
+TEST( FrameCopyTest, PackedCopyOfAlignedFrame )
+{
+  CalypFrame cAligned( 36, 20, CLP_YUV420P, 10, CalypFrame::ALIGNED_LAYOUT );
+  fillFrame( cAligned, 3 );
+  ASSERT_FALSE( cAligned.isPacked() );
+
+  CalypFrame* pcPacked = NULL;
+  CalypFrame* pcFrame = cAligned.getPacked( pcPacked );
+  ASSERT_EQ( pcFrame, pcPacked );
+  ASSERT_TRUE( pcFrame->isPacked() );
+  expectFrame( *pcFrame, 3 );
+
+  // Every plane can be walked linearly from [ch][0]
+  ClpPel*** pppPel = static_cast<const CalypFrame*>( pcFrame )->getPelBufferYUV();
+  for( unsigned int ch = 0; ch < pcFrame->getNumberChannels(); ch++ )
+    for( unsigned int i = 0; i < pcFrame->getWidth( ch ) * pcFrame->getHeight( ch ); i++ )
+    {
+      unsigned int x = i % pcFrame->getWidth( ch ), y = i / pcFrame->getWidth( ch );
+      ASSERT_EQ( pppPel[ch][0][i], ( 3 + ch * 31 + y * 7 + x ) & 0xff ) << "ch " << ch << " i " << i;
+    }
+
+  // The copy is refreshed with the new samples
+  fillFrame( cAligned, 9 );
+  ASSERT_EQ( cAligned.getPacked( pcPacked ), pcPacked );
+  expectFrame( *pcPacked, 9 );
+
+  CalypFrame cPacked( 36, 20, CLP_YUV420P, 10 );
+  ASSERT_EQ( cPacked.getPacked( pcPacked ), &cPacked );
+  delete pcPacked;
+}
+
+TEST( FrameCopyTest, ViewOfCopyOutlivesSource )
+{
+  CalypFrame* pcSource = new CalypFrame( 32, 16, CLP_YUV420P, 8 );
+  fillFrame( *pcSource, 1 );
+  CalypFrame cCopy( pcSource );
+  CalypFrame cView( cCopy, 8, 4, 16, 8, CalypFrame::REGION_VIEW );
+
+  // The source is written again and then deleted (a reused stream buffer)
+  fillFrame( *pcSource, 40 );
+  expectFrame( cView, 1, 8, 4 );
+  delete pcSource;
+  expectFrame( cView, 1, 8, 4 );
+
+  // Moving the copy to the next frame keeps the view on it
+  CalypFrame cNext( 32, 16, CLP_YUV420P, 8 );
+  fillFrame( cNext, 80 );
+  cCopy = cNext;
+  ASSERT_TRUE( cView.setViewSource( &cCopy, 8, 4 ) );
+  expectFrame( cView, 80, 8, 4 );
+}
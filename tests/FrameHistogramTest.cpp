@@ -0,0 +1,47 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FrameHistogramTest.cpp
+ * \brief    Histogram computation requests and cancellation
+ */
+
+#include "lib/CalypFrame.h"
+
+#include <gtest/gtest.h>
+
+TEST( FrameHistogramTest, CancelBeforeStart )
+{
+  CalypFrame cFrame( 64, 32, CLP_YUV420P, 8 );
+  cFrame.reset();
+
+  // Requested, then cancelled before the computation starts
+  unsigned int uiGeneration = cFrame.getHistogramGeneration();
+  cFrame.cancelHistogram();
+  EXPECT_FALSE( cFrame.calcHistogram( uiGeneration ) );
+
+  // A new request is not affected by the old cancel
+  EXPECT_TRUE( cFrame.calcHistogram( cFrame.getHistogramGeneration() ) );
+  EXPECT_EQ( cFrame.getNumPixelsRange( CalypFrame::HIST_LUMA, 0, 255 ), 64u * 32u );
+
+  // Nothing to cancel once the histogram is valid
+  uiGeneration = cFrame.getHistogramGeneration();
+  cFrame.cancelHistogram();
+  EXPECT_TRUE( cFrame.calcHistogram( uiGeneration ) );
+}
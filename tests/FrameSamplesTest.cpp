@@ -0,0 +1,142 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2018  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     FrameSamplesTest.cpp
+ * \brief    Write-back of the ClpPel planes of 8 bits frames
+ */
+
+#include "lib/CalypFrame.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+static ClpPel sampleValue( unsigned int base, unsigned int ch, unsigned int x, unsigned int y )
+{
+  return ( base + ch * 53 + y * 11 + x * 3 ) & 0xff;
+}
+
+//! Write every sample through the ClpPel accessor
+static void writePel( CalypFrame& frame, unsigned int base )
+{
+  ClpPel*** pppPel = frame.getPelBufferYUV();
+  for( unsigned int ch = 0; ch < frame.getNumberChannels(); ch++ )
+    for( unsigned int y = 0; y < frame.getHeight( ch ); y++ )
+      for( unsigned int x = 0; x < frame.getWidth( ch ); x++ )
+        pppPel[ch][y][x] = sampleValue( base, ch, x, y );
+}
+
+//! Write every sample through the byte planes
+static void writeBytes( CalypFrame& frame, unsigned int base )
+{
+  ClpByte*** pppByte = frame.getBytePelBufferYUV();
+  for( unsigned int ch = 0; ch < frame.getNumberChannels(); ch++ )
+    for( unsigned int y = 0; y < frame.getHeight( ch ); y++ )
+      for( unsigned int x = 0; x < frame.getWidth( ch ); x++ )
+        pppByte[ch][y][x] = sampleValue( base, ch, x, y );
+}
+
+static void expectBytes( const CalypFrame& frame, unsigned int base, unsigned int offX = 0, unsigned int offY = 0 )
+{
+  ClpByte*** pppByte = frame.getBytePelBufferYUV();
+  ASSERT_TRUE( pppByte != NULL );
+  for( unsigned int ch = 0; ch < frame.getNumberChannels(); ch++ )
+  {
+    unsigned int chX = ch > 0 ? offX >> frame.getChromaWidthRatio() : offX;
+    unsigned int chY = ch > 0 ? offY >> frame.getChromaHeightRatio() : offY;
+    for( unsigned int y = 0; y < frame.getHeight( ch ); y++ )
+      for( unsigned int x = 0; x < frame.getWidth( ch ); x++ )
+        ASSERT_EQ( pppByte[ch][y][x], sampleValue( base, ch, x + chX, y + chY ) ) << "ch " << ch << " x " << x << " y " << y;
+  }
+}
+
+TEST( FrameSamplesTest, PelWritesReachBytePlanes )
+{
+  CalypFrame cFrame( 40, 24, CLP_YUV420P, 8 );
+  ASSERT_EQ( cFrame.getSampleBytes(), sizeof( ClpByte ) );
+  writePel( cFrame, 1 );
+  expectBytes( cFrame, 1 );
+
+  // The pointers are taken again after the read to keep writing
+  writePel( cFrame, 2 );
+  expectBytes( cFrame, 2 );
+
+  // Out of range samples saturate
+  cFrame.getPelBufferYUV()[CLP_LUMA][0][0] = 300;
+  EXPECT_EQ( static_cast<const CalypFrame&>( cFrame ).getBytePelBufferYUV()[CLP_LUMA][0][0], 255 );
+}
+
+TEST( FrameSamplesTest, PelWritesReachSideBuffersAndCopies )
+{
+  CalypFrame cPel( 40, 24, CLP_YUV420P, 8 );
+  CalypFrame cByte( 40, 24, CLP_YUV420P, 8 );
+  writeBytes( cByte, 5 );
+  cByte.fillRGBBuffer();
+  std::vector<ClpByte> aByteBuffer( cByte.getBytesPerFrame() );
+  cByte.frameToBuffer( aByteBuffer.data(), CLP_LITTLE_ENDIAN );
+
+  // ARGB buffer filled before the write is refreshed
+  writePel( cPel, 1 );
+  cPel.fillRGBBuffer();
+  writePel( cPel, 5 );
+  cPel.fillRGBBuffer();
+  ASSERT_TRUE( cPel.getRGBBuffer() != NULL );
+  EXPECT_EQ( 0, memcmp( cPel.getRGBBuffer(), cByte.getRGBBuffer(), 40 * 24 * 4 ) );
+
+  writePel( cPel, 5 );
+  std::vector<ClpByte> aPelBuffer( cPel.getBytesPerFrame() );
+  cPel.frameToBuffer( aPelBuffer.data(), CLP_LITTLE_ENDIAN );
+  EXPECT_EQ( aPelBuffer, aByteBuffer );
+
+  writePel( cPel, 5 );
+  EXPECT_EQ( cPel.getSSD( &cByte, CLP_LUMA ), 0u );
+  writePel( cPel, 5 );
+  cPel.calcHistogram();
+  cByte.calcHistogram();
+  EXPECT_EQ( cPel.getMean( CalypFrame::HIST_LUMA, 0, 255 ), cByte.getMean( CalypFrame::HIST_LUMA, 0, 255 ) );
+
+  writePel( cPel, 7 );
+  EXPECT_EQ( cPel.getPixel( 3, 2 )[CLP_LUMA], sampleValue( 7, CLP_LUMA, 3, 2 ) );
+  writePel( cPel, 8 );
+  CalypFrame cCopy( cPel );
+  expectBytes( cCopy, 8 );
+}
+
+TEST( FrameSamplesTest, PelWritesReachViews )
+{
+  CalypFrame cFrame( 40, 24, CLP_YUV420P, 8 );
+  CalypFrame cView( cFrame, 8, 4, 16, 8, CalypFrame::REGION_VIEW );
+
+  // Written through the parent, read through the view
+  writePel( cFrame, 3 );
+  expectBytes( cView, 3, 8, 4 );
+  ClpPel*** pppViewPel = static_cast<const CalypFrame&>( cView ).getPelBufferYUV();
+  EXPECT_EQ( pppViewPel[CLP_LUMA][1][2], sampleValue( 3, CLP_LUMA, 10, 5 ) );
+
+  // Written through the view, read through the parent
+  ClpPel*** pppPel = cView.getPelBufferYUV();
+  pppPel[CLP_LUMA][1][2] = 200;
+  pppPel[CLP_CHROMA_U][1][2] = 201;
+  ClpByte*** pppByte = static_cast<const CalypFrame&>( cFrame ).getBytePelBufferYUV();
+  EXPECT_EQ( pppByte[CLP_LUMA][5][10], 200 );
+  EXPECT_EQ( pppByte[CLP_CHROMA_U][3][6], 201 );
+  EXPECT_EQ( pppByte[CLP_LUMA][5][11], sampleValue( 3, CLP_LUMA, 11, 5 ) );
+}
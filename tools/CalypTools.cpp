@@ -25,11 +25,13 @@
 #include "CalypTools.h"
 #include "config.h"
 
+#include <algorithm>
 #include <climits>
 #include <cstring>
 
 #include "lib/CalypFrame.h"
 #include "lib/CalypModuleIf.h"
+#include "lib/FramePool.h"
 #include "lib/CalypStream.h"
 #include "modules/CalypModulesFactory.h"
 
@@ -39,9 +41,12 @@ CalypTools::CalypTools()
   m_uiOperation = INVALID_OPERATION;
   m_uiNumberOfFrames = -1;
 
-  m_uiQualityMetric = -1;
-
   m_pcCurrModuleIf = NULL;
+  m_pcConvertFrame = NULL;
+  for( unsigned int i = 0; i < MAX_NUMBER_INPUTS; i++ )
+  {
+    m_apcPackedFrame[i] = NULL;
+  }
 }
 
 CalypTools::~CalypTools()
@@ -54,6 +59,11 @@ CalypTools::~CalypTools()
   {
     m_apcOutputStreams[i]->close();
   }
+  delete m_pcConvertFrame;
+  for( unsigned int i = 0; i < MAX_NUMBER_INPUTS; i++ )
+  {
+    delete m_apcPackedFrame[i];
+  }
 }
 
 #define GET_PARAM( X, i ) X[X.size() > i ? i : X.size() - 1]
@@ -99,6 +109,7 @@ int CalypTools::openInputs()
         }
       }
       pcStream = new CalypStream;
+      pcStream->setReadAhead( m_uiReadAhead );
       try
       {
         if( !pcStream->open( inputFileNames[i], resolutionString, fmtString, uiBitPerPixel, uiEndianness, 1, true ) )
@@ -243,25 +254,101 @@ int CalypTools::Open( int argc, char* argv[] )
     log( CLP_LOG_INFO, "Calyp Frame Rate Reduction\n" );
   }
 
+  /**
+   * Check Convert operation
+   */
+  if( Opts().hasOpt( "convert" ) )
+  {
+    if( m_apcInputStreams.size() != 1 )
+    {
+      log( CLP_LOG_ERROR, "Invalid number of input streams! " );
+      return 2;
+    }
+    if( !Opts().hasOpt( "output" ) )
+    {
+      log( CLP_LOG_ERROR, "One output is required! " );
+      return 2;
+    }
+    int iPelFormat = -1;
+    std::vector<ClpString> pelFormatNames = CalypFrame::supportedPixelFormatListNames();
+    for( unsigned int i = 0; i < pelFormatNames.size(); i++ )
+    {
+      if( clpLowercase( pelFormatNames[i] ) == clpLowercase( m_strConvertFmt ) )
+      {
+        iPelFormat = CalypFrame::findPixelFormat( pelFormatNames[i] );
+        break;
+      }
+    }
+    if( iPelFormat < 0 )
+    {
+      log( CLP_LOG_ERROR, "Invalid pixel format %s! ", m_strConvertFmt.c_str() );
+      return 2;
+    }
+
+    CalypFrame* pcInputFrame = m_apcInputStreams[0]->getCurrFrame();
+    unsigned int uiBitsPel = Opts().hasOpt( "convert_bits" ) ? m_uiConvertBits : pcInputFrame->getBitsPel();
+    if( uiBitsPel < 1 || uiBitsPel > 16 )
+    {
+      log( CLP_LOG_ERROR, "Invalid number of bits per pixel! " );
+      return 2;
+    }
+    m_pcConvertFrame = new CalypFrame( pcInputFrame->getWidth(), pcInputFrame->getHeight(), iPelFormat, uiBitsPel );
+
+    CalypStream* pcOutputStream = new CalypStream;
+    try
+    {
+      pcOutputStream->open( m_strOutput, m_pcConvertFrame->getWidth(), m_pcConvertFrame->getHeight(), iPelFormat,
+                            uiBitsPel, CLP_LITTLE_ENDIAN, 1, false );
+    }
+    catch( const char* msg )
+    {
+      log( CLP_LOG_ERROR, "Cannot open output stream %s with the following error %s!\n", m_strOutput.c_str(), msg );
+      delete pcOutputStream;
+      pcOutputStream = NULL;
+      return 2;
+    }
+    m_apcOutputStreams.push_back( pcOutputStream );
+
+    m_uiOperation = CONVERT_OPERATION;
+    m_fpProcess = &CalypTools::ConvertOperation;
+    log( CLP_LOG_INFO, "Calyp Convert\n" );
+  }
+
   /**
    * Check Quality operation
    */
   if( Opts().hasOpt( "quality" ) )
   {
-    ClpString qualityMetric = m_strQualityMetric;
     if( m_apcInputStreams.size() < 2 )
     {
       log( CLP_LOG_ERROR, "Invalid number of inputs! " );
       return 2;
     }
-    for( unsigned int i = 0; i < CalypFrame::supportedQualityMetricsList().size(); i++ )
+    // Comma separated list of metrics (e.g. psnr,ssim,mse)
+    ClpString qualityMetrics = m_strQualityMetric + ",";
+    size_t start = 0;
+    for( size_t end = qualityMetrics.find( ',' ); end != ClpString::npos; start = end + 1, end = qualityMetrics.find( ',', start ) )
     {
-      if( clpLowercase( CalypFrame::supportedQualityMetricsList()[i] ) == clpLowercase( qualityMetric ) )
+      ClpString qualityMetric = qualityMetrics.substr( start, end - start );
+      if( qualityMetric.empty() )
+        continue;
+      int iMetric = -1;
+      for( unsigned int i = 0; i < CalypFrame::supportedQualityMetricsList().size(); i++ )
+      {
+        if( clpLowercase( CalypFrame::supportedQualityMetricsList()[i] ) == clpLowercase( qualityMetric ) )
+        {
+          iMetric = i;
+        }
+      }
+      if( iMetric == -1 )
       {
-        m_uiQualityMetric = i;
+        log( CLP_LOG_ERROR, "Invalid quality metric %s! ", qualityMetric.c_str() );
+        return 2;
       }
+      if( std::find( m_aiQualityMetrics.begin(), m_aiQualityMetrics.end(), iMetric ) == m_aiQualityMetrics.end() )
+        m_aiQualityMetrics.push_back( iMetric );
     }
-    if( m_uiQualityMetric == -1 )
+    if( m_aiQualityMetrics.empty() )
     {
       log( CLP_LOG_ERROR, "Invalid quality metric! " );
       return 2;
@@ -307,7 +394,7 @@ int CalypTools::Open( int argc, char* argv[] )
     std::vector<CalypFrame*> apcFrameList;
     for( unsigned int i = 0; i < m_pcCurrModuleIf->m_uiNumberOfFrames; i++ )
     {
-      apcFrameList.push_back( m_apcInputStreams[i]->getCurrFrame() );
+      apcFrameList.push_back( getModuleFrame( i ) );
     }
     if( m_pcCurrModuleIf->m_iModuleAPI == CLP_MODULE_API_2 )
     {
@@ -315,7 +402,7 @@ int CalypTools::Open( int argc, char* argv[] )
     }
     else if( m_pcCurrModuleIf->m_iModuleAPI == CLP_MODULE_API_1 )
     {
-      m_pcCurrModuleIf->create( m_apcInputStreams[0]->getCurrFrame() );
+      m_pcCurrModuleIf->create( getModuleFrame( 0 ) );
       moduleCreated = true;
     }
     if( !moduleCreated )
@@ -386,6 +473,12 @@ int CalypTools::Process()
 int CalypTools::Close()
 {
   // Finish
+  if( Opts().hasOpt( "pool_stats" ) )
+  {
+    CalypFramePoolStats sStats = CalypFramePool::global()->getStats();
+    log( CLP_LOG_INFO, "\n  Frame pool: %llu allocations, %llu reuses, peak %.2f MB in use, %.2f MB cached\n",
+         sStats.ullAllocations, sStats.ullReuses, sStats.uiPeakBytesInUse / 1048576.0, sStats.uiBytesCached / 1048576.0 );
+  }
   return 0;
 }
 
@@ -425,42 +518,77 @@ int CalypTools::RateReductionOperation()
   return 0;
 }
 
+int CalypTools::ConvertOperation()
+{
+  log( CLP_LOG_INFO, "\n Converting to %s %d bits ... ", m_pcConvertFrame->getPelFmtName().c_str(),
+       m_pcConvertFrame->getBitsPel() );
+  for( unsigned int frame = 0; frame < m_uiNumberOfFrames; frame++ )
+  {
+    if( !m_pcConvertFrame->convertFrom( m_apcInputStreams[0]->getCurrFrame() ) )
+    {
+      log( CLP_LOG_ERROR, "Cannot convert frame %d! ", frame );
+      return 2;
+    }
+    m_apcOutputStreams[0]->writeFrame( m_pcConvertFrame );
+    if( !m_apcInputStreams[0]->setNextFrame() )
+    {
+      m_apcInputStreams[0]->readNextFrame();
+    }
+  }
+  return 0;
+}
+
 int CalypTools::QualityOperation()
 {
-  const char* pchQualityMetricName = CalypFrame::supportedQualityMetricsList()[m_uiQualityMetric].c_str();
   CalypFrame* apcCurrFrame[MAX_NUMBER_INPUTS];
   bool abEOF[MAX_NUMBER_INPUTS];
-  double adAverageQuality[MAX_NUMBER_INPUTS - 1][MAX_NUMBER_CHANNELS];
+  double adAverageQuality[MAX_NUMBER_INPUTS - 1][CalypFrame::NUMBER_METRICS][MAX_NUMBER_CHANNELS];
   double dQuality;
 
-  ClpString metric_fmt = " ";
-  switch( m_uiQualityMetric )
+  ClpString metricNames;
+  std::vector<ClpString> metric_fmt( CalypFrame::NUMBER_METRICS );
+  for( unsigned int m = 0; m < m_aiQualityMetrics.size(); m++ )
   {
-  case CalypFrame::PSNR_METRIC:
-    //"PSNR_0_0"
-    metric_fmt += " %6.3f ";
-    break;
-  case CalypFrame::SSIM_METRIC:
-    //"SSIM_0_0"
-    metric_fmt += " %6.4f ";
-    break;
-  case CalypFrame::MSE_METRIC:
-    //"MSE_0_0"
-    metric_fmt += "%7.2f";
-    break;
-  default:
-    metric_fmt += " %6.3f ";
+    int iMetric = m_aiQualityMetrics[m];
+    metric_fmt[iMetric] = " ";
+    switch( iMetric )
+    {
+    case CalypFrame::PSNR_METRIC:
+      //"PSNR_0_0"
+      metric_fmt[iMetric] += " %6.3f ";
+      break;
+    case CalypFrame::SSIM_METRIC:
+      //"SSIM_0_0"
+      metric_fmt[iMetric] += " %6.4f ";
+      break;
+    case CalypFrame::MSE_METRIC:
+      //"MSE_0_0"
+      metric_fmt[iMetric] += "%7.2f";
+      break;
+    default:
+      metric_fmt[iMetric] += " %6.3f ";
+    }
+    metric_fmt[iMetric] += " ";
+    metricNames += ( m > 0 ? ", " : "" ) + CalypFrame::supportedQualityMetricsList()[iMetric];
   }
-  metric_fmt += " ";
 
-  log( CLP_LOG_INFO, "  Measuring Quality using %s ... \n", pchQualityMetricName );
-  log( CLP_LOG_INFO, "# Frame   ", pchQualityMetricName );
+  std::vector<unsigned int> auiComponents;
+  for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+    auiComponents.push_back( c );
+  CalypFrame::QualityResult cResult;
+
+  log( CLP_LOG_INFO, "  Measuring Quality using %s ... \n", metricNames.c_str() );
+  log( CLP_LOG_INFO, "# Frame   " );
 
   for( unsigned int s = 1; s < m_apcInputStreams.size(); s++ )
   {
-    for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+    for( unsigned int m = 0; m < m_aiQualityMetrics.size(); m++ )
     {
-      log( CLP_LOG_INFO, "%s_%d_%d  ", pchQualityMetricName, s, c );
+      const char* pchQualityMetricName = CalypFrame::supportedQualityMetricsList()[m_aiQualityMetrics[m]].c_str();
+      for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+      {
+        log( CLP_LOG_INFO, "%s_%d_%d  ", pchQualityMetricName, s, c );
+      }
     }
     log( CLP_LOG_INFO, "   " );
   }
@@ -470,9 +598,15 @@ int CalypTools::QualityOperation()
   for( unsigned int s = 0; s < m_apcInputStreams.size(); s++ )
   {
     abEOF[s] = false;
-    for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+  }
+  for( unsigned int s = 0; s < m_apcInputStreams.size() - 1; s++ )
+  {
+    for( unsigned int m = 0; m < CalypFrame::NUMBER_METRICS; m++ )
     {
-      adAverageQuality[s][c] = 0;
+      for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+      {
+        adAverageQuality[s][m][c] = 0;
+      }
     }
   }
   for( unsigned int frame = 0; frame < m_uiNumberOfFrames; frame++ )
@@ -484,15 +618,23 @@ int CalypTools::QualityOperation()
     for( unsigned int s = 1; s < m_apcInputStreams.size(); s++ )
     {
       log( CLP_LOG_RESULT, "  " );
-      for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+      apcCurrFrame[s]->getQuality( m_aiQualityMetrics, auiComponents, apcCurrFrame[0], cResult );
+      for( unsigned int m = 0; m < m_aiQualityMetrics.size(); m++ )
       {
-        dQuality = apcCurrFrame[s]->getQuality( m_uiQualityMetric, apcCurrFrame[0], c );
-        adAverageQuality[s - 1][c] = ( adAverageQuality[s - 1][c] * double( frame ) + dQuality ) / double( frame + 1 );
-        log( CLP_LOG_RESULT, metric_fmt.c_str(), dQuality );
+        int iMetric = m_aiQualityMetrics[m];
+        for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+        {
+          dQuality = cResult.adQuality[iMetric][c];
+          adAverageQuality[s - 1][iMetric][c] =
+              ( adAverageQuality[s - 1][iMetric][c] * double( frame ) + dQuality ) / double( frame + 1 );
+          log( CLP_LOG_RESULT, metric_fmt[iMetric].c_str(), dQuality );
+        }
       }
       log( CLP_LOG_RESULT, " " );
     }
     log( CLP_LOG_RESULT, "\n" );
+    // Read ahead of every input in one go
+    CalypStream::beginReadBatch();
     for( unsigned int s = 0; s < m_apcInputStreams.size(); s++ )
     {
       abEOF[s] = m_apcInputStreams[s]->setNextFrame();
@@ -501,13 +643,18 @@ int CalypTools::QualityOperation()
         m_apcInputStreams[s]->readNextFrame();
       }
     }
+    CalypStream::endReadBatch();
   }
   log( CLP_LOG_INFO, "\n  Mean Values: \n         " );
   for( unsigned int s = 0; s < m_apcInputStreams.size() - 1; s++ )
   {
-    for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+    for( unsigned int m = 0; m < m_aiQualityMetrics.size(); m++ )
     {
-      log( CLP_LOG_INFO, metric_fmt.c_str(), adAverageQuality[s][c] );
+      int iMetric = m_aiQualityMetrics[m];
+      for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+      {
+        log( CLP_LOG_INFO, metric_fmt[iMetric].c_str(), adAverageQuality[s][iMetric][c] );
+      }
     }
     log( CLP_LOG_RESULT, "   " );
   }
@@ -515,12 +662,24 @@ int CalypTools::QualityOperation()
   return 0;
 }
 
+/**
+ * Current frame of the i-th input as the module reads it: modules that
+ * walk the planes linearly from [ch][0] get a packed copy
+ */
+CalypFrame* CalypTools::getModuleFrame( unsigned int i )
+{
+  CalypFrame* pcFrame = m_apcInputStreams[i]->getCurrFrame();
+  if( pcFrame && !( m_pcCurrModuleIf->m_uiModuleRequirements & CLP_MODULE_USES_STRIDE ) )
+    pcFrame = pcFrame->getPacked( m_apcPackedFrame[i] );
+  return pcFrame;
+}
+
 CalypFrame* CalypTools::applyFrameModule()
 {
   CalypFrame* pcProcessedFrame = NULL;
   if( m_pcCurrModuleIf->m_iModuleType == CLP_FRAME_PROCESSING_MODULE )
   {
-    pcProcessedFrame = m_pcCurrModuleIf->process( m_apcInputStreams[0]->getCurrFrame() );
+    pcProcessedFrame = m_pcCurrModuleIf->process( getModuleFrame( 0 ) );
   }
   return pcProcessedFrame;
 }
@@ -546,7 +705,7 @@ int CalypTools::ModuleOperation()
     apcFrameList.clear();
     for( unsigned int i = 0; i < m_pcCurrModuleIf->m_uiNumberOfFrames; i++ )
     {
-      apcFrameList.push_back( m_apcInputStreams[i]->getCurrFrame() );
+      apcFrameList.push_back( getModuleFrame( i ) );
     }
     if( m_pcCurrModuleIf->m_iModuleType == CLP_FRAME_PROCESSING_MODULE )
     {
@@ -568,7 +727,7 @@ int CalypTools::ModuleOperation()
       }
       else
       {
-        dMeasurementResult = m_pcCurrModuleIf->measure( m_apcInputStreams[0]->getCurrFrame() );
+        dMeasurementResult = m_pcCurrModuleIf->measure( getModuleFrame( 0 ) );
       }
       log( CLP_LOG_INFO, "   %3d", frame );
       log( CLP_LOG_RESULT, "  %8.3f \n", dMeasurementResult );
@@ -576,6 +735,8 @@ int CalypTools::ModuleOperation()
           ( dAveragedMeasurementResult * double( frame ) + dMeasurementResult ) / double( frame + 1 );
     }
 
+    // Read ahead of every input in one go
+    CalypStream::beginReadBatch();
     for( unsigned int s = 0; s < m_apcInputStreams.size(); s++ )
     {
       abEOF[s] = m_apcInputStreams[s]->setNextFrame();
@@ -584,6 +745,7 @@ int CalypTools::ModuleOperation()
         m_apcInputStreams[s]->readNextFrame();
       }
     }
+    CalypStream::endReadBatch();
   }
 
   if( m_pcCurrModuleIf->m_iModuleType == CLP_FRAME_MEASUREMENT_MODULE )
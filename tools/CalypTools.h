@@ -74,6 +74,7 @@ private:
     INVALID_OPERATION,
     SAVE_OPERATION,
     RATE_REDUCTION_OPERATION,
+    CONVERT_OPERATION,
     QUALITY_OPERATION,
     MODULE_OPERATION,
   };
@@ -94,10 +95,16 @@ private:
 
   int RateReductionOperation();
 
-  int m_uiQualityMetric;
+  CalypFrame* m_pcConvertFrame;
+  int ConvertOperation();
+
+  std::vector<int> m_aiQualityMetrics;
   int QualityOperation();
 
   CalypModuleIf* m_pcCurrModuleIf;
+  //! Packed copies of the inputs for modules without CLP_MODULE_USES_STRIDE
+  CalypFrame* m_apcPackedFrame[MAX_NUMBER_INPUTS];
+  CalypFrame* getModuleFrame( unsigned int i );
   CalypFrame* applyFrameModule();
   int ModuleOperation();
 };
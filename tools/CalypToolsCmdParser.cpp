@@ -38,6 +38,8 @@ CalypToolsCmdParser::CalypToolsCmdParser()
   m_uiLogLevel = 0;
   m_bQuiet = false;
   m_iFrames = -1;
+  m_uiReadAhead = 4;
+  m_uiConvertBits = 0;
 
   m_cOptions.addDefaultOptions();
 }
@@ -67,10 +69,14 @@ int CalypToolsCmdParser::parseToolsArgs( int argc, char* argv[] )
       ( "bits_pel", m_uiBitsPerPixel, "bits per pixel" )                                 /**/
       ( "endianness", m_strEndianness, "File endianness (big, little)" )                 /**/
       ( "frames,f", m_iFrames, "number of frames to parse" )                             /**/
-      ( "quality", m_strQualityMetric, "select a quality metric" )                       /**/
+      ( "read_ahead", m_uiReadAhead, "frames read in background (0 disables)" )          /**/
+      ( "quality", m_strQualityMetric, "select quality metrics (e.g. psnr,ssim,mse)" )   /**/
       ( "module", m_strModule, "select a module (use internal name)" )                   /**/
       ( "save", "save a specific frame" )                                                /**/
-      ( "rate-reduction", m_iRateReductionFactor, "reduce the frame rate" );             /**/
+      ( "rate-reduction", m_iRateReductionFactor, "reduce the frame rate" )              /**/
+      ( "convert", m_strConvertFmt, "convert to a pixel format (e.g. yuv444p)" )         /**/
+      ( "convert_bits", m_uiConvertBits, "bits per pixel of the converted output" )      /**/
+      ( "pool_stats", "print frame buffer pool statistics at exit" );                   /**/
 
   if( !m_cOptions.parse( argc, argv ) )
   {
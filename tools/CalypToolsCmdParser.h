@@ -71,8 +71,11 @@ protected:
   std::vector<ClpString> m_strEndianness;
   ClpString m_strOutput;
   long m_iFrames;
+  unsigned int m_uiReadAhead;
 
   int m_iRateReductionFactor;
+  ClpString m_strConvertFmt;
+  unsigned int m_uiConvertBits;
   ClpString m_strQualityMetric;
   ClpString m_strModule;
 